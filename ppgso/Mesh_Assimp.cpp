@@ -1,13 +1,22 @@
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <sstream>
 
 #include "Mesh_Assimp.h"
+#include "render_state.h"
+#include "mesh_optimizer.h"
 
-ppgso::Mesh_Assimp::Mesh_Assimp(const std::string &obj_file) {
+ppgso::Mesh_Assimp::Mesh_Assimp(const std::string &obj_file, int lodLevels) : lodLevels{lodLevels} {
 #ifdef DEBBUG_MODE
     std::cout << "Using ASSIMP Loader!" << std::endl;
 #endif
 
+    if (Mesh_Gltf::isGltf(obj_file)) {
+        gltf = std::make_unique<Mesh_Gltf>(obj_file, lodLevels);
+        return;
+    }
+
+    file = obj_file;
     Assimp::Importer importer;
     scene = importer.ReadFile(obj_file, aiProcess_Triangulate | aiProcess_FlipUVs);
 
@@ -45,6 +54,7 @@ ppgso::Mesh_Assimp::~Mesh_Assimp() {
         glDeleteBuffers(1, &buffer.nbo);
         glDeleteBuffers(1, &buffer.tbo);
         glDeleteBuffers(1, &buffer.vbo);
+        RenderState::forgetVertexArray(buffer.vao);
         glDeleteVertexArrays(1, &buffer.vao);
     }
 }
@@ -63,32 +73,75 @@ void ppgso::Mesh_Assimp::processNode(aiNode *node, const aiScene *pScene) {
 void ppgso::Mesh_Assimp::processMesh(aiMesh *mesh) {
     gl_buffer buffer;
 
+    // Gather indices first, the optimizer reorders them together with the vertices
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; ++j) {
+            indices.push_back(face.mIndices[j]);
+        }
+    }
+
+    std::vector<aiVector3D> positions(mesh->mVertices, mesh->mVertices + (mesh->HasPositions() ? mesh->mNumVertices : 0));
+    std::vector<aiVector2D> textureCoords;
+    if (mesh->HasTextureCoords(0)) {
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+            aiVector3D texCoord = mesh->mTextureCoords[0][i]; // Assuming single texture channel (index 0)
+            textureCoords.push_back(aiVector2D(texCoord.x, texCoord.y));
+        }
+    }
+    std::vector<aiVector3D> normals;
+    if (mesh->HasNormals()) {
+        normals.assign(mesh->mNormals, mesh->mNormals + mesh->mNumVertices);
+    }
+
+    // Only pure triangle lists, point and line primitives survive aiProcess_Triangulate
+    if (MeshOptimizer::isEnabled() && !positions.empty() && indices.size() == mesh->mNumFaces * 3) {
+        std::stringstream name;
+        name << file << " #" << buffers.size();
+        auto remap = MeshOptimizer::optimize(name.str(), indices, positions.size(), positions.data(), sizeof(aiVector3D));
+        MeshOptimizer::remapVertices(positions.data(), remap, sizeof(aiVector3D), sizeof(aiVector3D));
+        if (!textureCoords.empty())
+            MeshOptimizer::remapVertices(textureCoords.data(), remap, sizeof(aiVector2D), sizeof(aiVector2D));
+        if (!normals.empty())
+            MeshOptimizer::remapVertices(normals.data(), remap, sizeof(aiVector3D), sizeof(aiVector3D));
+    }
+
+    // Coarser levels share the vertices, their indices follow the full detail ones in the index buffer
+    buffer.size = static_cast<GLsizei>(indices.size());
+    buffer.lods.push_back({0, buffer.size});
+    if (lodLevels > 1 && !positions.empty() && indices.size() == mesh->mNumFaces * 3) {
+        for (auto &lod : MeshOptimizer::generateLods(indices, positions.size(), positions.data(), sizeof(aiVector3D), lodLevels)) {
+            buffer.lods.push_back({indices.size() * sizeof(unsigned int), static_cast<GLsizei>(lod.size())});
+            indices.insert(indices.end(), lod.begin(), lod.end());
+        }
+    }
+    for (auto &position : positions) {
+        radius = std::max(radius, position.Length());
+    }
+
     // Process vertices
-    if (mesh->HasPositions()) {
+    if (!positions.empty()) {
         // Generate a vertex array object
         glGenVertexArrays(1, &buffer.vao);
-        glBindVertexArray(buffer.vao);
+        RenderState::bindVertexArray(buffer.vao);
 
-        // Extract vertex positions from aiMesh and upload to GPU
+        // Upload vertex positions to GPU
         glGenBuffers(1, &buffer.vbo);
         glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
-        glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mVertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(aiVector3D), positions.data(), GL_STATIC_DRAW);
+        byteSize += positions.size() * sizeof(aiVector3D);
         // Enable and set up vertex attribute pointer for positions
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
     }
 
     // Process texture coordinates
-    if (mesh->HasTextureCoords(0)) {
-        std::vector<aiVector2D> textureCoords;
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            aiVector3D texCoord = mesh->mTextureCoords[0][i]; // Assuming single texture channel (index 0)
-            textureCoords.push_back(aiVector2D(texCoord.x, texCoord.y));
-        }
-
+    if (!textureCoords.empty()) {
         glGenBuffers(1, &buffer.tbo);
         glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
         glBufferData(GL_ARRAY_BUFFER, textureCoords.size() * sizeof(aiVector2D), textureCoords.data(), GL_STATIC_DRAW);
+        byteSize += textureCoords.size() * sizeof(aiVector2D);
 
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -96,16 +149,11 @@ void ppgso::Mesh_Assimp::processMesh(aiMesh *mesh) {
 
 
     // Process normals
-    if (mesh->HasNormals()) {
-        std::vector<aiVector3D> normals;
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            aiVector3D normal = mesh->mNormals[i];
-            normals.push_back(normal);
-        }
-
+    if (!normals.empty()) {
         glGenBuffers(1, &buffer.nbo);
         glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
         glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(aiVector3D), normals.data(), GL_STATIC_DRAW);
+        byteSize += normals.size() * sizeof(aiVector3D);
 
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -113,29 +161,70 @@ void ppgso::Mesh_Assimp::processMesh(aiMesh *mesh) {
 
 
     // Process indices
-    if (mesh->HasFaces()) {
-        std::vector<unsigned int> indices;
-        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            aiFace face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-                indices.push_back(face.mIndices[j]);
-            }
-        }
-
+    if (!indices.empty()) {
         // Upload indices to GPU
         glGenBuffers(1, &buffer.ibo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-        buffer.size = static_cast<GLsizei>(indices.size());
+        byteSize += indices.size() * sizeof(unsigned int);
     }
 
     buffers.push_back(buffer);
 }
 
 void ppgso::Mesh_Assimp::render() {
+    render(0);
+}
+
+void ppgso::Mesh_Assimp::render(size_t lod) {
+    if (gltf) return gltf->render(lod);
+    for (auto &buffer : buffers) {
+        // Draw object, meshes with fewer levels use their coarsest one
+        auto &range = buffer.lods[std::min(lod, buffer.lods.size() - 1)];
+        RenderState::bindVertexArray(buffer.vao);
+        glDrawElements(GL_TRIANGLES, range.size, GL_UNSIGNED_INT, (const void *) range.offset);
+        RenderState::countDraw(static_cast<size_t>(range.size) / 3);
+    }
+}
+
+size_t ppgso::Mesh_Assimp::getLodCount() const {
+    if (gltf) return gltf->getLodCount();
+    size_t count = 1;
     for (auto &buffer : buffers) {
-        // Draw object
-        glBindVertexArray(buffer.vao);
-        glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+        count = std::max(count, buffer.lods.size());
+    }
+    return count;
+}
+
+size_t ppgso::Mesh_Assimp::getTriangleCount(size_t lod) const {
+    if (gltf) return gltf->getTriangleCount(lod);
+    size_t triangles = 0;
+    for (auto &buffer : buffers) {
+        triangles += static_cast<size_t>(buffer.lods[std::min(lod, buffer.lods.size() - 1)].size) / 3;
+    }
+    return triangles;
+}
+
+float ppgso::Mesh_Assimp::getRadius() const {
+    if (gltf) return gltf->getRadius();
+    return radius;
+}
+
+size_t ppgso::Mesh_Assimp::getByteSize() const {
+    if (gltf) return gltf->getByteSize();
+    return byteSize;
+}
+
+std::vector<ppgso::MeshPart> ppgso::Mesh_Assimp::getParts() const {
+    if (gltf) return gltf->getParts();
+    std::vector<MeshPart> parts;
+    for (auto &buffer : buffers) {
+        MeshPart part;
+        part.vao = buffer.vao;
+        for (auto &lod : buffer.lods) {
+            part.lods.push_back({lod.offset, lod.size});
+        }
+        parts.push_back(part);
     }
+    return parts;
 }
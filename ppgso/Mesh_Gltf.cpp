@@ -0,0 +1,760 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Mesh_Gltf.h"
+#include "mapped_file.h"
+#include "render_state.h"
+#include "mesh_optimizer.h"
+
+namespace {
+  /*!
+   * Minimal JSON value, enough for the glTF document structure
+   * Objects keep their members in file order, glTF objects are small enough for a linear lookup
+   */
+  struct Json {
+    enum class Type { Null, Boolean, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    static const Json &null() {
+      static const Json value;
+      return value;
+    }
+
+    const Json &operator[](const std::string &key) const {
+      for (auto &member : members)
+        if (member.first == key) return member.second;
+      return null();
+    }
+
+    const Json &operator[](size_t index) const {
+      return index < items.size() ? items[index] : null();
+    }
+
+    bool has(const std::string &key) const {
+      return (*this)[key].type != Type::Null;
+    }
+
+    size_t size() const {
+      return items.size();
+    }
+
+    double asNumber(double fallback) const {
+      return type == Type::Number ? number : fallback;
+    }
+
+    int asInt(int fallback) const {
+      return type == Type::Number ? (int) number : fallback;
+    }
+
+    bool asBool(bool fallback) const {
+      return type == Type::Boolean ? boolean : fallback;
+    }
+  };
+
+  /*!
+   * Recursive descent parser over the mapped file, the text does not need to be null terminated
+   */
+  class JsonParser {
+  public:
+    JsonParser(const char *begin, const char *end) : begin{begin}, current{begin}, end{end} {}
+
+    Json parse() {
+      auto value = parseValue();
+      skipSpace();
+      if (current != end) fail("trailing characters");
+      return value;
+    }
+
+  private:
+    void fail(const char *reason) const {
+      std::stringstream msg;
+      msg << "Invalid JSON at offset " << current - begin << ", " << reason;
+      throw std::runtime_error(msg.str());
+    }
+
+    void skipSpace() {
+      while (current != end && std::isspace((unsigned char) *current)) current++;
+    }
+
+    bool consume(char character) {
+      skipSpace();
+      if (current == end || *current != character) return false;
+      current++;
+      return true;
+    }
+
+    void expect(char character) {
+      if (!consume(character)) {
+        std::string reason = "expected '";
+        fail((reason + character + "'").c_str());
+      }
+    }
+
+    void literal(const char *text) {
+      auto length = std::strlen(text);
+      if ((size_t) (end - current) < length || std::strncmp(current, text, length) != 0) fail("unknown literal");
+      current += length;
+    }
+
+    Json parseValue() {
+      skipSpace();
+      if (current == end) fail("unexpected end of file");
+
+      Json value;
+      switch (*current) {
+        case '{':
+          current++;
+          value.type = Json::Type::Object;
+          if (consume('}')) return value;
+          do {
+            skipSpace();
+            auto key = parseString();
+            expect(':');
+            value.members.emplace_back(std::move(key), parseValue());
+          } while (consume(','));
+          expect('}');
+          return value;
+        case '[':
+          current++;
+          value.type = Json::Type::Array;
+          if (consume(']')) return value;
+          do {
+            value.items.push_back(parseValue());
+          } while (consume(','));
+          expect(']');
+          return value;
+        case '"':
+          value.type = Json::Type::String;
+          value.string = parseString();
+          return value;
+        case 't':
+          literal("true");
+          value.type = Json::Type::Boolean;
+          value.boolean = true;
+          return value;
+        case 'f':
+          literal("false");
+          value.type = Json::Type::Boolean;
+          return value;
+        case 'n':
+          literal("null");
+          return value;
+        default:
+          value.type = Json::Type::Number;
+          value.number = parseNumber();
+          return value;
+      }
+    }
+
+    double parseNumber() {
+      // strtod needs a terminated copy, numbers are short
+      auto start = current;
+      while (current != end && (std::isdigit((unsigned char) *current) || std::strchr("+-.eE", *current))) current++;
+      std::string text{start, current};
+      char *parsed = nullptr;
+      auto number = std::strtod(text.c_str(), &parsed);
+      if (text.empty() || parsed != text.c_str() + text.size()) fail("invalid number");
+      return number;
+    }
+
+    unsigned hexDigits() {
+      if (end - current < 4) fail("truncated escape");
+      unsigned code = 0;
+      for (int i = 0; i < 4; i++) {
+        auto digit = *current++;
+        code <<= 4;
+        if (digit >= '0' && digit <= '9') code |= (unsigned) (digit - '0');
+        else if (digit >= 'a' && digit <= 'f') code |= (unsigned) (digit - 'a' + 10);
+        else if (digit >= 'A' && digit <= 'F') code |= (unsigned) (digit - 'A' + 10);
+        else fail("invalid escape");
+      }
+      return code;
+    }
+
+    static void appendUtf8(std::string &text, unsigned code) {
+      if (code < 0x80) {
+        text += (char) code;
+      } else if (code < 0x800) {
+        text += (char) (0xC0 | (code >> 6));
+        text += (char) (0x80 | (code & 0x3F));
+      } else if (code < 0x10000) {
+        text += (char) (0xE0 | (code >> 12));
+        text += (char) (0x80 | ((code >> 6) & 0x3F));
+        text += (char) (0x80 | (code & 0x3F));
+      } else {
+        text += (char) (0xF0 | (code >> 18));
+        text += (char) (0x80 | ((code >> 12) & 0x3F));
+        text += (char) (0x80 | ((code >> 6) & 0x3F));
+        text += (char) (0x80 | (code & 0x3F));
+      }
+    }
+
+    std::string parseString() {
+      if (current == end || *current != '"') fail("expected string");
+      current++;
+
+      std::string text;
+      while (current != end && *current != '"') {
+        auto character = *current++;
+        if (character != '\\') {
+          text += character;
+          continue;
+        }
+        if (current == end) break;
+        switch (*current++) {
+          case '"': text += '"'; break;
+          case '\\': text += '\\'; break;
+          case '/': text += '/'; break;
+          case 'b': text += '\b'; break;
+          case 'f': text += '\f'; break;
+          case 'n': text += '\n'; break;
+          case 'r': text += '\r'; break;
+          case 't': text += '\t'; break;
+          case 'u': {
+            auto code = hexDigits();
+            // Characters outside the basic plane come as a surrogate pair
+            if (code >= 0xD800 && code < 0xDC00 && end - current >= 6 && current[0] == '\\' && current[1] == 'u') {
+              current += 2;
+              auto low = hexDigits();
+              code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(text, code);
+            break;
+          }
+          default:
+            fail("invalid escape");
+        }
+      }
+      if (current == end) fail("unterminated string");
+      current++;
+      return text;
+    }
+
+    const char *begin, *current, *end;
+  };
+
+  // Attribute locations shared with Mesh_Tiny and Mesh_Assimp
+  const std::pair<const char *, GLuint> ATTRIBUTES[] = {{"POSITION", 0}, {"TEXCOORD_0", 1}, {"NORMAL", 2}};
+
+  const GLenum FLOAT_COMPONENT = 5126;
+
+  GLint componentCount(const std::string &type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+  }
+
+  size_t componentSize(GLenum type) {
+    switch (type) {
+      case GL_BYTE:
+      case GL_UNSIGNED_BYTE: return 1;
+      case GL_SHORT:
+      case GL_UNSIGNED_SHORT: return 2;
+      case GL_UNSIGNED_INT:
+      case GL_FLOAT: return 4;
+      default: return 0;
+    }
+  }
+
+  std::string directoryOf(const std::string &path) {
+    auto slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  }
+
+  /*!
+   * glTF URIs are percent encoded, files with spaces in their names appear as %20
+   */
+  std::string decodeUri(const std::string &uri) {
+    std::string path;
+    for (size_t i = 0; i < uri.size(); i++) {
+      if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit((unsigned char) uri[i + 1]) &&
+          std::isxdigit((unsigned char) uri[i + 2])) {
+        path += (char) std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+        i += 2;
+      } else {
+        path += uri[i];
+      }
+    }
+    return path;
+  }
+
+  glm::mat4 nodeTransform(const Json &node) {
+    if (node.has("matrix")) {
+      // Stored column major like glm
+      float matrix[16];
+      for (size_t i = 0; i < 16; i++) matrix[i] = (float) node["matrix"][i].asNumber(i % 5 == 0 ? 1.0 : 0.0);
+      return glm::make_mat4(matrix);
+    }
+
+    auto &t = node["translation"], &r = node["rotation"], &s = node["scale"];
+    glm::vec3 translation{t[0].asNumber(0.0), t[1].asNumber(0.0), t[2].asNumber(0.0)};
+    glm::quat rotation{(float) r[3].asNumber(1.0), (float) r[0].asNumber(0.0), (float) r[1].asNumber(0.0),
+                       (float) r[2].asNumber(0.0)};
+    glm::vec3 scale{s[0].asNumber(1.0), s[1].asNumber(1.0), s[2].asNumber(1.0)};
+    return glm::translate(glm::mat4{1.0f}, translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4{1.0f}, scale);
+  }
+
+  [[noreturn]] void invalid(const std::string &file, const std::string &reason) {
+    std::stringstream msg;
+    msg << "Failed to load glTF file " << file << ", " << reason << "!";
+    throw std::runtime_error(msg.str());
+  }
+}
+
+bool ppgso::Mesh_Gltf::isGltf(const std::string &path) {
+  const std::string extension = ".gltf";
+  if (path.size() < extension.size()) return false;
+  for (size_t i = 0; i < extension.size(); i++)
+    if (std::tolower((unsigned char) path[path.size() - extension.size() + i]) != extension[i]) return false;
+  return true;
+}
+
+ppgso::Mesh_Gltf::Mesh_Gltf(const std::string &gltf_file, int lodLevels) {
+  MappedFile file{gltf_file};
+  auto text = (const char *) file.data();
+  Json document;
+  try {
+    document = JsonParser{text, text + file.size()}.parse();
+  } catch (const std::runtime_error &error) {
+    invalid(gltf_file, error.what());
+  }
+  auto directory = directoryOf(gltf_file);
+  auto &accessors = document["accessors"];
+  auto &views = document["bufferViews"];
+  auto &meshes = document["meshes"];
+
+  // External buffers stay mapped until every bufferView is uploaded
+  std::vector<std::unique_ptr<MappedFile>> files;
+  for (size_t i = 0; i < document["buffers"].size(); i++) {
+    auto &uri = document["buffers"][i]["uri"].string;
+    if (uri.empty() || uri.compare(0, 5, "data:") == 0) invalid(gltf_file, "embedded buffers are not supported");
+    files.push_back(std::make_unique<MappedFile>(directory + decodeUri(uri)));
+  }
+
+  auto accessorView = [&](const Json &accessor) {
+    if (accessor.has("sparse") || !accessor.has("bufferView")) invalid(gltf_file, "sparse accessors are not supported");
+    auto view = (size_t) accessor["bufferView"].asInt(0);
+    if (view >= views.size()) invalid(gltf_file, "accessor references a missing bufferView");
+    return view;
+  };
+
+  // Bytes of a bufferView in its mapped buffer
+  auto viewBytes = [&](size_t index, size_t &length) {
+    auto &view = views[index];
+    auto buffer = (size_t) view["buffer"].asInt(-1);
+    auto offset = (size_t) view["byteOffset"].asNumber(0.0);
+    length = (size_t) view["byteLength"].asNumber(0.0);
+    if (buffer >= files.size() || offset + length > files[buffer]->size())
+      invalid(gltf_file, "bufferView exceeds its buffer");
+    return files[buffer]->data() + offset;
+  };
+
+  // Offset and stride of an accessor within its bufferView, checked against the view length
+  auto accessorLayout = [&](const Json &accessor, size_t elementSize, size_t &start, size_t &stride) {
+    auto view = accessorView(accessor);
+    size_t length;
+    viewBytes(view, length);
+    start = (size_t) accessor["byteOffset"].asNumber(0.0);
+    stride = (size_t) views[view]["byteStride"].asNumber((double) elementSize);
+    auto count = (size_t) accessor["count"].asNumber(0.0);
+    if (count && start + (count - 1) * stride + elementSize > length) invalid(gltf_file, "accessor exceeds its bufferView");
+    return view;
+  };
+
+  // Only bufferViews drawn from are uploaded, skins and animations stay on the CPU side.
+  // Views that have to be rewritten get a copy, patched before the upload.
+  std::vector<bool> used(views.size(), false);
+  std::vector<std::vector<std::function<void(uint8_t *)>>> patches(views.size());
+  std::vector<int> accessorUsers(accessors.size(), 0);
+  for (size_t m = 0; m < meshes.size(); m++) {
+    for (auto &primitive : meshes[m]["primitives"].items) {
+      for (auto &attribute : ATTRIBUTES) {
+        auto index = (size_t) primitive["attributes"][attribute.first].asInt(-1);
+        auto &accessor = accessors[index];
+        if (accessor.type == Json::Type::Null) continue;
+        auto first = accessorUsers[index]++ == 0;
+        used[accessorView(accessor)] = true;
+
+        // Texture coordinates go to the OBJ convention with v pointing up, flipped once however many
+        // primitives share the accessor
+        if (first && attribute.second == 1 && (GLenum) accessor["componentType"].asInt(0) == FLOAT_COMPONENT) {
+          size_t start, stride;
+          auto view = accessorLayout(accessor, 8, start, stride);
+          auto count = (size_t) accessor["count"].asNumber(0.0);
+          patches[view].push_back([start, stride, count](uint8_t *data) {
+            for (size_t v = 0; v < count; v++) {
+              float coordinate;
+              auto position = data + start + v * stride + 4;
+              std::memcpy(&coordinate, position, 4);
+              coordinate = 1.0f - coordinate;
+              std::memcpy(position, &coordinate, 4);
+            }
+          });
+        }
+      }
+      if (primitive.has("indices")) {
+        auto index = (size_t) primitive["indices"].asInt(0);
+        used[accessorView(accessors[index])] = true;
+        accessorUsers[index]++;
+      }
+    }
+  }
+
+  // Optional reordering for the vertex cache, indices and the vertices they reference are rewritten together.
+  // Accessors shared between primitives would need one order for both and are left as they are.
+  // Levels of detail only add indices, every level of a primitive goes to one new unsigned int index buffer.
+  auto optimize = MeshOptimizer::isEnabled(), simplify = lodLevels > 1;
+  std::vector<std::vector<unsigned>> lodIndices;
+  std::vector<std::vector<Lod>> lodRanges;
+  if (optimize || simplify) {
+    size_t number = 0;
+    for (size_t m = 0; m < meshes.size(); m++) {
+      for (auto &primitive : meshes[m]["primitives"].items) {
+        auto current = number++;
+        auto name = gltf_file + " #" + std::to_string(current);
+        auto indexAccessor = (size_t) primitive["indices"].asInt(-1);
+        auto positionAccessor = (size_t) primitive["attributes"]["POSITION"].asInt(-1);
+        if (primitive["mode"].asInt(GL_TRIANGLES) != GL_TRIANGLES || indexAccessor >= accessors.size() ||
+            positionAccessor >= accessors.size())
+          continue;
+        auto &positionsJson = accessors[positionAccessor];
+        if ((GLenum) positionsJson["componentType"].asInt(0) != FLOAT_COMPONENT || positionsJson["type"].string != "VEC3")
+          continue;
+
+        bool exclusive = accessorUsers[indexAccessor] == 1;
+        for (auto &attribute : ATTRIBUTES) {
+          auto index = (size_t) primitive["attributes"][attribute.first].asInt(-1);
+          if (index < accessors.size() && accessorUsers[index] != 1) exclusive = false;
+        }
+        if (!simplify && !exclusive) continue;
+
+        // Indices of any type as unsigned
+        auto &indexJson = accessors[indexAccessor];
+        auto indexType = (GLenum) indexJson["componentType"].asInt(0);
+        auto indexSize = componentSize(indexType);
+        if (indexType != GL_UNSIGNED_BYTE && indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT) continue;
+        size_t indexStart, indexStride, length;
+        auto indexView = accessorLayout(indexJson, indexSize, indexStart, indexStride);
+        auto indexData = viewBytes(indexView, length) + indexStart;
+        auto vertexCount = (size_t) positionsJson["count"].asNumber(0.0);
+        std::vector<unsigned> indices((size_t) indexJson["count"].asNumber(0.0));
+        bool valid = indices.size() % 3 == 0;
+        for (size_t i = 0; i < indices.size(); i++) {
+          uint32_t value = 0;
+          std::memcpy(&value, indexData + i * indexSize, indexSize);
+          indices[i] = value;
+          valid = valid && value < vertexCount;
+        }
+        if (!valid) continue;
+
+        size_t positionStart, positionStride;
+        auto positionView = accessorLayout(positionsJson, 12, positionStart, positionStride);
+        auto positions = viewBytes(positionView, length) + positionStart;
+        std::vector<std::vector<unsigned>> levels;
+        if (simplify) levels = MeshOptimizer::generateLods(indices, vertexCount, positions, positionStride, lodLevels);
+
+        if (optimize && exclusive) {
+          auto remap = MeshOptimizer::optimize(name, indices, vertexCount, positions, positionStride);
+          for (auto &level : levels)
+            for (auto &index : level) index = remap[index];
+
+          patches[indexView].push_back([indices, indexStart, indexSize](uint8_t *data) {
+            for (size_t i = 0; i < indices.size(); i++) std::memcpy(data + indexStart + i * indexSize, &indices[i], indexSize);
+          });
+          for (auto &attribute : ATTRIBUTES) {
+            auto &accessor = accessors[(size_t) primitive["attributes"][attribute.first].asInt(-1)];
+            if (accessor.type == Json::Type::Null) continue;
+            auto size = componentCount(accessor["type"].string) * componentSize((GLenum) accessor["componentType"].asInt(0));
+            if (!size) continue;
+            size_t start, stride;
+            auto view = accessorLayout(accessor, size, start, stride);
+            if ((size_t) accessor["count"].asNumber(0.0) != vertexCount) invalid(gltf_file, "attribute counts differ");
+            patches[view].push_back([remap, start, size, stride](uint8_t *data) {
+              MeshOptimizer::remapVertices(data + start, remap, size, stride);
+            });
+          }
+        }
+        if (levels.empty()) continue;
+
+        lodIndices.resize(number);
+        lodRanges.resize(number);
+        auto &combined = lodIndices[current];
+        combined = indices;
+        lodRanges[current].push_back({0, (GLsizei) indices.size()});
+        for (auto &level : levels) {
+          lodRanges[current].push_back({combined.size() * sizeof(unsigned), (GLsizei) level.size()});
+          combined.insert(combined.end(), level.begin(), level.end());
+        }
+      }
+    }
+  }
+
+  try {
+    buffers.assign(views.size(), 0);
+    for (size_t i = 0; i < views.size(); i++) {
+      if (!used[i]) continue;
+      size_t length;
+      auto data = viewBytes(i, length);
+
+      // Untouched views are uploaded straight from the mapping
+      std::vector<uint8_t> patched;
+      if (!patches[i].empty()) {
+        patched.assign(data, data + length);
+        for (auto &patch : patches[i]) patch(patched.data());
+        data = patched.data();
+      }
+
+      glGenBuffers(1, &buffers[i]);
+      glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+      glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) length, data, GL_STATIC_DRAW);
+      byteSize += length;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // One vertex array per primitive, accessors are bound with their own types, strides and offsets
+    std::vector<std::vector<size_t>> meshPrimitives(meshes.size());
+    for (size_t m = 0; m < meshes.size(); m++) {
+      for (auto &source : meshes[m]["primitives"].items) {
+        Primitive primitive;
+        primitive.mode = (GLenum) source["mode"].asInt(GL_TRIANGLES);
+        primitive.material = source["material"].asInt(-1);
+        glGenVertexArrays(1, &primitive.vao);
+        // Registered right away so a failure below still releases it
+        primitives.push_back(primitive);
+        RenderState::bindVertexArray(primitive.vao);
+
+        for (auto &attribute : ATTRIBUTES) {
+          auto &accessor = accessors[(size_t) source["attributes"][attribute.first].asInt(-1)];
+          if (accessor.type == Json::Type::Null) continue;
+          auto view = accessorView(accessor);
+          auto components = componentCount(accessor["type"].string);
+          auto type = (GLenum) accessor["componentType"].asInt(0);
+          if (!components || !componentSize(type)) invalid(gltf_file, "unsupported attribute type");
+
+          glBindBuffer(GL_ARRAY_BUFFER, buffers[view]);
+          glEnableVertexAttribArray(attribute.second);
+          glVertexAttribPointer(attribute.second, components, type, accessor["normalized"].asBool(false) ? GL_TRUE : GL_FALSE,
+                                (GLsizei) views[view]["byteStride"].asNumber(0.0),
+                                (const void *) (size_t) accessor["byteOffset"].asNumber(0.0));
+          if (attribute.second == 0) {
+            primitive.count = (GLsizei) accessor["count"].asNumber(0.0);
+            // Bounds are required on POSITION accessors, the farthest corner bounds the mesh
+            glm::vec3 corner;
+            for (int i = 0; i < 3; i++)
+              corner[i] = (float) std::max(std::abs(accessor["min"][(size_t) i].asNumber(0.0)),
+                                           std::abs(accessor["max"][(size_t) i].asNumber(0.0)));
+            radius = std::max(radius, glm::length(corner));
+          }
+        }
+
+        if (source.has("indices")) {
+          auto &accessor = accessors[(size_t) source["indices"].asInt(0)];
+          primitive.indexType = (GLenum) accessor["componentType"].asInt(0);
+          if (primitive.indexType != GL_UNSIGNED_BYTE && primitive.indexType != GL_UNSIGNED_SHORT &&
+              primitive.indexType != GL_UNSIGNED_INT)
+            invalid(gltf_file, "unsupported index type");
+          primitive.indexOffset = (size_t) accessor["byteOffset"].asNumber(0.0);
+          primitive.count = (GLsizei) accessor["count"].asNumber(0.0);
+          // Element buffer binding is part of the vertex array state
+          auto number = primitives.size() - 1;
+          if (number < lodIndices.size() && !lodIndices[number].empty()) {
+            auto &indices = lodIndices[number];
+            buffers.push_back(0);
+            glGenBuffers(1, &buffers.back());
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.back());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) (indices.size() * sizeof(unsigned)), indices.data(),
+                         GL_STATIC_DRAW);
+            byteSize += indices.size() * sizeof(unsigned);
+            primitive.indexType = GL_UNSIGNED_INT;
+            primitive.indexOffset = 0;
+            primitive.lods = lodRanges[number];
+          } else {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[accessorView(accessor)]);
+          }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        primitives.back() = primitive;
+        meshPrimitives[m].push_back(primitives.size() - 1);
+      }
+    }
+
+    // Walk the default scene, without one every node nobody lists as a child is a root
+    auto &nodes = document["nodes"];
+    std::vector<std::pair<size_t, glm::mat4>> pending;
+    auto &scene = document["scenes"][(size_t) document["scene"].asInt(0)];
+    if (scene.has("nodes")) {
+      for (auto &root : scene["nodes"].items) pending.emplace_back((size_t) root.asInt(0), glm::mat4{1.0f});
+    } else {
+      std::vector<bool> child(nodes.size(), false);
+      for (auto &node : nodes.items)
+        for (auto &index : node["children"].items)
+          if ((size_t) index.asInt(0) < child.size()) child[(size_t) index.asInt(0)] = true;
+      for (size_t i = 0; i < nodes.size(); i++)
+        if (!child[i]) pending.emplace_back(i, glm::mat4{1.0f});
+    }
+
+    size_t visited = 0;
+    while (!pending.empty()) {
+      auto index = pending.back().first;
+      auto parent = pending.back().second;
+      pending.pop_back();
+      // A valid hierarchy is a forest, more visits than nodes means a cycle
+      if (index >= nodes.size() || ++visited > nodes.size()) invalid(gltf_file, "invalid node hierarchy");
+
+      auto &node = nodes[index];
+      auto transform = parent * nodeTransform(node);
+      auto mesh = (size_t) node["mesh"].asInt(-1);
+      if (mesh < meshPrimitives.size())
+        for (auto primitive : meshPrimitives[mesh]) instances.push_back({primitive, transform});
+      for (auto &child : node["children"].items) pending.emplace_back((size_t) child.asInt(0), transform);
+    }
+  } catch (...) {
+    release();
+    throw;
+  }
+
+  // Materials only reference their images, loading them is up to the caller
+  auto imagePath = [&](const Json &textureInfo) {
+    auto &texture = document["textures"][(size_t) textureInfo["index"].asInt(-1)];
+    auto &uri = document["images"][(size_t) texture["source"].asInt(-1)]["uri"].string;
+    return uri.empty() ? uri : directory + decodeUri(uri);
+  };
+  for (auto &source : document["materials"].items) {
+    Material material;
+    auto &pbr = source["pbrMetallicRoughness"];
+    material.name = source["name"].string;
+    for (size_t i = 0; i < 4; i++) material.baseColorFactor[i] = (float) pbr["baseColorFactor"][i].asNumber(1.0);
+    material.metallicFactor = (float) pbr["metallicFactor"].asNumber(1.0);
+    material.roughnessFactor = (float) pbr["roughnessFactor"].asNumber(1.0);
+    material.baseColorTexture = imagePath(pbr["baseColorTexture"]);
+    material.metallicRoughnessTexture = imagePath(pbr["metallicRoughnessTexture"]);
+    material.normalTexture = imagePath(source["normalTexture"]);
+    material.blend = source["alphaMode"].string == "BLEND";
+    material.doubleSided = source["doubleSided"].asBool(false);
+    materials.push_back(material);
+  }
+}
+
+ppgso::Mesh_Gltf::~Mesh_Gltf() {
+  release();
+}
+
+void ppgso::Mesh_Gltf::release() {
+  for (auto &primitive : primitives) {
+    RenderState::forgetVertexArray(primitive.vao);
+    glDeleteVertexArrays(1, &primitive.vao);
+  }
+  for (auto buffer : buffers)
+    if (buffer) glDeleteBuffers(1, &buffer);
+  primitives.clear();
+  buffers.clear();
+}
+
+void ppgso::Mesh_Gltf::render(size_t lod) {
+  for (auto &primitive : primitives) draw(primitive, lod);
+}
+
+void ppgso::Mesh_Gltf::render(const Shader &shader, const glm::mat4 &modelMatrix, const std::string &uniform,
+                              size_t lod) {
+  for (auto &instance : instances) {
+    shader.setUniform(uniform, modelMatrix * instance.transform);
+    draw(primitives[instance.primitive], lod);
+  }
+}
+
+size_t ppgso::Mesh_Gltf::getLodCount() const {
+  size_t count = 1;
+  for (auto &primitive : primitives) count = std::max(count, primitive.lods.size());
+  return count;
+}
+
+size_t ppgso::Mesh_Gltf::getTriangleCount(size_t lod) const {
+  size_t triangles = 0;
+  for (auto &primitive : primitives) triangles += primitiveTriangles(primitive, lodCount(primitive, lod));
+  return triangles;
+}
+
+float ppgso::Mesh_Gltf::getRadius() const {
+  return radius;
+}
+
+std::vector<ppgso::MeshPart> ppgso::Mesh_Gltf::getParts() const {
+  std::vector<MeshPart> parts;
+  for (auto &primitive : primitives) {
+    if (primitive.mode != GL_TRIANGLES || primitive.indexType == GL_NONE) continue;
+    MeshPart part;
+    part.vao = primitive.vao;
+    part.indexType = primitive.indexType;
+    if (primitive.lods.empty()) part.lods.push_back({primitive.indexOffset, primitive.count});
+    for (auto &lod : primitive.lods) part.lods.push_back({lod.offset, lod.count});
+    parts.push_back(part);
+  }
+  return parts;
+}
+
+GLsizei ppgso::Mesh_Gltf::lodCount(const Primitive &primitive, size_t lod) {
+  if (primitive.lods.empty()) return primitive.count;
+  return primitive.lods[std::min(lod, primitive.lods.size() - 1)].count;
+}
+
+size_t ppgso::Mesh_Gltf::primitiveTriangles(const Primitive &primitive, GLsizei count) {
+  switch (primitive.mode) {
+    case GL_TRIANGLES:
+      return (size_t) count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      return count > 2 ? (size_t) count - 2 : 0;
+    default:
+      return 0;
+  }
+}
+
+void ppgso::Mesh_Gltf::draw(const Primitive &primitive, size_t lod) const {
+  RenderState::bindVertexArray(primitive.vao);
+  auto count = lodCount(primitive, lod);
+  if (primitive.indexType != GL_NONE) {
+    auto offset = primitive.indexOffset;
+    if (!primitive.lods.empty()) offset = primitive.lods[std::min(lod, primitive.lods.size() - 1)].offset;
+    glDrawElements(primitive.mode, count, primitive.indexType, (const void *) offset);
+  } else {
+    glDrawArrays(primitive.mode, 0, count);
+  }
+  RenderState::countDraw(primitiveTriangles(primitive, count));
+}
+
+const std::vector<ppgso::Mesh_Gltf::Material> &ppgso::Mesh_Gltf::getMaterials() const {
+  return materials;
+}
+
+const std::vector<ppgso::Mesh_Gltf::Primitive> &ppgso::Mesh_Gltf::getPrimitives() const {
+  return primitives;
+}
+
+const std::vector<ppgso::Mesh_Gltf::Instance> &ppgso::Mesh_Gltf::getInstances() const {
+  return instances;
+}
+
+size_t ppgso::Mesh_Gltf::getByteSize() const {
+  return byteSize;
+}
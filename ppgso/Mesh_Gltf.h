@@ -0,0 +1,152 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "mesh_part.h"
+
+namespace ppgso {
+
+  /*!
+   * Native reader for glTF 2.0 files with external .bin buffers, independent of Assimp.
+   *
+   * The binary buffer is memory mapped and every bufferView used by a primitive becomes one GL buffer,
+   * uploaded as stored in the file. Accessors are bound with their own component types, strides and offsets,
+   * so unsigned short indices or normalized attributes reach the GPU without conversion.
+   * The only rewritten data are float texture coordinates, flipped vertically to the OBJ convention
+   * the other Mesh loaders (and the shaders) use.
+   * Primitives with levels of detail (lodLevels of the constructor) draw from an extra unsigned int index buffer
+   * holding every level.
+   *
+   * Attributes are bound like in the other loaders:
+   * vec3 Position - POSITION, location 0
+   * vec2 TexCoord - TEXCOORD_0, location 1
+   * vec3 Normal - NORMAL, location 2
+   */
+  class Mesh_Gltf {
+  public:
+    struct Material {
+      std::string name;
+      glm::vec4 baseColorFactor{1.0f};
+      float metallicFactor = 1.0f;
+      float roughnessFactor = 1.0f;
+      // Image paths relative to the working directory, empty when the material has no such texture
+      std::string baseColorTexture;
+      std::string metallicRoughnessTexture;
+      std::string normalTexture;
+      bool blend = false;        // alphaMode BLEND
+      bool doubleSided = false;
+    };
+
+    // Range of the index buffer drawn for one level of detail
+    struct Lod {
+      size_t offset = 0;         // Bytes
+      GLsizei count = 0;
+    };
+
+    struct Primitive {
+      GLuint vao = 0;
+      GLenum mode = GL_TRIANGLES;
+      GLsizei count = 0;         // Indices, or vertices for non-indexed primitives
+      GLenum indexType = GL_NONE; // GL_NONE for non-indexed primitives
+      size_t indexOffset = 0;
+      int material = -1;
+      std::vector<Lod> lods;     // Full detail first, empty when no levels were built
+    };
+
+    // Primitive placed in the scene by a node
+    struct Instance {
+      size_t primitive;
+      glm::mat4 transform;       // World transform of the node
+    };
+
+    /*!
+     * Load glTF file, throws when the file or its buffers can not be read
+     *
+     * @param gltf_file - File path to the .gltf file, buffers are resolved relative to it
+     * @param lodLevels - Levels of detail to build including the full mesh, 1 builds none (1 default)
+     */
+    Mesh_Gltf(const std::string &gltf_file, int lodLevels = 1);
+
+    ~Mesh_Gltf();
+
+    Mesh_Gltf(const Mesh_Gltf&) = delete;
+    Mesh_Gltf &operator=(const Mesh_Gltf&) = delete;
+
+    /*!
+     * Check whether a path names a glTF file
+     * @param path - File path
+     * @return True for the .gltf extension
+     */
+    static bool isGltf(const std::string &path);
+
+    /*!
+     * Render every primitive once in mesh space, node transforms are not applied
+     * @param lod - Level of detail, 0 is the full mesh, levels past the last draw the coarsest one
+     */
+    void render(size_t lod = 0);
+
+    /*!
+     * Render every node instance with its node transform
+     *
+     * @param shader - Shader receiving the combined transform
+     * @param modelMatrix - Transform of the whole model
+     * @param uniform - Name of the model matrix uniform ("ModelMatrix" default)
+     * @param lod - Level of detail, clamped like in render
+     */
+    void render(const Shader &shader, const glm::mat4 &modelMatrix, const std::string &uniform = "ModelMatrix",
+                size_t lod = 0);
+
+    /*!
+     * Get number of levels of detail, up to the lodLevels the mesh was loaded with
+     * @return Levels including the full mesh
+     */
+    size_t getLodCount() const;
+
+    /*!
+     * Get triangles drawn by render in mesh space
+     * @param lod - Level, clamped like in render
+     * @return Triangle count
+     */
+    size_t getTriangleCount(size_t lod = 0) const;
+
+    /*!
+     * Get radius of a sphere around the mesh origin bounding every primitive, from the POSITION bounds
+     * @return Radius in mesh units
+     */
+    float getRadius() const;
+
+    /*!
+     * Get vertex arrays and index ranges of the indexed triangle primitives, for instanced or indirect draws
+     * Node transforms are not part of it, like in render without a shader.
+     * @return One part per primitive, other primitives are left out
+     */
+    std::vector<MeshPart> getParts() const;
+
+    const std::vector<Material> &getMaterials() const;
+    const std::vector<Primitive> &getPrimitives() const;
+    const std::vector<Instance> &getInstances() const;
+
+    /*!
+     * Get the GPU memory used by the uploaded bufferViews
+     * @return Size in bytes
+     */
+    size_t getByteSize() const;
+
+  private:
+    void draw(const Primitive &primitive, size_t lod) const;
+    static GLsizei lodCount(const Primitive &primitive, size_t lod);
+    static size_t primitiveTriangles(const Primitive &primitive, GLsizei count);
+    void release();
+
+    std::vector<GLuint> buffers;
+    std::vector<Primitive> primitives;
+    std::vector<Instance> instances;
+    std::vector<Material> materials;
+    size_t byteSize = 0;
+    float radius = 0.0f;
+  };
+}
@@ -1,17 +1,25 @@
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <sstream>
 
 #include "Mesh_Tiny.h"
+#include "render_state.h"
+#include "mesh_optimizer.h"
 
-ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
+ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file, int lodLevels) {
 #ifdef DEBBUG_MODE
     std::cout << "Using Tiny Obj Loader!" << std::endl;
 #endif
 
+  if (Mesh_Gltf::isGltf(obj_file)) {
+    gltf = std::make_unique<Mesh_Gltf>(obj_file, lodLevels);
+    return;
+  }
+
   // Load OBJ file
   shapes.clear();
   materials.clear();
-  std::string err = tinyobj::LoadObj(shapes, materials, obj_file.c_str());
+  std::string err = tinyobj::LoadObjParallel(shapes, materials, obj_file.c_str());
 
   if (!err.empty()) {
     std::stringstream msg;
@@ -23,16 +31,45 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
   for(auto& shape : shapes) {
     gl_buffer buffer;
 
+    if (MeshOptimizer::isEnabled() && !shape.mesh.indices.empty()) {
+      auto vertexCount = shape.mesh.positions.size() / 3;
+      std::stringstream name;
+      name << obj_file;
+      if (shapes.size() > 1) name << " #" << buffers.size();
+      auto remap = MeshOptimizer::optimize(name.str(), shape.mesh.indices, vertexCount, shape.mesh.positions.data(),
+                                           3 * sizeof(float));
+      MeshOptimizer::remapVertices(shape.mesh.positions.data(), remap, 3 * sizeof(float), 3 * sizeof(float));
+      // Normals and texture coordinates are optional per face, only complete ones line up with positions
+      if (shape.mesh.texcoords.size() == vertexCount * 2)
+        MeshOptimizer::remapVertices(shape.mesh.texcoords.data(), remap, 2 * sizeof(float), 2 * sizeof(float));
+      if (shape.mesh.normals.size() == vertexCount * 3)
+        MeshOptimizer::remapVertices(shape.mesh.normals.data(), remap, 3 * sizeof(float), 3 * sizeof(float));
+    }
+
+    // Coarser levels share the vertices, their indices follow the full detail ones in the index buffer
+    std::vector<unsigned> indices = shape.mesh.indices;
+    buffer.lods.push_back({0, (GLsizei) indices.size()});
+    if (lodLevels > 1 && !indices.empty()) {
+      for (auto &lod : MeshOptimizer::generateLods(shape.mesh.indices, shape.mesh.positions.size() / 3,
+                                                   shape.mesh.positions.data(), 3 * sizeof(float), lodLevels)) {
+        buffer.lods.push_back({indices.size() * sizeof(unsigned int), (GLsizei) lod.size()});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+      }
+    }
+    for (size_t i = 0; i + 2 < shape.mesh.positions.size(); i += 3)
+      radius = std::max(radius, glm::length(glm::make_vec3(&shape.mesh.positions[i])));
+
     if(!shape.mesh.positions.empty()) {
       // Generate a vertex array object
       glGenVertexArrays(1, &buffer.vao);
-      glBindVertexArray(buffer.vao);
+      RenderState::bindVertexArray(buffer.vao);
 
       // Generate and upload a buffer with vertex positions to GPU
       glGenBuffers(1, &buffer.vbo);
       glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
       glBufferData(GL_ARRAY_BUFFER, shape.mesh.positions.size() * sizeof(float), shape.mesh.positions.data(),
                    GL_STATIC_DRAW);
+      byteSize += shape.mesh.positions.size() * sizeof(float);
 
       // Bind the buffer to "Position" attribute in program
       glEnableVertexAttribArray(0);
@@ -45,6 +82,7 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
       glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
       glBufferData(GL_ARRAY_BUFFER, shape.mesh.texcoords.size() * sizeof(float), shape.mesh.texcoords.data(),
                    GL_STATIC_DRAW);
+      byteSize += shape.mesh.texcoords.size() * sizeof(float);
 
       glEnableVertexAttribArray(1);
       glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -56,6 +94,7 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
       glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
       glBufferData(GL_ARRAY_BUFFER, shape.mesh.normals.size() * sizeof(float), shape.mesh.normals.data(),
                    GL_STATIC_DRAW);
+      byteSize += shape.mesh.normals.size() * sizeof(float);
 
       glEnableVertexAttribArray(2);
       glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -64,7 +103,8 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
     // Generate and upload a buffer with indices to GPU
     glGenBuffers(1, &buffer.ibo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.mesh.indices.size() * sizeof(unsigned int), shape.mesh.indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    byteSize += indices.size() * sizeof(unsigned int);
     buffer.size = (GLsizei) shape.mesh.indices.size();
 
     // Copy it to the end of the buffers vector
@@ -78,14 +118,58 @@ ppgso::Mesh_Tiny::~Mesh_Tiny() {
     glDeleteBuffers(1, &buffer.nbo);
     glDeleteBuffers(1, &buffer.tbo);
     glDeleteBuffers(1, &buffer.vbo);
+    RenderState::forgetVertexArray(buffer.vao);
     glDeleteVertexArrays(1, &buffer.vao);
   }
 }
 
 void ppgso::Mesh_Tiny::render() {
+  render(0);
+}
+
+void ppgso::Mesh_Tiny::render(size_t lod) {
+  if (gltf) return gltf->render(lod);
   for(auto& buffer : buffers) {
-    // Draw object
-    glBindVertexArray(buffer.vao);
-    glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+    // Draw object, shapes with fewer levels use their coarsest one
+    auto &range = buffer.lods[std::min(lod, buffer.lods.size() - 1)];
+    RenderState::bindVertexArray(buffer.vao);
+    glDrawElements(GL_TRIANGLES, range.size, GL_UNSIGNED_INT, (const void *) range.offset);
+    RenderState::countDraw((size_t) range.size / 3);
+  }
+}
+
+size_t ppgso::Mesh_Tiny::getLodCount() const {
+  if (gltf) return gltf->getLodCount();
+  size_t count = 1;
+  for (auto &buffer : buffers) count = std::max(count, buffer.lods.size());
+  return count;
+}
+
+size_t ppgso::Mesh_Tiny::getTriangleCount(size_t lod) const {
+  if (gltf) return gltf->getTriangleCount(lod);
+  size_t triangles = 0;
+  for (auto &buffer : buffers) triangles += (size_t) buffer.lods[std::min(lod, buffer.lods.size() - 1)].size / 3;
+  return triangles;
+}
+
+float ppgso::Mesh_Tiny::getRadius() const {
+  if (gltf) return gltf->getRadius();
+  return radius;
+}
+
+size_t ppgso::Mesh_Tiny::getByteSize() const {
+  if (gltf) return gltf->getByteSize();
+  return byteSize;
+}
+
+std::vector<ppgso::MeshPart> ppgso::Mesh_Tiny::getParts() const {
+  if (gltf) return gltf->getParts();
+  std::vector<MeshPart> parts;
+  for (auto &buffer : buffers) {
+    MeshPart part;
+    part.vao = buffer.vao;
+    for (auto &lod : buffer.lods) part.lods.push_back({lod.offset, lod.size});
+    parts.push_back(part);
   }
+  return parts;
 }
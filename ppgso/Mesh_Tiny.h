@@ -12,18 +12,30 @@
 #include "shader.h"
 #include "texture.h"
 #include "tiny_obj_loader.h"
+#include "Mesh_Gltf.h"
+#include "mesh_part.h"
 
 namespace ppgso {
 
   class Mesh_Tiny {
+    // Range of the index buffer drawn for one level of detail
+    struct gl_lod {
+      size_t offset = 0;         // Bytes
+      GLsizei size = 0;
+    };
     struct gl_buffer {
     public:
       GLuint vao, vbo, tbo, nbo, ibo = 0;
       GLsizei size = 0;
+      std::vector<gl_lod> lods;  // Full detail first
     };
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
     std::vector<gl_buffer> buffers;
+    size_t byteSize = 0;
+    float radius = 0.0f;
+    // Set for .gltf files, which are read by the native glTF loader
+    std::unique_ptr<Mesh_Gltf> gltf;
 
   public:
 
@@ -35,9 +47,12 @@ namespace ppgso {
      * vec2 TexCoord - Texture coordinate, position 1
      * vec3 Normal - Normal vector, position 2
      *
+     * Files with the .gltf extension are loaded by Mesh_Gltf instead.
+     *
      * @param obj - File path to the obj file to load.
+     * @param lodLevels - Levels of detail to build including the full mesh, 1 builds none (1 default)
      */
-    Mesh_Tiny(const std::string &obj);
+    Mesh_Tiny(const std::string &obj, int lodLevels = 1);
 
     ~Mesh_Tiny();
 
@@ -45,6 +60,43 @@ namespace ppgso {
      * Render the geometry associated with the mesh using glDrawElements.
      */
     void render();
+
+    /*!
+     * Render one level of detail, see the lodLevels of the constructor
+     * @param lod - Level, 0 is the full mesh, levels past the last draw the coarsest one
+     */
+    void render(size_t lod);
+
+    /*!
+     * Get number of levels of detail
+     * @return Levels including the full mesh
+     */
+    size_t getLodCount() const;
+
+    /*!
+     * Get triangles drawn by one level of detail
+     * @param lod - Level, clamped like in render
+     * @return Triangle count
+     */
+    size_t getTriangleCount(size_t lod = 0) const;
+
+    /*!
+     * Get radius of the bounding sphere around the mesh origin
+     * @return Radius in mesh units
+     */
+    float getRadius() const;
+
+    /*!
+     * Get vertex arrays and index ranges of every shape, for instanced or indirect draws
+     * @return One part per shape
+     */
+    std::vector<MeshPart> getParts() const;
+
+    /*!
+     * Get the GPU memory used by the vertex and index buffers of the mesh
+     * @return Size in bytes
+     */
+    size_t getByteSize() const;
   };
 }
 
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "animation_clip.h"
+
+ppgso::AnimationClip::AnimationClip(const std::vector<Key> &keys, bool loop)
+        : AnimationClip{keys, {}, loop} {
+  // Catmull-Rom, the tangent of a key is the velocity between its neighbours
+  auto count = times.size();
+  tangents.assign(count, glm::vec3{0.0f});
+  if (count < 2) return;
+  for (size_t i = 0; i < count; i++) {
+    auto previous = i == 0 ? 0 : i - 1, next = std::min(i + 1, count - 1);
+    auto span = times[next] - times[previous];
+    if (loop && count > 2 && (i == 0 || i == count - 1)) {
+      // The first and the last key are the same point of the loop
+      previous = count - 2;
+      next = 1;
+      span = (times[count - 1] - times[count - 2]) + (times[1] - times[0]);
+    }
+    tangents[i] = (positions[next] - positions[previous]) / span;
+  }
+}
+
+ppgso::AnimationClip::AnimationClip(const std::vector<Key> &keys, const std::vector<glm::vec3> &tangents, bool loop)
+        : tangents{tangents}, loop{loop} {
+  if (keys.empty())
+    throw std::runtime_error("AnimationClip needs at least one key");
+  if (!tangents.empty() && tangents.size() != keys.size())
+    throw std::runtime_error("AnimationClip needs one tangent per key");
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (i && keys[i].time <= keys[i - 1].time)
+      throw std::runtime_error("AnimationClip keys must have increasing times");
+    times.push_back(keys[i].time);
+    positions.push_back(keys[i].position);
+    rotations.push_back(glm::normalize(keys[i].rotation));
+  }
+}
+
+float ppgso::AnimationClip::localTime(float time) const {
+  auto start = times.front(), duration = times.back() - start;
+  if (duration <= 0.0f) return start;
+  if (loop) {
+    auto wrapped = std::fmod(time - start, duration);
+    return start + (wrapped < 0.0f ? wrapped + duration : wrapped);
+  }
+  return std::min(std::max(time, start), times.back());
+}
+
+size_t ppgso::AnimationClip::findSegment(float time) const {
+  // Last key at or before the time, the final key belongs to the segment before it
+  auto next = std::upper_bound(times.begin(), times.end(), time);
+  auto segment = (size_t) std::max<long>(next - times.begin() - 1, 0);
+  return std::min(segment, times.size() - 2);
+}
+
+ppgso::AnimationClip::Pose ppgso::AnimationClip::evaluate(size_t segment, float time) const {
+  auto span = times[segment + 1] - times[segment];
+  auto s = (time - times[segment]) / span;
+  auto s2 = s * s, s3 = s2 * s;
+
+  // Cubic Hermite basis
+  auto h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+  auto h10 = s3 - 2.0f * s2 + s;
+  auto h01 = -2.0f * s3 + 3.0f * s2;
+  auto h11 = s3 - s2;
+
+  Pose pose;
+  pose.position = h00 * positions[segment] + h10 * span * tangents[segment]
+                  + h01 * positions[segment + 1] + h11 * span * tangents[segment + 1];
+  pose.rotation = glm::slerp(rotations[segment], rotations[segment + 1], s);
+  return pose;
+}
+
+ppgso::AnimationClip::Pose ppgso::AnimationClip::sample(float time) const {
+  if (times.size() == 1) return {positions[0], rotations[0]};
+  auto local = localTime(time);
+  return evaluate(findSegment(local), local);
+}
+
+ppgso::AnimationClip::Pose ppgso::AnimationClip::sample(float time, size_t &segment) const {
+  if (times.size() == 1) return {positions[0], rotations[0]};
+  auto local = localTime(time);
+
+  // Frame to frame the time stays in the cached segment or moves to the next one
+  auto last = times.size() - 2;
+  if (segment > last || local < times[segment]) {
+    segment = findSegment(local);
+  } else if (local >= times[segment + 1] && segment < last) {
+    segment++;
+    if (local >= times[segment + 1] && segment < last) segment = findSegment(local);
+  }
+  return evaluate(segment, local);
+}
+
+void ppgso::AnimationClip::sample(float time, const std::vector<float> &offsets, std::vector<Pose> &poses) const {
+  auto count = (long) offsets.size();
+  poses.resize(offsets.size());
+  #pragma omp parallel for schedule(static)
+  for (long i = 0; i < count; i++)
+    poses[i] = sample(time + offsets[i]);
+}
+
+glm::mat4 ppgso::AnimationClip::modelMatrix(const Pose &pose, const glm::vec3 &scale) {
+  return glm::translate(glm::mat4{1.0f}, pose.position) * glm::mat4_cast(pose.rotation)
+         * glm::scale(glm::mat4{1.0f}, scale);
+}
+
+float ppgso::AnimationClip::getDuration() const {
+  return times.back() - times.front();
+}
+
+bool ppgso::AnimationClip::isLooping() const {
+  return loop;
+}
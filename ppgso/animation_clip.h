@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace ppgso {
+
+  /*!
+   * Keyframe animation of a position and a rotation, shared by every instance that plays it.
+   *
+   * Positions follow a cubic Hermite spline through the keys. Without explicit tangents these are
+   * Catmull-Rom tangents from the neighbouring keys, also for keys spaced unevenly in time. Rotations are
+   * quaternions interpolated with slerp along the shorter arc, so consecutive keys have to be less than half
+   * a turn apart. Looping clips wrap around, their last key should match the first.
+   *
+   * Key times are stored on their own and searched with a binary search. Instances sampling every frame
+   * keep the segment of their last sample, which makes the common case a single comparison.
+   */
+  class AnimationClip {
+  public:
+    struct Key {
+      float time;
+      glm::vec3 position;
+      glm::quat rotation;
+    };
+
+    struct Pose {
+      glm::vec3 position;
+      glm::quat rotation;
+    };
+
+    /*!
+     * Create clip with Catmull-Rom position tangents, throws when there are no keys or times do not increase
+     *
+     * @param keys - Keys in time order
+     * @param loop - True to wrap times around the clip duration, clamps to the first and last key otherwise
+     */
+    AnimationClip(const std::vector<Key> &keys, bool loop);
+
+    /*!
+     * Create clip with explicit Hermite tangents
+     *
+     * @param keys - Keys in time order
+     * @param tangents - Velocity of the position at every key
+     * @param loop - True to wrap times around the clip duration
+     */
+    AnimationClip(const std::vector<Key> &keys, const std::vector<glm::vec3> &tangents, bool loop);
+
+    /*!
+     * Sample clip, searching all keys
+     * @param time - Time in seconds
+     * @return Interpolated pose
+     */
+    Pose sample(float time) const;
+
+    /*!
+     * Sample clip starting from the segment of a previous sample, for instances moving forward in time
+     *
+     * @param time - Time in seconds
+     * @param segment - Segment of the last sample, 0 at first, updated to the segment of this one
+     * @return Interpolated pose
+     */
+    Pose sample(float time, size_t &segment) const;
+
+    /*!
+     * Sample clip for many instances at once, in parallel with OpenMP
+     *
+     * @param time - Time in seconds all instances share
+     * @param offsets - Time offset of every instance
+     * @param poses - Resized to the number of offsets
+     */
+    void sample(float time, const std::vector<float> &offsets, std::vector<Pose> &poses) const;
+
+    /*!
+     * Get model matrix of a pose
+     * @param pose - Pose to convert
+     * @param scale - Scale applied before the rotation
+     * @return Translation times rotation times scale
+     */
+    static glm::mat4 modelMatrix(const Pose &pose, const glm::vec3 &scale);
+
+    float getDuration() const;
+    bool isLooping() const;
+
+  private:
+    // Time into the clip, wrapped or clamped
+    float localTime(float time) const;
+    // Segment containing a local time, by binary search
+    size_t findSegment(float time) const;
+    Pose evaluate(size_t segment, float time) const;
+
+    std::vector<float> times;
+    std::vector<glm::vec3> positions, tangents;
+    std::vector<glm::quat> rotations;
+    bool loop = false;
+  };
+}
@@ -0,0 +1,295 @@
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "convolution.h"
+#include "resource_cache.h"
+#include "render_state.h"
+
+#include <shaders/post_vert_glsl.h>
+#include <shaders/post_convolution_frag_glsl.h>
+#include <shaders/convolution_comp_glsl.h>
+
+namespace {
+  // Compute shader work group is 16x16 pixels, see convolution_comp.glsl
+  const int GROUP = 16;
+
+  // Taps the compute shader keeps in shared memory, larger kernels use the fragment pass
+  const int MAX_COMPUTE_RADIUS = 8;
+
+  struct Tap {
+    glm::vec2 offset;
+    float weight;
+  };
+
+  void checkKernel(size_t taps) {
+    if (taps % 2 == 0) {
+      std::stringstream msg;
+      msg << "Convolution kernel needs an odd number of taps, got " << taps;
+      throw std::invalid_argument(msg.str());
+    }
+  }
+
+  /*!
+   * Merge a 1D kernel into bilinear fetches along direction.
+   * Two neighbouring weights a, b of the same sign are read with one fetch placed a / (a + b)
+   * of the way between them, the center tap stays on its own so symmetric kernels stay symmetric.
+   */
+  std::vector<Tap> linearTaps(const std::vector<float> &kernel, glm::vec2 direction) {
+    std::vector<Tap> taps;
+    int radius = (int) kernel.size() / 2;
+    auto weight = [&](int i) { return kernel[i + radius]; };
+
+    if (weight(0) != 0.0f) taps.push_back({glm::vec2{0.0f}, weight(0)});
+    for (int side = -1; side <= 1; side += 2) {
+      for (int i = 1; i <= radius;) {
+        auto a = weight(side * i);
+        if (a == 0.0f) {
+          i++;
+          continue;
+        }
+        auto b = i < radius ? weight(side * (i + 1)) : 0.0f;
+        if (b != 0.0f && (a > 0.0f) == (b > 0.0f)) {
+          taps.push_back({direction * (float) side * ((float) i + b / (a + b)), a + b});
+          i += 2;
+        } else {
+          taps.push_back({direction * (float) (side * i), a});
+          i++;
+        }
+      }
+    }
+    return taps;
+  }
+
+  /*!
+   * Check whether a pass with the kernel can produce both positive and negative results
+   */
+  bool mixedSigns(const std::vector<float> &kernel) {
+    auto positive = std::any_of(kernel.begin(), kernel.end(), [](float weight) { return weight > 0.0f; });
+    auto negative = std::any_of(kernel.begin(), kernel.end(), [](float weight) { return weight < 0.0f; });
+    return positive && negative;
+  }
+
+  /*!
+   * Build the fragment pass for the taps, zero weight taps are expected to be filtered out already
+   */
+  std::shared_ptr<ppgso::Shader> fragmentShader(const std::vector<Tap> &taps) {
+    std::stringstream offsets, weights;
+    offsets << std::showpoint << std::setprecision(9);
+    weights << std::showpoint << std::setprecision(9);
+    for (size_t i = 0; i < taps.size(); i++) {
+      if (i) {
+        offsets << ", ";
+        weights << ", ";
+      }
+      offsets << "vec2(" << taps[i].offset.x << ", " << taps[i].offset.y << ")";
+      weights << taps[i].weight;
+    }
+
+    // An all zero kernel still needs one tap to form a valid array
+    std::stringstream defines;
+    if (taps.empty())
+      defines << "#define TAPS 1\n#define OFFSETS vec2(0.0)\n#define WEIGHTS 0.0\n";
+    else
+      defines << "#define TAPS " << taps.size() << "\n#define OFFSETS " << offsets.str() << "\n#define WEIGHTS "
+              << weights.str() << "\n";
+    return ppgso::ShaderCache::get(post_vert_glsl, ppgso::Shader::withDefines(post_convolution_frag_glsl, defines.str()));
+  }
+}
+
+ppgso::Convolution::Convolution(const std::vector<float> &kernel, int size, float factor, float bias)
+    : factor{factor}, bias{bias}, size{size} {
+  checkKernel((size_t) size);
+  if (kernel.size() != (size_t) (size * size)) {
+    std::stringstream msg;
+    msg << "Convolution kernel of size " << size << " needs " << size * size << " weights, got " << kernel.size();
+    throw std::invalid_argument(msg.str());
+  }
+  glGenVertexArrays(1, &vao);
+
+  // Rank one test, every row has to be a multiple of the row holding the largest weight.
+  // A row is the horizontal kernel and a column the vertical one, as in the taps below.
+  auto pivot = (int) (std::max_element(kernel.begin(), kernel.end(), [](float a, float b) {
+    return std::abs(a) < std::abs(b);
+  }) - kernel.begin());
+  auto pivotRow = pivot / size, pivotColumn = pivot % size;
+  auto largest = std::abs(kernel[pivot]);
+  std::vector<float> kernelX((size_t) size), kernelY((size_t) size);
+  for (int i = 0; i < size; i++) {
+    kernelX[i] = largest > 0.0f ? kernel[pivotRow * size + i] / kernel[pivot] : 0.0f;
+    kernelY[i] = kernel[i * size + pivotColumn];
+  }
+  bool separable = true;
+  for (int y = 0; y < size && separable; y++)
+    for (int x = 0; x < size && separable; x++)
+      separable = std::abs(kernelY[y] * kernelX[x] - kernel[y * size + x]) <= largest * 1e-5f;
+
+  if (!separable || !initSeparable(kernelX, kernelY))
+    initKernel(kernel);
+}
+
+ppgso::Convolution::Convolution(const std::vector<float> &kernelX, const std::vector<float> &kernelY, float factor,
+                                float bias) : factor{factor}, bias{bias}, size{(int) std::max(kernelX.size(), kernelY.size())} {
+  checkKernel(kernelX.size());
+  checkKernel(kernelY.size());
+  glGenVertexArrays(1, &vao);
+  if (initSeparable(kernelX, kernelY)) return;
+
+  // Outer product of the two, the shorter kernel is centered
+  std::vector<float> kernel((size_t) (size * size), 0.0f);
+  auto offsetX = (size - (int) kernelX.size()) / 2, offsetY = (size - (int) kernelY.size()) / 2;
+  for (size_t y = 0; y < kernelY.size(); y++)
+    for (size_t x = 0; x < kernelX.size(); x++)
+      kernel[(offsetY + y) * size + offsetX + x] = kernelY[y] * kernelX[x];
+  initKernel(kernel);
+}
+
+ppgso::Convolution::~Convolution() {
+  RenderState::forgetVertexArray(vao);
+  glDeleteVertexArrays(1, &vao);
+}
+
+bool ppgso::Convolution::initSeparable(const std::vector<float> &kernelX, const std::vector<float> &kernelY) {
+  // The first pass is stored in RGBA8, it must neither go negative nor above the brightest input
+  verticalFirst = mixedSigns(kernelX);
+  if (verticalFirst && mixedSigns(kernelY)) return false;
+  auto &first = verticalFirst ? kernelY : kernelX;
+  auto gain = std::accumulate(first.begin(), first.end(), 0.0f);
+  if (gain == 0.0f) gain = 1.0f;
+
+  auto tapsX = linearTaps(kernelX, {1.0f, 0.0f});
+  auto tapsY = linearTaps(kernelY, {0.0f, 1.0f});
+  for (auto &tap : tapsX) tap.weight = verticalFirst ? tap.weight * gain : tap.weight / gain;
+  for (auto &tap : tapsY) tap.weight = verticalFirst ? tap.weight / gain : tap.weight * gain;
+  horizontal = fragmentShader(tapsX);
+  vertical = fragmentShader(tapsY);
+  horizontalTaps = (int) std::max<size_t>(1, tapsX.size());
+  verticalTaps = (int) std::max<size_t>(1, tapsY.size());
+  method = Method::Separable;
+  return true;
+}
+
+void ppgso::Convolution::initKernel(const std::vector<float> &kernel) {
+  std::vector<Tap> taps;
+  int radius = size / 2;
+  for (int y = 0; y < size; y++)
+    for (int x = 0; x < size; x++)
+      if (kernel[y * size + x] != 0.0f)
+        taps.push_back({glm::vec2{x - radius, y - radius}, kernel[y * size + x]});
+  direct = fragmentShader(taps);
+  directTaps = (int) std::max<size_t>(1, taps.size());
+  method = Method::Direct;
+
+  if (radius > MAX_COMPUTE_RADIUS || !GLEW_ARB_compute_shader || !GLEW_ARB_shader_image_load_store) return;
+
+  std::stringstream defines;
+  defines << std::showpoint << std::setprecision(9);
+  defines << "#define RADIUS " << radius << "\n#define KERNEL ";
+  for (size_t i = 0; i < kernel.size(); i++) defines << (i ? ", " : "") << kernel[i];
+  defines << "\n";
+  try {
+    compute = ShaderCache::getCompute(Shader::withDefines(convolution_comp_glsl, defines.str()));
+    method = Method::Compute;
+  } catch (const std::runtime_error &) {
+    // Drivers advertising the extension in a 3.3 context may still refuse #version 430, keep the fragment pass
+  }
+}
+
+std::unique_ptr<ppgso::Convolution> ppgso::Convolution::gaussian(float sigma) {
+  int radius = std::max(1, (int) std::ceil(sigma * 3.0f));
+  std::vector<float> kernel((size_t) (2 * radius + 1));
+  float total = 0;
+  for (int i = -radius; i <= radius; i++) {
+    kernel[i + radius] = std::exp(-(float) (i * i) / (2.0f * sigma * sigma));
+    total += kernel[i + radius];
+  }
+  for (auto &weight : kernel) weight /= total;
+  return std::make_unique<Convolution>(kernel, kernel);
+}
+
+void ppgso::Convolution::apply(Texture &source, RenderTarget &target) {
+  auto depthTest = RenderState::isEnabled(GL_DEPTH_TEST);
+  auto blend = RenderState::isEnabled(GL_BLEND);
+  RenderState::setEnabled(GL_DEPTH_TEST, false);
+  RenderState::setEnabled(GL_BLEND, false);
+
+  bool sameSize = source.getWidth() == target.getWidth() && source.getHeight() == target.getHeight();
+  if (method == Method::Separable) {
+    // First pass keeps the source resolution across its direction so the second one does the only resampling
+    auto intermediate = verticalFirst ? RenderTargetPool::instance().acquire(source.getWidth(), target.getHeight())
+                                      : RenderTargetPool::instance().acquire(target.getWidth(), source.getHeight());
+    draw(verticalFirst ? *vertical : *horizontal, source, *intermediate, 1.0f, 0.0f);
+    draw(verticalFirst ? *horizontal : *vertical, intermediate->getTexture(), target, factor, bias);
+  } else if (method == Method::Compute && sameSize && target.getTexture().getFormat() == Texture::Format::RGBA8) {
+    dispatch(source, target);
+  } else {
+    draw(*direct, source, target, factor, bias);
+  }
+
+  RenderState::setEnabled(GL_DEPTH_TEST, depthTest);
+  RenderState::setEnabled(GL_BLEND, blend);
+}
+
+std::vector<size_t> ppgso::Convolution::addTo(PostChain &chain, float scale) {
+  if (method != Method::Separable)
+    return {chain.addCustom([this](Texture &source, RenderTarget &output) { apply(source, output); }, scale)};
+
+  // Both halves as regular passes, the intermediate target then comes from the chain itself
+  return {
+    chain.add(verticalFirst ? vertical : horizontal, scale, [](const Shader &shader) {
+      shader.setUniform("Factor", 1.0f);
+      shader.setUniform("Bias", 0.0f);
+    }),
+    chain.add(verticalFirst ? horizontal : vertical, scale, [this](const Shader &shader) {
+      shader.setUniform("Factor", factor);
+      shader.setUniform("Bias", bias);
+    })
+  };
+}
+
+ppgso::Convolution::Method ppgso::Convolution::getMethod() const {
+  return method;
+}
+
+float ppgso::Convolution::getFetches() const {
+  switch (method) {
+    case Method::Separable:
+      return (float) (horizontalTaps + verticalTaps);
+    case Method::Compute: {
+      // Whole tile including the halo is loaded once per work group
+      auto tile = (float) (GROUP + size - 1);
+      return tile * tile / (float) (GROUP * GROUP);
+    }
+    case Method::Direct:
+      return (float) directTaps;
+  }
+  return 0.0f;
+}
+
+void ppgso::Convolution::draw(const Shader &shader, Texture &source, RenderTarget &target, float factor,
+                              float bias) const {
+  target.bind();
+  shader.use();
+  shader.setUniform("Source", source, 0);
+  shader.setUniform("TexelSize", glm::vec2{1.0f / (float) source.getWidth(), 1.0f / (float) source.getHeight()});
+  shader.setUniform("Factor", factor);
+  shader.setUniform("Bias", bias);
+  RenderState::bindVertexArray(vao);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ppgso::Convolution::dispatch(Texture &source, RenderTarget &target) const {
+  compute->use();
+  compute->setUniform("Source", source, 0);
+  compute->setUniform("Factor", factor);
+  compute->setUniform("Bias", bias);
+  glBindImageTexture(0, target.getTexture().getTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+  glDispatchCompute((GLuint) (target.getWidth() + GROUP - 1) / GROUP, (GLuint) (target.getHeight() + GROUP - 1) / GROUP, 1);
+
+  // Later passes sample the result or render on top of it
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "shader.h"
+#include "texture.h"
+#include "render_target.h"
+
+namespace ppgso {
+
+  /*!
+   * GPU convolution with a square kernel, the GPU counterpart of image::convolve.
+   *
+   * Kernels of rank one (Gaussian, box, Sobel, ...) are split into a horizontal and a vertical pass,
+   * the half without negative weights runs first as the RGBA8 intermediate cannot hold them. Neighbouring taps of the same sign are merged into one bilinear fetch so a 5x5 Gaussian
+   * needs 3 + 3 fetches instead of 25. Other kernels run as a compute shader that reads each texel
+   * once into shared memory, or as a single fragment pass when compute shaders are not available.
+   */
+  class Convolution {
+  public:
+    enum class Method {
+      Separable,  // Two fragment passes with linear sampling
+      Compute,    // Shared memory compute shader
+      Direct      // Single fragment pass over all non-zero taps
+    };
+
+    /*!
+     * Prepare convolution with a square kernel, separability is detected automatically
+     *
+     * Weights are row major like image::convolve, kernel[y * size + x] is applied to the texel at
+     * offset (x - size / 2, y - size / 2). Rows run along x and texture rows are image rows, so the
+     * GPU and the CPU filters agree for kernels that are not symmetric.
+     *
+     * @param kernel - Row major size x size weights
+     * @param size - Kernel width and height, odd
+     * @param factor - Result is divided by factor (1 default)
+     * @param bias - Added to the result in <0, 1> color range (0 default)
+     */
+    Convolution(const std::vector<float> &kernel, int size, float factor = 1.0f, float bias = 0.0f);
+
+    /*!
+     * Prepare separable convolution from its horizontal and vertical kernels
+     * When both of them mix positive and negative weights the full 2D kernel is used instead.
+     *
+     * @param kernelX - Horizontal kernel, odd number of taps centered on the pixel
+     * @param kernelY - Vertical kernel, odd number of taps centered on the pixel
+     * @param factor - Result is divided by factor (1 default)
+     * @param bias - Added to the result in <0, 1> color range (0 default)
+     */
+    Convolution(const std::vector<float> &kernelX, const std::vector<float> &kernelY, float factor = 1.0f,
+                float bias = 0.0f);
+
+    ~Convolution();
+
+    Convolution(const Convolution&) = delete;
+    Convolution &operator=(const Convolution&) = delete;
+
+    /*!
+     * Gaussian blur with kernel truncated at 3 sigma, matches image::gaussianBlur
+     *
+     * @param sigma - Standard deviation in pixels
+     * @return Separable convolution
+     */
+    static std::unique_ptr<Convolution> gaussian(float sigma);
+
+    /*!
+     * Filter source into target
+     *
+     * @param source - Texture to filter, sampled with linear filtering
+     * @param target - Output, the compute path is used only when it matches the source in size and is RGBA8
+     */
+    void apply(Texture &source, RenderTarget &target);
+
+    /*!
+     * Append the convolution to a post-processing chain, has to outlive the chain
+     *
+     * @param chain - Chain to extend
+     * @param scale - Resolution of the output relative to the screen (1 default)
+     * @return Indices of the added passes for PostChain::setEnabled()
+     */
+    std::vector<size_t> addTo(PostChain &chain, float scale = 1.0f);
+
+    /*!
+     * Get the method chosen for the kernel
+     * @return Separable, Compute or Direct
+     */
+    Method getMethod() const;
+
+    /*!
+     * Get the number of texture fetches needed for one output pixel
+     * @return Fetches of both passes for separable kernels, shared memory loads per pixel for compute
+     */
+    float getFetches() const;
+
+  private:
+    void draw(const Shader &shader, Texture &source, RenderTarget &target, float factor, float bias) const;
+    void dispatch(Texture &source, RenderTarget &target) const;
+    bool initSeparable(const std::vector<float> &kernelX, const std::vector<float> &kernelY);
+    void initKernel(const std::vector<float> &kernel);
+
+    Method method;
+    float factor, bias;
+    int size = 0;
+    std::shared_ptr<Shader> horizontal, vertical, direct, compute;
+    int horizontalTaps = 0, verticalTaps = 0, directTaps = 0;
+    bool verticalFirst = false;
+    GLuint vao = 0;
+  };
+}
@@ -13,6 +13,10 @@ std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() {
   return framebuffer;
 }
 
+const std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() const {
+  return framebuffer;
+}
+
 ppgso::Image::Pixel& ppgso::Image::getPixel(int x, int y) {
   return framebuffer[x+y*width];
 }
@@ -32,3 +36,11 @@ void ppgso::Image::setPixel(int x, int y, int r, int g, int b) {
 void ppgso::Image::setPixel(int x, int y, float r, float g, float b) {
   setPixel(x,y,{clamp(r), clamp(g), clamp(b)});
 }
+
+bool ppgso::Image::hasAlpha() const {
+  return !alpha.empty();
+}
+
+std::vector<uint8_t>& ppgso::Image::getAlpha() {
+  return alpha;
+}
@@ -27,6 +27,13 @@ namespace ppgso {
      */
     std::vector<Pixel>& getFramebuffer();
 
+    /*!
+     * Get read only access to the image data.
+     *
+     * @return - Reference to the raw RGB framebuffer data.
+     */
+    const std::vector<Pixel>& getFramebuffer() const;
+
     /*!
      * Get single pixel from the framebuffer.
      *
@@ -70,9 +77,24 @@ namespace ppgso {
      */
     void clear(const Pixel& color = {0,0,0});
 
+    /*!
+     * Check if the image carries a separate alpha channel
+     * @return True if alpha data is present (e.g. loaded from a 32-bit BMP)
+     */
+    bool hasAlpha() const;
+
+    /*!
+     * Get raw access to the alpha channel, one byte per pixel in framebuffer order.
+     * Empty unless the image was loaded with alpha or the vector was filled by the caller.
+     *
+     * @return - Reference to the alpha channel data.
+     */
+    std::vector<uint8_t>& getAlpha();
+
     int width, height;
   private:
     std::vector<Pixel> framebuffer;
+    std::vector<uint8_t> alpha;
   };
 }
 
@@ -1,7 +1,15 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include "image_bmp.h"
+#include "mapped_file.h"
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <tmmintrin.h>
+#endif
 
 namespace ppgso {
   namespace image {
@@ -33,21 +41,55 @@ namespace ppgso {
     } BITMAPINFOHEADER;
 #pragma pack()
 
+    /*!
+     * Swap the first and third byte of every 3 byte pixel (BGR <-> RGB)
+     * The SSSE3 path shuffles 5 pixels per 16 byte register, the 16th byte is rewritten by the next step.
+     */
+    void swizzleRow(const uint8_t *src, uint8_t *dst, int width) {
+      int i = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+      const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+      for (; i * 3 + 16 <= width * 3; i += 5) {
+        auto bgr = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm_shuffle_epi8(bgr, shuffle));
+      }
+#endif
+      for (; i < width; i++) {
+        uint8_t b = src[i * 3 + 0], g = src[i * 3 + 1], r = src[i * 3 + 2];
+        dst[i * 3 + 0] = r;
+        dst[i * 3 + 1] = g;
+        dst[i * 3 + 2] = b;
+      }
+    }
+
     Image loadBMP(const std::string &bmp) {
       BITMAPFILEHEADER bmpFileHeader = {};
       BITMAPINFOHEADER bmpInfoHeader = {};
 
-      std::ifstream input_file(bmp, std::ios::binary);
-
-      // Check headers
-      if (!input_file.is_open()) {
+      // Map the file, rows are converted straight from the page cache
+      std::unique_ptr<MappedFile> file;
+      try {
+        file = std::make_unique<MappedFile>(bmp);
+      } catch (std::runtime_error &) {
         std::stringstream msg;
         msg << "Could not open BMP file. " << bmp;
         throw std::runtime_error(msg.str());
       }
+      auto data = file->data();
+      auto size = file->size();
+
+      // Bounds checked access into the mapping
+      auto read = [&](size_t offset, size_t length) {
+        if (offset + length > size) {
+          std::stringstream msg;
+          msg << "BMP file is truncated. " << bmp;
+          throw std::runtime_error(msg.str());
+        }
+        return data + offset;
+      };
 
-      input_file.read((char *) &bmpFileHeader, sizeof(BITMAPFILEHEADER));
-      input_file.read((char *) &bmpInfoHeader, sizeof(BITMAPINFOHEADER));
+      std::memcpy(&bmpFileHeader, read(0, sizeof(BITMAPFILEHEADER)), sizeof(BITMAPFILEHEADER));
+      std::memcpy(&bmpInfoHeader, read(sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER)), sizeof(BITMAPINFOHEADER));
 
       if (bmpFileHeader.bfType != 19778) {
         std::stringstream msg;
@@ -55,13 +97,16 @@ namespace ppgso {
         throw std::runtime_error(msg.str());
       }
 
-      if (bmpInfoHeader.biBitCount != 24) {
+      auto bitCount = bmpInfoHeader.biBitCount;
+      if (bitCount != 8 && bitCount != 24 && bitCount != 32) {
         std::stringstream msg;
         msg << "BMP file does not contain supported bit count. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      if (bmpInfoHeader.biCompression != 0) { // BI_RGB only
+      // BI_RGB for all depths, BI_RLE8 for 8-bit and BI_BITFIELDS for 32-bit
+      auto compression = bmpInfoHeader.biCompression;
+      if (compression != 0 && !(bitCount == 8 && compression == 1) && !(bitCount == 32 && compression == 3)) {
         std::stringstream msg;
         msg << "BMP file does not use expected compression method. " << bmp;
         throw std::runtime_error(msg.str());
@@ -77,33 +122,128 @@ namespace ppgso {
         throw std::runtime_error(msg.str());
       }
 
+      // Channel masks for 32-bit data, stored right after the 40 byte info header
+      // either as part of a V4/V5 header or as an extra BI_BITFIELDS block
+      unsigned int masks[4] = {0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000};
+      bool hasAlpha = bitCount == 32;
+      if (bitCount == 32 && compression == 3) {
+        size_t maskBytes = bmpInfoHeader.biSize >= 56 ? 16 : 12;
+        std::memcpy(masks, read(sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER), maskBytes), maskBytes);
+        if (bmpInfoHeader.biSize < 56) masks[3] = 0;
+        hasAlpha = masks[3] != 0;
+      }
+      int shifts[4];
+      for (int c = 0; c < 4; c++) {
+        shifts[c] = 0;
+        while (masks[c] && !((masks[c] >> shifts[c]) & 1)) shifts[c]++;
+      }
+
+      // Colour table for 8-bit palettized data, stored as BGRX quads
+      std::vector<Image::Pixel> palette;
+      if (bitCount == 8) {
+        auto colors = bmpInfoHeader.biClrUsed ? bmpInfoHeader.biClrUsed : 256;
+        colors = std::min(colors, 256u);
+        auto quads = read(sizeof(BITMAPFILEHEADER) + bmpInfoHeader.biSize, colors * 4);
+        palette.resize(256, {0, 0, 0});
+        for (unsigned int i = 0; i < colors && i < 256; i++)
+          palette[i] = {quads[i * 4 + 2], quads[i * 4 + 1], quads[i * 4 + 0]};
+      }
+
       Image image{width, height};
       auto &framebuffer = image.getFramebuffer();
-
-      // Load data
-      input_file.seekg(bmpFileHeader.bfOffBits, input_file.beg);
+      auto &alpha = image.getAlpha();
+      if (hasAlpha) alpha.resize(framebuffer.size());
 
       // BMP uses padding for rows
-      unsigned int row_padded = (width * sizeof(Image::Pixel) + 3) & (~3);
+      unsigned int bytes = bitCount / 8;
+      unsigned int row_padded = (width * bytes + 3) & (~3);
 
-      for (int j = 0; j < height; j++) {
-        auto row_data = std::vector<Image::Pixel>(row_padded);
-        input_file.read((char *) row_data.data(), row_padded);
-        for (int i = 0; i < width; i++) {
-          auto pixel = row_data[i];
-          std::swap(pixel.r, pixel.b);
-          if (flipped) {
-            framebuffer[i + j * width] = pixel;
+      if (compression == 1) {
+        // Run length encoded indices, rows are always stored bottom-up
+        std::vector<uint8_t> indices((size_t) (width * height), 0);
+        auto encodedSize = size > bmpFileHeader.bfOffBits ? size - bmpFileHeader.bfOffBits : 0;
+        auto encoded = read(bmpFileHeader.bfOffBits, encodedSize);
+
+        size_t pos = 0;
+        int x = 0, y = 0;
+        while (pos + 1 < encodedSize && y < height) {
+          uint8_t count = encoded[pos++], value = encoded[pos++];
+          if (count > 0) {
+            for (int k = 0; k < count && x < width; k++) indices[x++ + y * width] = value;
+          } else if (value == 0) {
+            x = 0; y++;                          // End of line
+          } else if (value == 1) {
+            break;                               // End of bitmap
+          } else if (value == 2) {
+            if (pos + 1 >= encodedSize) break;
+            x += encoded[pos++]; y += encoded[pos++]; // Delta
           } else {
-            framebuffer[i + (height - 1 - j) * width] = pixel;
+            for (int k = 0; k < value && pos < encodedSize; k++, pos++)
+              if (x < width) indices[x++ + y * width] = encoded[pos];
+            pos += value & 1;                    // Absolute runs are word aligned
+          }
+        }
+
+        for (int j = 0; j < height; j++)
+          for (int i = 0; i < width; i++)
+            framebuffer[i + (height - 1 - j) * width] = palette[indices[i + j * width]];
+      } else {
+        auto rows = read(bmpFileHeader.bfOffBits, (size_t) row_padded * (height - 1) + width * bytes);
+        for (int j = 0; j < height; j++) {
+          auto row = flipped ? j : height - 1 - j;
+          auto pixels = &framebuffer[row * width];
+          auto src = rows + (size_t) row_padded * j;
+
+          switch (bitCount) {
+            case 8:
+              for (int i = 0; i < width; i++)
+                pixels[i] = palette[src[i]];
+              break;
+            case 24:
+              swizzleRow(src, (uint8_t *) pixels, width);
+              break;
+            case 32:
+              for (int i = 0; i < width; i++, src += 4) {
+                unsigned int value = src[0] | (src[1] << 8) | (src[2] << 16) | ((unsigned int) src[3] << 24);
+                pixels[i] = {(uint8_t) ((value & masks[0]) >> shifts[0]),
+                             (uint8_t) ((value & masks[1]) >> shifts[1]),
+                             (uint8_t) ((value & masks[2]) >> shifts[2])};
+                if (hasAlpha) alpha[row * width + i] = (uint8_t) ((value & masks[3]) >> shifts[3]);
+              }
+              break;
           }
         }
       }
-      input_file.close();
+
+      // Plenty of writers leave the fourth byte of BI_RGB data zeroed, treat that as opaque
+      if (hasAlpha && std::all_of(alpha.begin(), alpha.end(), [](uint8_t a) { return a == 0; }))
+        alpha.clear();
 
       return image;
     }
 
+    std::vector<Image> loadBMPs(const std::vector<std::string> &bmps) {
+      std::vector<Image> images(bmps.size(), Image{0, 0});
+      std::vector<std::string> errors(bmps.size());
+
+      // Exceptions must not escape the parallel region
+      #pragma omp parallel for schedule(dynamic)
+      for (int i = 0; i < (int) bmps.size(); i++) {
+        try {
+          images[i] = loadBMP(bmps[i]);
+        } catch (std::exception &e) {
+          errors[i] = e.what();
+        }
+      }
+
+      std::stringstream msg;
+      for (auto &error : errors)
+        if (!error.empty()) msg << error << std::endl;
+      if (!msg.str().empty()) throw std::runtime_error(msg.str());
+
+      return images;
+    }
+
     void saveBMP(ppgso::Image &image, const std::string &bmp) {
       auto width = image.width;
       auto height = image.height;
@@ -145,13 +285,9 @@ namespace ppgso {
       // Prepare BRG output data by swapping RGB to BRG and mirroring along height
       output_file.seekp(bmpFileHeader.bfOffBits, output_file.beg);
 
+      auto output_row = std::vector<uint8_t>(row_padded, 0);
       for (int j = 0; j < height; j++) {
-        auto output_row = std::vector<Image::Pixel>(row_padded);
-        for (int i = 0; i < width; i++) {
-          auto pixel = framebuffer[i + (height - 1 - j) * width];
-          std::swap(pixel.r, pixel.b);
-          output_row[i] = pixel;
-        }
+        swizzleRow((const uint8_t *) &framebuffer[(height - 1 - j) * width], output_row.data(), width);
         output_file.write((char *) output_row.data(), row_padded);
       }
 
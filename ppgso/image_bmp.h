@@ -4,12 +4,22 @@
 namespace ppgso {
 namespace image {
 /*!
- * Load BMP image from file. Only uncompressed RGB format is supported.
+ * Load BMP image from file. Uncompressed 8-bit palettized, 24-bit RGB and 32-bit
+ * RGBA/BITFIELDS data is supported along with RLE8, alpha ends up in Image::getAlpha().
  *
  * @param bmp - File path to a BMP image.
  */
   ppgso::Image loadBMP(const std::string &bmp);
 
+/*!
+ * Load multiple BMP images in parallel, one file per thread.
+ * All files are attempted, errors are collected and thrown together afterwards.
+ *
+ * @param bmps - File paths to BMP images.
+ * @return Images in the same order as the paths.
+ */
+  std::vector<ppgso::Image> loadBMPs(const std::vector<std::string> &bmps);
+
 /*!
  * Save as BMP image.
  * @param image - Image to save.
@@ -0,0 +1,158 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "image_dds.h"
+
+namespace ppgso {
+
+  size_t CompressedImage::blockBytes(Format format) {
+    return format == Format::BC1 || format == Format::BC1_SRGB ? 8 : 16;
+  }
+
+  size_t CompressedImage::levelBytes(Format format, int width, int height) {
+    size_t blocksX = (size_t) std::max(1, (width + 3) / 4);
+    size_t blocksY = (size_t) std::max(1, (height + 3) / 4);
+    return blocksX * blocksY * blockBytes(format);
+  }
+
+  namespace image {
+
+// Structs for reading DDS files
+#pragma pack(4)
+    typedef struct /**** DDS pixel format ****/
+    {
+      uint32_t dwSize;
+      uint32_t dwFlags;
+      uint32_t dwFourCC;
+      uint32_t dwRGBBitCount;
+      uint32_t dwRBitMask;
+      uint32_t dwGBitMask;
+      uint32_t dwBBitMask;
+      uint32_t dwABitMask;
+    } DDS_PIXELFORMAT;
+
+    typedef struct /**** DDS header following the magic number ****/
+    {
+      uint32_t dwSize;
+      uint32_t dwFlags;
+      uint32_t dwHeight;
+      uint32_t dwWidth;
+      uint32_t dwPitchOrLinearSize;
+      uint32_t dwDepth;
+      uint32_t dwMipMapCount;
+      uint32_t dwReserved1[11];
+      DDS_PIXELFORMAT ddspf;
+      uint32_t dwCaps;
+      uint32_t dwCaps2;
+      uint32_t dwCaps3;
+      uint32_t dwCaps4;
+      uint32_t dwReserved2;
+    } DDS_HEADER;
+
+    typedef struct /**** Extended header present when FourCC is DX10 ****/
+    {
+      uint32_t dxgiFormat;
+      uint32_t resourceDimension;
+      uint32_t miscFlag;
+      uint32_t arraySize;
+      uint32_t miscFlags2;
+    } DDS_HEADER_DXT10;
+#pragma pack()
+
+    constexpr uint32_t fourCC(char a, char b, char c, char d) {
+      return (uint32_t) a | ((uint32_t) b << 8) | ((uint32_t) c << 16) | ((uint32_t) d << 24);
+    }
+
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+
+    CompressedImage loadDDS(const std::string &dds) {
+      std::ifstream input_file(dds, std::ios::binary);
+
+      if (!input_file.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open DDS file. " << dds;
+        throw std::runtime_error(msg.str());
+      }
+
+      uint32_t magic = 0;
+      DDS_HEADER header = {};
+      input_file.read((char *) &magic, sizeof(magic));
+      input_file.read((char *) &header, sizeof(DDS_HEADER));
+
+      if (magic != fourCC('D', 'D', 'S', ' ') || header.dwSize != sizeof(DDS_HEADER)) {
+        std::stringstream msg;
+        msg << "DDS file does not contain supported DDS format. " << dds;
+        throw std::runtime_error(msg.str());
+      }
+
+      if (!(header.ddspf.dwFlags & DDPF_FOURCC)) {
+        std::stringstream msg;
+        msg << "DDS file is not block compressed. " << dds;
+        throw std::runtime_error(msg.str());
+      }
+
+      CompressedImage image;
+      image.width = (int) header.dwWidth;
+      image.height = (int) header.dwHeight;
+
+      switch (header.ddspf.dwFourCC) {
+        case fourCC('D', 'X', 'T', '1'): image.format = CompressedImage::Format::BC1; break;
+        case fourCC('D', 'X', 'T', '5'): image.format = CompressedImage::Format::BC3; break;
+        case fourCC('A', 'T', 'I', '2'):
+        case fourCC('B', 'C', '5', 'U'): image.format = CompressedImage::Format::BC5; break;
+        case fourCC('D', 'X', '1', '0'): {
+          DDS_HEADER_DXT10 header10 = {};
+          input_file.read((char *) &header10, sizeof(DDS_HEADER_DXT10));
+          switch (header10.dxgiFormat) {
+            case 71: image.format = CompressedImage::Format::BC1; break;      // DXGI_FORMAT_BC1_UNORM
+            case 72: image.format = CompressedImage::Format::BC1_SRGB; break; // DXGI_FORMAT_BC1_UNORM_SRGB
+            case 77: image.format = CompressedImage::Format::BC3; break;      // DXGI_FORMAT_BC3_UNORM
+            case 78: image.format = CompressedImage::Format::BC3_SRGB; break; // DXGI_FORMAT_BC3_UNORM_SRGB
+            case 83: image.format = CompressedImage::Format::BC5; break;      // DXGI_FORMAT_BC5_UNORM
+            default: {
+              std::stringstream msg;
+              msg << "DDS file uses unsupported DXGI format " << header10.dxgiFormat << ". " << dds;
+              throw std::runtime_error(msg.str());
+            }
+          }
+          if (header10.arraySize > 1 || header10.resourceDimension != 3) { // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            std::stringstream msg;
+            msg << "DDS file does not contain a single 2D texture. " << dds;
+            throw std::runtime_error(msg.str());
+          }
+          break;
+        }
+        default: {
+          std::stringstream msg;
+          msg << "DDS file uses unsupported compression. " << dds;
+          throw std::runtime_error(msg.str());
+        }
+      }
+
+      if (image.width == 0 || image.height == 0) {
+        std::stringstream msg;
+        msg << "DDS file does not contain any data. " << dds;
+        throw std::runtime_error(msg.str());
+      }
+
+      // Levels are stored largest first, each tightly packed
+      int levels = (header.dwFlags & DDSD_MIPMAPCOUNT) ? std::max(1, (int) header.dwMipMapCount) : 1;
+      int width = image.width, height = image.height;
+      for (int level = 0; level < levels; level++) {
+        std::vector<uint8_t> data(CompressedImage::levelBytes(image.format, width, height));
+        input_file.read((char *) data.data(), data.size());
+        if (!input_file) {
+          std::stringstream msg;
+          msg << "DDS file is truncated at mip level " << level << ". " << dds;
+          throw std::runtime_error(msg.str());
+        }
+        image.levels.push_back(std::move(data));
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+      }
+
+      return image;
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ppgso {
+
+  /*!
+   * Block compressed image as stored in a pre-compressed container.
+   * Each mip level keeps its raw 4x4 block data ready for direct upload.
+   */
+  struct CompressedImage {
+    enum class Format {
+      BC1,      // RGB(A1), 8 bytes per block
+      BC1_SRGB,
+      BC3,      // RGBA, 16 bytes per block
+      BC3_SRGB,
+      BC5       // Two channel (normal maps), 16 bytes per block
+    };
+
+    /*!
+     * Size of a single 4x4 block in bytes
+     * @param format - Block compression format
+     * @return Number of bytes per block
+     */
+    static size_t blockBytes(Format format);
+
+    /*!
+     * Size of a single mip level in bytes
+     * @param format - Block compression format
+     * @param width - Width of the level in pixels
+     * @param height - Height of the level in pixels
+     * @return Number of bytes needed to store the level
+     */
+    static size_t levelBytes(Format format, int width, int height);
+
+    int width = 0, height = 0;
+    Format format = Format::BC1;
+    std::vector<std::vector<uint8_t>> levels;
+  };
+
+  namespace image {
+/*!
+ * Load block compressed image from a DDS file. BC1 (DXT1), BC3 (DXT5) and BC5 (ATI2/BC5U)
+ * are supported through both the legacy FourCC and the DX10 extended header.
+ *
+ * @param dds - File path to a DDS image.
+ */
+    CompressedImage loadDDS(const std::string &dds);
+  }
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "image_filter.h"
+
+namespace {
+  // Rows processed per tile, the horizontal pass of a tile stays in L2 for the vertical pass
+  const int STRIP = 32;
+
+  /*!
+   * out[i] += weight * in[i] for n floats, 8 or 4 lanes at a time
+   */
+  void multiplyAdd(float *out, const float *in, float weight, int n) {
+    int i = 0;
+#if defined(__AVX__)
+    auto w8 = _mm256_set1_ps(weight);
+    for (; i + 8 <= n; i += 8) {
+#if defined(__FMA__)
+      auto sum = _mm256_fmadd_ps(_mm256_loadu_ps(in + i), w8, _mm256_loadu_ps(out + i));
+#else
+      auto sum = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), w8), _mm256_loadu_ps(out + i));
+#endif
+      _mm256_storeu_ps(out + i, sum);
+    }
+#endif
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+    auto w4 = _mm_set1_ps(weight);
+    for (; i + 4 <= n; i += 4)
+      _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), w4), _mm_loadu_ps(out + i)));
+#endif
+    for (; i < n; i++)
+      out[i] += weight * in[i];
+  }
+
+  /*!
+   * Convert row y to floats with pad pixels of clamped edge on both sides
+   */
+  void loadRow(const ppgso::Image &image, int y, int pad, float *out) {
+    auto &framebuffer = image.getFramebuffer();
+    y = std::min(std::max(y, 0), image.height - 1);
+    auto row = (const uint8_t *) &framebuffer[y * image.width];
+    auto first = row, last = row + (image.width - 1) * 3;
+    for (int i = 0; i < pad; i++, out += 3) {
+      out[0] = first[0]; out[1] = first[1]; out[2] = first[2];
+    }
+    for (int i = 0; i < image.width * 3; i++)
+      *out++ = row[i];
+    for (int i = 0; i < pad; i++, out += 3) {
+      out[0] = last[0]; out[1] = last[1]; out[2] = last[2];
+    }
+  }
+
+  /*!
+   * Round and clamp n floats to bytes
+   */
+  void storeRow(const float *in, uint8_t *out, int n) {
+    for (int i = 0; i < n; i++)
+      out[i] = (uint8_t) std::min(std::max(in[i] + 0.5f, 0.0f), 255.0f);
+  }
+
+  void checkKernel(size_t taps) {
+    if (taps % 2 == 0) {
+      std::stringstream msg;
+      msg << "Convolution kernel needs an odd number of taps, got " << taps;
+      throw std::invalid_argument(msg.str());
+    }
+  }
+}
+
+namespace ppgso {
+  namespace image {
+
+    Image convolveSeparable(const Image &image, const std::vector<float> &kernelX, const std::vector<float> &kernelY) {
+      checkKernel(kernelX.size());
+      checkKernel(kernelY.size());
+
+      Image result{image.width, image.height};
+      auto &framebuffer = result.getFramebuffer();
+      int rx = (int) kernelX.size() / 2, ry = (int) kernelY.size() / 2;
+      int stride = image.width * 3;
+      int strips = (image.height + STRIP - 1) / STRIP;
+
+      #pragma omp parallel for schedule(dynamic)
+      for (int strip = 0; strip < strips; strip++) {
+        int y0 = strip * STRIP, y1 = std::min(image.height, y0 + STRIP);
+        int rows = y1 - y0 + 2 * ry;
+        std::vector<float> padded((size_t) (image.width + 2 * rx) * 3);
+        std::vector<float> horizontal((size_t) rows * stride, 0.0f);
+        std::vector<float> sum((size_t) stride);
+
+        // Horizontal pass over the strip and its vertical halo
+        for (int row = 0; row < rows; row++) {
+          loadRow(image, y0 - ry + row, rx, padded.data());
+          for (int tap = 0; tap < (int) kernelX.size(); tap++)
+            multiplyAdd(&horizontal[(size_t) row * stride], padded.data() + tap * 3, kernelX[tap], stride);
+        }
+
+        // Vertical pass straight from the tile
+        for (int y = y0; y < y1; y++) {
+          std::fill(sum.begin(), sum.end(), 0.0f);
+          for (int tap = 0; tap < (int) kernelY.size(); tap++)
+            multiplyAdd(sum.data(), &horizontal[(size_t) (y - y0 + tap) * stride], kernelY[tap], stride);
+          storeRow(sum.data(), (uint8_t *) &framebuffer[y * image.width], stride);
+        }
+      }
+      return result;
+    }
+
+    Image convolve(const Image &image, const std::vector<float> &kernel, int size, float factor, float bias) {
+      checkKernel((size_t) size);
+      if (kernel.size() != (size_t) (size * size)) {
+        std::stringstream msg;
+        msg << "Convolution kernel of size " << size << " needs " << size * size << " weights, got " << kernel.size();
+        throw std::invalid_argument(msg.str());
+      }
+
+      Image result{image.width, image.height};
+      auto &framebuffer = result.getFramebuffer();
+      int radius = size / 2;
+      int stride = image.width * 3;
+      int paddedStride = (image.width + 2 * radius) * 3;
+      int strips = (image.height + STRIP - 1) / STRIP;
+
+      #pragma omp parallel for schedule(dynamic)
+      for (int strip = 0; strip < strips; strip++) {
+        int y0 = strip * STRIP, y1 = std::min(image.height, y0 + STRIP);
+        int rows = y1 - y0 + 2 * radius;
+        std::vector<float> padded((size_t) rows * paddedStride);
+        std::vector<float> sum((size_t) stride);
+
+        for (int row = 0; row < rows; row++)
+          loadRow(image, y0 - radius + row, radius, &padded[(size_t) row * paddedStride]);
+
+        for (int y = y0; y < y1; y++) {
+          std::fill(sum.begin(), sum.end(), bias * 255.0f);
+          for (int ky = 0; ky < size; ky++) {
+            auto source = &padded[(size_t) (y - y0 + ky) * paddedStride];
+            for (int kx = 0; kx < size; kx++)
+              multiplyAdd(sum.data(), source + kx * 3, kernel[ky * size + kx] / factor, stride);
+          }
+          storeRow(sum.data(), (uint8_t *) &framebuffer[y * image.width], stride);
+        }
+      }
+      return result;
+    }
+
+    Image boxBlur(const Image &image, int radius) {
+      std::vector<float> kernel((size_t) (2 * radius + 1), 1.0f / (float) (2 * radius + 1));
+      return convolveSeparable(image, kernel, kernel);
+    }
+
+    Image gaussianBlur(const Image &image, float sigma) {
+      int radius = std::max(1, (int) std::ceil(sigma * 3.0f));
+      std::vector<float> kernel((size_t) (2 * radius + 1));
+      float total = 0;
+      for (int i = -radius; i <= radius; i++) {
+        kernel[i + radius] = std::exp(-(float) (i * i) / (2.0f * sigma * sigma));
+        total += kernel[i + radius];
+      }
+      for (auto &weight : kernel) weight /= total;
+      return convolveSeparable(image, kernel, kernel);
+    }
+
+    Image colorMatrix(const Image &image, const glm::mat3 &matrix, const glm::vec3 &offset) {
+      Image result{image.width, image.height};
+      auto &source = image.getFramebuffer();
+      auto &target = result.getFramebuffer();
+      auto count = (int) source.size();
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+      // One pixel per register, r * column0 + g * column1 + b * column2 + offset
+      auto column0 = _mm_setr_ps(matrix[0][0], matrix[0][1], matrix[0][2], 0);
+      auto column1 = _mm_setr_ps(matrix[1][0], matrix[1][1], matrix[1][2], 0);
+      auto column2 = _mm_setr_ps(matrix[2][0], matrix[2][1], matrix[2][2], 0);
+      auto shift = _mm_setr_ps(offset.r * 255.0f + 0.5f, offset.g * 255.0f + 0.5f, offset.b * 255.0f + 0.5f, 0);
+      auto low = _mm_setzero_ps(), high = _mm_set1_ps(255.0f);
+
+      #pragma omp parallel for
+      for (int i = 0; i < count; i++) {
+        auto &pixel = source[i];
+        auto color = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(pixel.r)),
+                                           _mm_mul_ps(column1, _mm_set1_ps(pixel.g))),
+                                _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(pixel.b)), shift));
+        color = _mm_min_ps(_mm_max_ps(color, low), high);
+        alignas(16) float values[4];
+        _mm_store_ps(values, color);
+        target[i] = {(uint8_t) values[0], (uint8_t) values[1], (uint8_t) values[2]};
+      }
+#else
+      #pragma omp parallel for
+      for (int i = 0; i < count; i++) {
+        auto &pixel = source[i];
+        auto color = matrix * glm::vec3{pixel.r, pixel.g, pixel.b} + offset * 255.0f + 0.5f;
+        color = glm::clamp(color, 0.0f, 255.0f);
+        target[i] = {(uint8_t) color.r, (uint8_t) color.g, (uint8_t) color.b};
+      }
+#endif
+      return result;
+    }
+
+    Image sharpen(const Image &image, float amount, float sigma) {
+      auto result = gaussianBlur(image, sigma);
+      auto source = (const uint8_t *) image.getFramebuffer().data();
+      auto target = (uint8_t *) result.getFramebuffer().data();
+      auto count = (int) result.getFramebuffer().size() * 3;
+
+      // Blurred image is replaced in place by the sharpened one
+      #pragma omp parallel for
+      for (int i = 0; i < count; i++) {
+        float value = source[i] + amount * (float) (source[i] - target[i]) + 0.5f;
+        target[i] = (uint8_t) std::min(std::max(value, 0.0f), 255.0f);
+      }
+      return result;
+    }
+  }
+}
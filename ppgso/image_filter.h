@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "image.h"
+
+namespace ppgso {
+  namespace image {
+/*!
+ * Convolve image with a separable kernel, first along rows then along columns.
+ * Pixels outside the image are clamped to the nearest edge.
+ *
+ * @param image - Image to filter.
+ * @param kernelX - Horizontal kernel, odd number of taps centered on the pixel.
+ * @param kernelY - Vertical kernel, odd number of taps centered on the pixel.
+ * @return Filtered image.
+ */
+  Image convolveSeparable(const Image &image, const std::vector<float> &kernelX, const std::vector<float> &kernelY);
+
+/*!
+ * Convolve image with a square kernel, the CPU counterpart of ppgso::Convolution.
+ *
+ * @param image - Image to filter.
+ * @param kernel - Row major size x size weights.
+ * @param size - Kernel width and height, odd.
+ * @param factor - Result is divided by factor.
+ * @param bias - Added to the result, in <0, 1> color range.
+ * @return Filtered image.
+ */
+  Image convolve(const Image &image, const std::vector<float> &kernel, int size, float factor = 1.0f, float bias = 0.0f);
+
+/*!
+ * Average of a (2 * radius + 1)^2 neighbourhood.
+ *
+ * @param image - Image to filter.
+ * @param radius - Radius of the box in pixels.
+ * @return Filtered image.
+ */
+  Image boxBlur(const Image &image, int radius);
+
+/*!
+ * Gaussian blur with kernel truncated at 3 sigma.
+ *
+ * @param image - Image to filter.
+ * @param sigma - Standard deviation in pixels.
+ * @return Filtered image.
+ */
+  Image gaussianBlur(const Image &image, float sigma);
+
+/*!
+ * Transform every pixel as color * matrix + offset, colors in <0, 1> range.
+ * Grayscale, sepia, inversion and saturation changes are all expressible this way.
+ *
+ * @param image - Image to filter.
+ * @param matrix - Color transformation, columns are the contributions of r, g and b.
+ * @param offset - Color added after the transformation.
+ * @return Filtered image.
+ */
+  Image colorMatrix(const Image &image, const glm::mat3 &matrix, const glm::vec3 &offset = glm::vec3{0});
+
+/*!
+ * Unsharp mask, image + amount * (image - gaussianBlur(image, sigma)).
+ *
+ * @param image - Image to filter.
+ * @param amount - Strength of the sharpening.
+ * @param sigma - Size of the detail to enhance in pixels.
+ * @return Filtered image.
+ */
+  Image sharpen(const Image &image, float amount = 1.0f, float sigma = 1.0f);
+  }
+}
@@ -1,7 +1,10 @@
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <memory>
 
 #include "image.h"
+#include "mapped_file.h"
 
 namespace ppgso {
   namespace image {
@@ -10,18 +13,25 @@ namespace ppgso {
       Image image{width, height};
       auto &framebuffer = image.getFramebuffer();
 
-      // Open file stream
-      std::ifstream image_stream(raw, std::ios::binary);
-
-      if (!image_stream.is_open()) {
+      // Map the file, the data is already in framebuffer layout
+      std::unique_ptr<MappedFile> file;
+      try {
+        file = std::make_unique<MappedFile>(raw);
+      } catch (std::runtime_error &) {
         std::stringstream msg;
         msg << "Could not open image " << raw;
         throw std::runtime_error(msg.str());
       }
 
+      auto bytes = framebuffer.size() * sizeof(Image::Pixel);
+      if (file->size() < bytes) {
+        std::stringstream msg;
+        msg << "Image " << raw << " is smaller than " << width << "x" << height << " RGB pixels";
+        throw std::runtime_error(msg.str());
+      }
+
       // Load the data
-      image_stream.read((char *) framebuffer.data(), framebuffer.size() * sizeof(Image::Pixel));
-      image_stream.close();
+      std::memcpy(framebuffer.data(), file->data(), bytes);
       return image;
     }
 
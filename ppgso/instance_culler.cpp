@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <shaders/instance_cull_comp_glsl.h>
+
+#include "instance_culler.h"
+#include "render_state.h"
+#include "resource_cache.h"
+
+namespace {
+  // Invocations per work group of instance_cull_comp.glsl
+  const GLuint GROUP = 64;
+
+  size_t indexSize(GLenum type) {
+    switch (type) {
+      case GL_UNSIGNED_BYTE:
+        return 1;
+      case GL_UNSIGNED_SHORT:
+        return 2;
+      default:
+        return 4;
+    }
+  }
+}
+
+constexpr size_t ppgso::InstanceCuller::MAX_LEVELS;
+
+bool ppgso::InstanceCuller::isSupported() {
+  return GLEW_VERSION_4_3 != 0;
+}
+
+ppgso::InstanceCuller::InstanceCuller(const std::vector<MeshPart> &parts, float radius, size_t capacity)
+        : parts{parts}, capacity{std::max<size_t>(capacity, 1)}, radius{radius} {
+  if (!isSupported())
+    throw std::runtime_error("InstanceCuller needs an OpenGL 4.3 context");
+  if (parts.empty())
+    throw std::runtime_error("InstanceCuller needs a mesh with indexed triangles");
+
+  for (auto &part : parts) levels = std::max(levels, std::min(part.lods.size(), MAX_LEVELS));
+
+  // Commands of a part are in level order, parts with fewer levels repeat their coarsest one
+  for (auto &part : this->parts) {
+    for (size_t level = 0; level < levels; level++) {
+      auto &lod = part.lods[std::min(level, part.lods.size() - 1)];
+      Command command;
+      command.count = (GLuint) lod.count;
+      command.instanceCount = 0;
+      command.firstIndex = (GLuint) (lod.offset / indexSize(part.indexType));
+      command.baseVertex = 0;
+      command.baseInstance = 0;
+      commands.push_back(command);
+    }
+  }
+
+  compute = ShaderCache::getCompute(instance_cull_comp_glsl);
+
+  glGenBuffers(1, &instanceBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (this->capacity * sizeof(glm::mat4)), nullptr, GL_DYNAMIC_DRAW);
+  glGenBuffers(1, &visibleBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (levels * this->capacity * sizeof(glm::mat4)), nullptr,
+               GL_DYNAMIC_COPY);
+  glGenBuffers(1, &commandBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (commands.size() * sizeof(Command)), commands.data(),
+               GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+ppgso::InstanceCuller::~InstanceCuller() {
+  glDeleteBuffers(1, &commandBuffer);
+  glDeleteBuffers(1, &visibleBuffer);
+  glDeleteBuffers(1, &instanceBuffer);
+}
+
+void ppgso::InstanceCuller::setInstances(const std::vector<glm::mat4> &models) {
+  instanceCount = std::min(models.size(), capacity);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) (instanceCount * sizeof(glm::mat4)), models.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ppgso::InstanceCuller::setInstanceCount(size_t count) {
+  instanceCount = std::min(count, capacity);
+}
+
+void ppgso::InstanceCuller::setThresholds(const std::vector<float> &sizes) {
+  thresholds = sizes;
+}
+
+void ppgso::InstanceCuller::cull(const glm::mat4 &projectionMatrix, const glm::mat4 &viewMatrix) {
+  // Counts start from zero, the rest of every command stays as built
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) (commands.size() * sizeof(Command)), commands.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  if (!instanceCount) return;
+
+  // Planes of the clip space cube in world space (Gribb and Hartmann), normalized for sphere distances
+  auto matrix = glm::transpose(projectionMatrix * viewMatrix);
+  glm::vec4 planes[6] = {matrix[3] + matrix[0], matrix[3] - matrix[0], matrix[3] + matrix[1],
+                         matrix[3] - matrix[1], matrix[3] + matrix[2], matrix[3] - matrix[2]};
+  for (auto &plane : planes) plane /= glm::length(glm::vec3{plane});
+
+  float sizes[MAX_LEVELS - 1] = {};
+  for (size_t i = 0; i < MAX_LEVELS - 1; i++) sizes[i] = i < thresholds.size() ? thresholds[i] : 0.0f;
+
+  compute->use();
+  glUniform1ui(compute->getUniformLocation("InstanceCount"), (GLuint) instanceCount);
+  glUniform1ui(compute->getUniformLocation("Capacity"), (GLuint) capacity);
+  glUniform1ui(compute->getUniformLocation("Parts"), (GLuint) parts.size());
+  glUniform1ui(compute->getUniformLocation("Levels"), (GLuint) levels);
+  glUniform4fv(compute->getUniformLocation("Planes"), 6, glm::value_ptr(planes[0]));
+  glUniform1fv(compute->getUniformLocation("Thresholds"), MAX_LEVELS - 1, sizes);
+  compute->setUniform("ViewMatrix", viewMatrix);
+  compute->setUniform("ProjectionScale", projectionMatrix[1][1]);
+  compute->setUniform("Radius", radius);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+  glDispatchCompute((GLuint) ((instanceCount + GROUP - 1) / GROUP), 1, 1);
+
+  // The draws read the counts as commands and the matrices from the vertex shader
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ppgso::InstanceCuller::draw(const Shader &shader) const {
+  shader.use();
+  auto base = shader.getUniformLocation("InstanceBase");
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+  for (size_t part = 0; part < parts.size(); part++) {
+    RenderState::bindVertexArray(parts[part].vao);
+    for (size_t level = 0; level < levels; level++) {
+      glUniform1i(base, (GLint) (level * capacity));
+      glDrawElementsIndirect(GL_TRIANGLES, parts[part].indexType,
+                             (const void *) ((part * levels + level) * sizeof(Command)));
+      // Triangles are only known to the GPU, read them back with readVisible when needed
+      RenderState::countDraw(0);
+    }
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+std::vector<size_t> ppgso::InstanceCuller::readVisible() const {
+  std::vector<Command> result(levels);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) (levels * sizeof(Command)), result.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  std::vector<size_t> visible;
+  for (auto &command : result) visible.push_back(command.instanceCount);
+  return visible;
+}
+
+GLuint ppgso::InstanceCuller::getInstanceBuffer() const {
+  return instanceBuffer;
+}
+
+size_t ppgso::InstanceCuller::getInstanceCount() const {
+  return instanceCount;
+}
+
+size_t ppgso::InstanceCuller::getCapacity() const {
+  return capacity;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "mesh_part.h"
+#include "shader.h"
+
+namespace ppgso {
+
+  /*!
+   * GPU driven drawing of many instances of one mesh, needs an OpenGL 4.3 context.
+   *
+   * Model matrices live in a shader storage buffer. Every frame a compute pass tests the bounding sphere
+   * of each instance against the view frustum, picks its level of detail from the projected size and appends
+   * the visible ones to a region of the visible buffer per level. The same pass counts them into
+   * DrawElementsIndirectCommands, so drawing takes one indirect draw per mesh part and level
+   * and the CPU cost does not depend on the number of instances.
+   *
+   * Shaders drawing the instances read their model matrix from the visible buffer at binding 1,
+   * at index InstanceBase + gl_InstanceID, see diffuse_instanced_vert.glsl.
+   */
+  class InstanceCuller {
+  public:
+    // Levels of detail the compute pass selects from, coarser levels of the mesh are not drawn
+    static constexpr size_t MAX_LEVELS = 4;
+
+    /*!
+     * Check whether the context can run the culler
+     * @return True for OpenGL 4.3 and newer
+     */
+    static bool isSupported();
+
+    /*!
+     * Create buffers for a mesh, throws when the context is not supported or the mesh has no parts
+     *
+     * @param parts - Parts of the mesh to draw, see Mesh::getParts
+     * @param radius - Bounding radius of the mesh around its origin, see Mesh::getRadius
+     * @param capacity - Most instances the culler can hold
+     */
+    InstanceCuller(const std::vector<MeshPart> &parts, float radius, size_t capacity);
+
+    ~InstanceCuller();
+
+    InstanceCuller(const InstanceCuller&) = delete;
+    InstanceCuller &operator=(const InstanceCuller&) = delete;
+
+    /*!
+     * Upload model matrices of all instances, extra matrices beyond the capacity are ignored
+     * @param models - Model matrix of every instance
+     */
+    void setInstances(const std::vector<glm::mat4> &models);
+
+    /*!
+     * Set number of instances without uploading, for instance buffers written on the GPU
+     * @param count - Instances at the start of the instance buffer, clamped to the capacity
+     */
+    void setInstanceCount(size_t count);
+
+    /*!
+     * Set projected sizes at which coarser levels are used, half the screen height is 1
+     * @param thresholds - Descending sizes, one less than the levels used
+     */
+    void setThresholds(const std::vector<float> &thresholds);
+
+    /*!
+     * Run the culling pass for a camera
+     *
+     * @param projectionMatrix - Camera projection
+     * @param viewMatrix - Camera view
+     */
+    void cull(const glm::mat4 &projectionMatrix, const glm::mat4 &viewMatrix);
+
+    /*!
+     * Issue the indirect draws of the last cull, shader has to be in use with its other uniforms set
+     * @param shader - Program reading the visible buffer, receives InstanceBase
+     */
+    void draw(const Shader &shader) const;
+
+    /*!
+     * Read back visible instances of the last cull per level, waits for the GPU so only meant for statistics
+     * @return Instance count of every level
+     */
+    std::vector<size_t> readVisible() const;
+
+    /*!
+     * Get the storage buffer with model matrices of all instances, compute passes may write it directly
+     * @return OpenGL buffer identifier
+     */
+    GLuint getInstanceBuffer() const;
+
+    size_t getInstanceCount() const;
+    size_t getCapacity() const;
+
+  private:
+    // Layout of glDrawElementsIndirect commands
+    struct Command {
+      GLuint count;
+      GLuint instanceCount;
+      GLuint firstIndex;
+      GLint baseVertex;
+      GLuint baseInstance;
+    };
+
+    std::vector<MeshPart> parts;
+    std::vector<Command> commands;
+    std::vector<float> thresholds{0.3f, 0.12f, 0.05f};
+    std::shared_ptr<Shader> compute;
+    GLuint instanceBuffer = 0, visibleBuffer = 0, commandBuffer = 0;
+    size_t levels = 1, capacity = 0, instanceCount = 0;
+    float radius = 0.0f;
+  };
+}
@@ -0,0 +1,87 @@
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mapped_file.h"
+
+ppgso::MappedFile::MappedFile(const std::string &path) {
+#ifdef _WIN32
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    std::stringstream msg;
+    msg << "Could not open file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  length = (size_t) fileSize.QuadPart;
+  if (length == 0) return;
+
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping) bytes = (const uint8_t *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!bytes) {
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    std::stringstream msg;
+    msg << "Could not map file " << path;
+    throw std::runtime_error(msg.str());
+  }
+#else
+  auto descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    std::stringstream msg;
+    msg << "Could not open file " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  struct stat info = {};
+  fstat(descriptor, &info);
+  length = (size_t) info.st_size;
+  if (length == 0) {
+    close(descriptor);
+    return;
+  }
+
+  // The mapping keeps its own reference to the file, the descriptor is not needed any more
+  auto address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (address == MAP_FAILED) {
+    std::stringstream msg;
+    msg << "Could not map file " << path;
+    throw std::runtime_error(msg.str());
+  }
+  madvise(address, length, MADV_SEQUENTIAL);
+  bytes = (const uint8_t *) address;
+#endif
+}
+
+ppgso::MappedFile::~MappedFile() {
+#ifdef _WIN32
+  if (bytes) UnmapViewOfFile(bytes);
+  if (mapping) CloseHandle(mapping);
+  if (file) CloseHandle(file);
+#else
+  if (bytes) munmap((void *) bytes, length);
+#endif
+}
+
+const uint8_t *ppgso::MappedFile::data() const {
+  return bytes;
+}
+
+size_t ppgso::MappedFile::size() const {
+  return length;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace ppgso {
+
+  /*!
+   * Read only memory mapping of a whole file.
+   * The operating system pages the data in on demand, no intermediate copy is made.
+   */
+  class MappedFile {
+  public:
+    /*!
+     * Map file into memory, throws if the file can not be opened.
+     *
+     * @param path - File path to map.
+     */
+    MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    /*!
+     * Get pointer to the first byte of the file
+     * @return Pointer to mapped data, nullptr for empty files
+     */
+    const uint8_t *data() const;
+
+    /*!
+     * Get size of the mapped file
+     * @return Size in bytes
+     */
+    size_t size() const;
+
+  private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+  };
+}
@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "mesh_optimizer.h"
+
+namespace {
+  struct State {
+    bool enabled = false;
+    std::vector<ppgso::MeshOptimizer::Report> reports;
+  };
+
+  State &state() {
+    static State instance;
+    return instance;
+  }
+
+  /*!
+   * FIFO cache simulated with insertion times, a vertex is cached while fewer than cacheSize misses followed it
+   * Advancing time by cacheSize empties the cache.
+   */
+  struct FifoCache {
+    FifoCache(size_t vertexCount, unsigned cacheSize) : stamps(vertexCount, 0), time{cacheSize}, size{cacheSize} {}
+
+    unsigned misses(const unsigned *triangle) {
+      unsigned count = 0;
+      for (int k = 0; k < 3; k++) {
+        auto &stamp = stamps[triangle[k]];
+        if (time - stamp >= size) {
+          stamp = time++;
+          count++;
+        }
+      }
+      return count;
+    }
+
+    void flush() {
+      time += size;
+    }
+
+    std::vector<size_t> stamps;
+    size_t time;
+    size_t size;
+  };
+
+  glm::vec3 position(const void *positions, size_t stride, unsigned vertex) {
+    glm::vec3 result;
+    std::memcpy(&result, static_cast<const uint8_t *>(positions) + vertex * stride, sizeof(result));
+    return result;
+  }
+}
+
+void ppgso::MeshOptimizer::setEnabled(bool enabled) {
+  state().enabled = enabled;
+}
+
+bool ppgso::MeshOptimizer::isEnabled() {
+  return state().enabled;
+}
+
+std::vector<unsigned> ppgso::MeshOptimizer::optimize(const std::string &name, std::vector<unsigned> &indices,
+                                                      size_t vertexCount, const void *positions, size_t stride) {
+  Report report;
+  report.name = name;
+  report.triangles = indices.size() / 3;
+  report.vertices = vertexCount;
+  report.acmrBefore = acmr(indices, vertexCount);
+
+  // Overdraw sorting reads positions in the original vertex order, fetch renumbering comes last
+  auto original = indices;
+  auto clusters = optimizeVertexCache(indices, vertexCount);
+  optimizeOverdraw(indices, clusters, positions, stride);
+
+  // Tipsify can lose to the exporter on meshes made of many small pieces, keep the better order
+  if (acmr(indices, vertexCount) > report.acmrBefore) indices.swap(original);
+  auto remap = optimizeVertexFetch(indices, vertexCount);
+
+  report.acmrAfter = acmr(indices, vertexCount);
+  state().reports.push_back(report);
+  return remap;
+}
+
+float ppgso::MeshOptimizer::acmr(const std::vector<unsigned> &indices, size_t vertexCount, unsigned cacheSize) {
+  size_t triangles = indices.size() / 3;
+  if (!triangles) return 0.0f;
+
+  FifoCache cache{vertexCount, cacheSize};
+  size_t misses = 0;
+  for (size_t t = 0; t < triangles; t++) misses += cache.misses(&indices[t * 3]);
+  return (float) misses / (float) triangles;
+}
+
+std::vector<size_t> ppgso::MeshOptimizer::optimizeVertexCache(std::vector<unsigned> &indices, size_t vertexCount,
+                                                              unsigned cacheSize) {
+  std::vector<size_t> clusters;
+  size_t triangleCount = indices.size() / 3;
+  if (!triangleCount) return clusters;
+
+  // Triangles around every vertex, live counts those not emitted yet
+  std::vector<unsigned> live(vertexCount, 0);
+  for (size_t i = 0; i < triangleCount * 3; i++) live[indices[i]]++;
+  std::vector<size_t> offsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+  std::vector<unsigned> adjacency(offsets.back());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < triangleCount * 3; i++) adjacency[fill[indices[i]]++] = (unsigned) (i / 3);
+
+  std::vector<unsigned> output;
+  output.reserve(triangleCount * 3);
+  std::vector<size_t> stamps(vertexCount, 0);
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<unsigned> deadEnd, candidates;
+  size_t time = cacheSize + 1;
+  size_t cursor = 0;
+
+  // Fan out around one vertex at a time, emitting all its remaining triangles
+  clusters.push_back(0);
+  long fan = indices[0];
+  while (fan >= 0) {
+    candidates.clear();
+    for (size_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+      auto triangle = adjacency[a];
+      if (emitted[triangle]) continue;
+      emitted[triangle] = true;
+      for (int k = 0; k < 3; k++) {
+        auto vertex = indices[triangle * 3 + k];
+        output.push_back(vertex);
+        deadEnd.push_back(vertex);
+        candidates.push_back(vertex);
+        live[vertex]--;
+        if (time - stamps[vertex] > cacheSize) stamps[vertex] = time++;
+      }
+    }
+
+    // Next fan is the oldest candidate that stays cached while its own triangles are emitted
+    long next = -1, best = -1;
+    for (auto vertex : candidates) {
+      if (!live[vertex]) continue;
+      long priority = 0;
+      if (time - stamps[vertex] + 2 * live[vertex] <= cacheSize) priority = (long) (time - stamps[vertex]);
+      if (priority > best) {
+        best = priority;
+        next = vertex;
+      }
+    }
+
+    // Dead end, continue at the latest vertex with triangles left, else at the next one in input order
+    if (next < 0) {
+      while (next < 0 && !deadEnd.empty()) {
+        auto vertex = deadEnd.back();
+        deadEnd.pop_back();
+        if (live[vertex]) next = vertex;
+      }
+      for (; next < 0 && cursor < vertexCount; cursor++)
+        if (live[cursor]) next = (long) cursor;
+      if (next >= 0) clusters.push_back(output.size() / 3);
+    }
+    fan = next;
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin());
+  return clusters;
+}
+
+void ppgso::MeshOptimizer::optimizeOverdraw(std::vector<unsigned> &indices, const std::vector<size_t> &clusters,
+                                            const void *positions, size_t stride, float threshold) {
+  size_t triangleCount = indices.size() / 3;
+  if (!triangleCount || clusters.empty()) return;
+  size_t vertexCount = *std::max_element(indices.begin(), indices.begin() + triangleCount * 3) + 1;
+
+  // Split clusters once they have paid for their cold start, drawn in another order they cost little more
+  float target = acmr(indices, vertexCount) * threshold;
+  std::vector<size_t> starts;
+  FifoCache cache{vertexCount, CACHE_SIZE};
+  for (size_t c = 0; c < clusters.size(); c++) {
+    size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+    size_t start = clusters[c], misses = 0;
+    starts.push_back(start);
+    cache.flush();
+    for (size_t t = clusters[c]; t < end; t++) {
+      misses += cache.misses(&indices[t * 3]);
+      if (t + 1 < end && (float) misses <= target * (float) (t + 1 - start)) {
+        start = t + 1;
+        misses = 0;
+        starts.push_back(start);
+        cache.flush();
+      }
+    }
+  }
+  starts.push_back(triangleCount);
+
+  // Area weighted centroids and normals
+  struct Cluster {
+    size_t begin, end;
+    float sort;
+  };
+  std::vector<Cluster> sorted;
+  std::vector<glm::vec3> centroids, normals;
+  glm::vec3 center{0.0f};
+  float area = 0.0f;
+  for (size_t c = 0; c + 1 < starts.size(); c++) {
+    glm::vec3 centroid{0.0f}, normal{0.0f};
+    float clusterArea = 0.0f;
+    for (size_t t = starts[c]; t < starts[c + 1]; t++) {
+      auto a = position(positions, stride, indices[t * 3]);
+      auto b = position(positions, stride, indices[t * 3 + 1]);
+      auto d = position(positions, stride, indices[t * 3 + 2]);
+      auto cross = glm::cross(b - a, d - a);
+      auto triangleArea = glm::length(cross);
+      centroid += (a + b + d) * (triangleArea / 3.0f);
+      normal += cross;
+      clusterArea += triangleArea;
+    }
+    center += centroid;
+    area += clusterArea;
+    centroids.push_back(clusterArea > 0.0f ? centroid / clusterArea : centroid);
+    normals.push_back(normal);
+    sorted.push_back({starts[c], starts[c + 1], 0.0f});
+  }
+  if (area > 0.0f) center /= area;
+
+  // Clusters facing away from the center are in front of the rest of the mesh from most directions
+  for (size_t c = 0; c < sorted.size(); c++) {
+    auto length = glm::length(normals[c]);
+    sorted[c].sort = length > 0.0f ? glm::dot(centroids[c] - center, normals[c] / length) : 0.0f;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) { return a.sort > b.sort; });
+
+  std::vector<unsigned> output;
+  output.reserve(triangleCount * 3);
+  for (auto &cluster : sorted)
+    output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+std::vector<unsigned> ppgso::MeshOptimizer::optimizeVertexFetch(std::vector<unsigned> &indices, size_t vertexCount) {
+  const unsigned unused = ~0u;
+  std::vector<unsigned> remap(vertexCount, unused);
+  unsigned next = 0;
+  for (auto &index : indices) {
+    if (remap[index] == unused) remap[index] = next++;
+    index = remap[index];
+  }
+  for (auto &vertex : remap)
+    if (vertex == unused) vertex = next++;
+  return remap;
+}
+
+void ppgso::MeshOptimizer::remapVertices(void *data, const std::vector<unsigned> &remap, size_t size, size_t stride) {
+  if (remap.empty()) return;
+  auto bytes = static_cast<uint8_t *>(data);
+  std::vector<uint8_t> original(bytes, bytes + (remap.size() - 1) * stride + size);
+  for (size_t v = 0; v < remap.size(); v++)
+    std::memcpy(bytes + remap[v] * stride, original.data() + v * stride, size);
+}
+
+std::vector<unsigned> ppgso::MeshOptimizer::simplify(const std::vector<unsigned> &indices, size_t vertexCount,
+                                                      const void *positions, size_t stride, size_t targetIndexCount,
+                                                      float targetError) {
+  std::vector<unsigned> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+  if (result.size() <= targetIndexCount || !vertexCount) return result;
+
+  std::vector<glm::vec3> points(vertexCount);
+  glm::vec3 low{position(positions, stride, 0)}, high{low};
+  for (size_t v = 0; v < vertexCount; v++) {
+    points[v] = position(positions, stride, (unsigned) v);
+    low = glm::min(low, points[v]);
+    high = glm::max(high, points[v]);
+  }
+  auto maxError = targetError * glm::length(high - low);
+  maxError *= maxError;
+
+  // Vertices sharing a position belong to an attribute seam, they stay in place so the seam can not open.
+  // Border vertices of the welded mesh stay as well, the silhouette of open parts is kept.
+  std::vector<unsigned> order(vertexCount), weld(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) order[v] = (unsigned) v;
+  auto less = [&points](unsigned a, unsigned b) {
+    auto &p = points[a], &q = points[b];
+    return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+  };
+  std::sort(order.begin(), order.end(), less);
+  std::vector<bool> locked(vertexCount, false);
+  for (size_t first = 0, last; first < vertexCount; first = last) {
+    for (last = first + 1; last < vertexCount && points[order[last]] == points[order[first]]; last++);
+    for (size_t i = first; i < last; i++) {
+      weld[order[i]] = order[first];
+      locked[order[i]] = last - first > 1;
+    }
+  }
+  std::vector<uint64_t> edges;
+  edges.reserve(result.size());
+  for (size_t i = 0; i < result.size(); i += 3) {
+    for (int k = 0; k < 3; k++) {
+      uint64_t a = weld[result[i + k]], b = weld[result[i + (k + 1) % 3]];
+      edges.push_back(a < b ? a << 32 | b : b << 32 | a);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  std::vector<bool> border(vertexCount, false);
+  for (size_t first = 0, last; first < edges.size(); first = last) {
+    for (last = first + 1; last < edges.size() && edges[last] == edges[first]; last++);
+    if (last - first == 1) border[edges[first] >> 32] = border[edges[first] & 0xFFFFFFFFu] = true;
+  }
+  for (size_t v = 0; v < vertexCount; v++)
+    if (border[weld[v]]) locked[v] = true;
+
+  // Area weighted plane quadrics, error is the mean squared distance to the planes
+  struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0, b0 = 0, b1 = 0, b2 = 0, c = 0, weight = 0;
+
+    void add(const Quadric &q) {
+      a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+      b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; weight += q.weight;
+    }
+
+    double error(const glm::vec3 &p) const {
+      double x = p.x, y = p.y, z = p.z;
+      double e = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                 2 * (b0 * x + b1 * y + b2 * z) + c;
+      return weight > 0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+  };
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < result.size(); i += 3) {
+    auto &p0 = points[result[i]], &p1 = points[result[i + 1]], &p2 = points[result[i + 2]];
+    auto normal = glm::cross(p1 - p0, p2 - p0);
+    auto area = glm::length(normal);
+    if (area <= 0.0f) continue;
+    normal /= area;
+    double w = area, nx = normal.x, ny = normal.y, nz = normal.z, d = -glm::dot(normal, p0);
+    Quadric q;
+    q.a00 = w * nx * nx; q.a01 = w * nx * ny; q.a02 = w * nx * nz;
+    q.a11 = w * ny * ny; q.a12 = w * ny * nz; q.a22 = w * nz * nz;
+    q.b0 = w * nx * d; q.b1 = w * ny * d; q.b2 = w * nz * d; q.c = w * d * d; q.weight = w;
+    for (int k = 0; k < 3; k++) quadrics[result[i + k]].add(q);
+  }
+
+  // Batches of independent half edge collapses, each moves a vertex onto a neighbour
+  struct Collapse {
+    unsigned from, to;
+    double cost;
+  };
+  std::vector<Collapse> collapses;
+  std::vector<size_t> offsets(vertexCount + 1);
+  std::vector<unsigned> adjacency, remap(vertexCount);
+  std::vector<bool> touched(vertexCount);
+  while (result.size() > targetIndexCount) {
+    // Triangles around every vertex
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (auto index : result) offsets[index + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+    adjacency.resize(result.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < result.size(); i++) adjacency[fill[result[i]]++] = (unsigned) (i / 3);
+
+    collapses.clear();
+    for (size_t i = 0; i < result.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        unsigned a = result[i + k], b = result[i + (k + 1) % 3];
+        if (locked[a] && locked[b]) continue;
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+        double ab = locked[a] ? HUGE_VAL : q.error(points[b]), ba = locked[b] ? HUGE_VAL : q.error(points[a]);
+        if (ab <= ba) collapses.push_back({a, b, ab});
+        else collapses.push_back({b, a, ba});
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+    // Every collapse removes about two triangles, stop at the target
+    size_t budget = (result.size() - targetIndexCount) / 6 + 1, done = 0;
+    std::fill(touched.begin(), touched.end(), false);
+    for (size_t v = 0; v < vertexCount; v++) remap[v] = (unsigned) v;
+    for (auto &collapse : collapses) {
+      if (collapse.cost > maxError || done >= budget) break;
+      if (touched[collapse.from] || touched[collapse.to]) continue;
+
+      // Reject collapses that would turn a remaining triangle over
+      bool flips = false;
+      for (size_t a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; a++) {
+        auto t = adjacency[a] * 3;
+        if (result[t] == collapse.to || result[t + 1] == collapse.to || result[t + 2] == collapse.to) continue;
+        glm::vec3 before[3], after[3];
+        for (int k = 0; k < 3; k++) {
+          before[k] = points[result[t + k]];
+          after[k] = points[result[t + k] == collapse.from ? collapse.to : result[t + k]];
+        }
+        auto n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+        auto n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+        flips = glm::dot(n0, n1) <= 0.0f;
+      }
+      if (flips) continue;
+
+      // The neighbourhood is settled for this batch, later collapses see the updated geometry
+      for (size_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++)
+        for (int k = 0; k < 3; k++) touched[result[adjacency[a] * 3 + k]] = true;
+      touched[collapse.to] = true;
+      remap[collapse.from] = collapse.to;
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      done++;
+    }
+    if (!done) break;
+
+    size_t write = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      unsigned a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+      if (a == b || b == c || a == c) continue;
+      result[write++] = a;
+      result[write++] = b;
+      result[write++] = c;
+    }
+    result.resize(write);
+  }
+  return result;
+}
+
+std::vector<std::vector<unsigned>> ppgso::MeshOptimizer::generateLods(const std::vector<unsigned> &indices,
+                                                                      size_t vertexCount, const void *positions,
+                                                                      size_t stride, int levels) {
+  std::vector<std::vector<unsigned>> lods;
+  const std::vector<unsigned> *previous = &indices;
+  for (int level = 1; level < levels; level++) {
+    // Each level halves the previous one, allowed error grows with the distance it is used at
+    auto lod = simplify(*previous, vertexCount, positions, stride, previous->size() / 2 / 3 * 3,
+                        LOD_ERROR * (float) (1 << (level - 1)));
+    if (lod.empty() || lod.size() > previous->size() * 9 / 10) break;
+    optimizeVertexCache(lod, vertexCount);
+    lods.push_back(std::move(lod));
+    previous = &lods.back();
+  }
+  return lods;
+}
+
+const std::vector<ppgso::MeshOptimizer::Report> &ppgso::MeshOptimizer::reports() {
+  return state().reports;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace ppgso {
+
+  /*!
+   * Optional import stage reordering indexed triangle lists for the GPU.
+   *
+   * The Mesh loaders run three passes over every triangle list when enabled:
+   * 1. Tipsify (Sander et al. 2007) orders triangles for the post-transform vertex cache
+   * 2. Clusters of that order are sorted outside in, so occluders tend to be drawn first
+   * 3. Vertices are renumbered in order of first use, so vertex fetch walks memory forward
+   *
+   * Quality is reported as ACMR, average cache misses per triangle of a FIFO cache of CACHE_SIZE vertices.
+   * 3.0 means no reuse at all, a regular grid approaches 0.5.
+   *
+   * The stage is disabled until enabled.
+   *
+   * Independently of the stage, loaders build coarser levels of detail for meshes loaded with more than one level.
+   */
+  class MeshOptimizer {
+  public:
+    // Vertices kept by the simulated post-transform cache
+    static const unsigned CACHE_SIZE = 16;
+
+    // Allowed simplification error of the first coarser level, fraction of the mesh extent, doubles every level
+    static constexpr float LOD_ERROR = 0.01f;
+
+    struct Report {
+      std::string name;          // File name, with the primitive number for multi primitive files
+      size_t triangles = 0;
+      size_t vertices = 0;
+      float acmrBefore = 0.0f;
+      float acmrAfter = 0.0f;
+    };
+
+    /*!
+     * Enable or disable the stage for meshes loaded afterwards
+     * @param enabled - True to optimize
+     */
+    static void setEnabled(bool enabled);
+
+    /*!
+     * Check whether loaders should optimize
+     * @return True when enabled
+     */
+    static bool isEnabled();
+
+    /*!
+     * Run all passes over a triangle list and record the report
+     * When the new triangle order caches worse than the original, the original order is kept.
+     *
+     * @param name - Name of the report
+     * @param indices - Triangle list, reordered and renumbered in place
+     * @param vertexCount - Number of vertices the indices refer to
+     * @param positions - Vertex positions as three floats, in the original vertex order
+     * @param stride - Bytes between consecutive positions
+     * @return Remap table, new index of each original vertex, apply it to every attribute with remapVertices
+     */
+    static std::vector<unsigned> optimize(const std::string &name, std::vector<unsigned> &indices, size_t vertexCount,
+                                          const void *positions, size_t stride);
+
+    /*!
+     * Simulate a FIFO post-transform cache
+     *
+     * @param indices - Triangle list
+     * @param vertexCount - Number of vertices the indices refer to
+     * @param cacheSize - Vertices kept by the cache
+     * @return Average cache misses per triangle
+     */
+    static float acmr(const std::vector<unsigned> &indices, size_t vertexCount, unsigned cacheSize = CACHE_SIZE);
+
+    /*!
+     * Reorder triangles for the post-transform cache with Tipsify
+     *
+     * @param indices - Triangle list, reordered in place
+     * @param vertexCount - Number of vertices the indices refer to
+     * @param cacheSize - Vertices kept by the cache
+     * @return First triangle of every cluster, where the order had to jump to a new area of the mesh
+     */
+    static std::vector<size_t> optimizeVertexCache(std::vector<unsigned> &indices, size_t vertexCount,
+                                                   unsigned cacheSize = CACHE_SIZE);
+
+    /*!
+     * Sort clusters so triangles facing out from the mesh center are drawn first
+     * Clusters are split further where the cache cost of restarting is low, the cache order within them is kept.
+     *
+     * @param indices - Triangle list ordered by optimizeVertexCache, reordered in place
+     * @param clusters - Cluster starts returned by optimizeVertexCache
+     * @param positions - Vertex positions as three floats
+     * @param stride - Bytes between consecutive positions
+     * @param threshold - Allowed ACMR increase over the cache order, 1.05 is 5 %
+     */
+    static void optimizeOverdraw(std::vector<unsigned> &indices, const std::vector<size_t> &clusters,
+                                 const void *positions, size_t stride, float threshold = 1.05f);
+
+    /*!
+     * Renumber vertices in order of first use, unused vertices are moved to the end
+     *
+     * @param indices - Triangle list, renumbered in place
+     * @param vertexCount - Number of vertices the indices refer to
+     * @return Remap table, new index of each original vertex
+     */
+    static std::vector<unsigned> optimizeVertexFetch(std::vector<unsigned> &indices, size_t vertexCount);
+
+    /*!
+     * Move vertex data to the positions given by a remap table
+     *
+     * @param data - First vertex, permuted in place
+     * @param remap - New index of each original vertex
+     * @param size - Bytes of one vertex to move
+     * @param stride - Bytes between consecutive vertices, size for tightly packed data
+     */
+    static void remapVertices(void *data, const std::vector<unsigned> &remap, size_t size, size_t stride);
+
+    /*!
+     * Simplify a triangle list by quadric error half edge collapses (Garland and Heckbert 1997)
+     * Vertices are not moved or created, the result indexes the same vertex data.
+     * Vertices on attribute seams and open borders are never collapsed away.
+     *
+     * @param indices - Triangle list
+     * @param vertexCount - Number of vertices the indices refer to
+     * @param positions - Vertex positions as three floats
+     * @param stride - Bytes between consecutive positions
+     * @param targetIndexCount - Stop once the list is this short
+     * @param targetError - Largest allowed deviation, fraction of the mesh extent
+     * @return Simplified triangle list, longer than the target when the error limit was reached first
+     */
+    static std::vector<unsigned> simplify(const std::vector<unsigned> &indices, size_t vertexCount,
+                                          const void *positions, size_t stride, size_t targetIndexCount,
+                                          float targetError);
+
+    /*!
+     * Build the coarser levels of detail of a triangle list, each with about half the triangles of the previous one
+     *
+     * @param indices - Triangle list of the full detail level
+     * @param vertexCount - Number of vertices the indices refer to
+     * @param positions - Vertex positions as three floats
+     * @param stride - Bytes between consecutive positions
+     * @param levels - Levels including the full mesh
+     * @return Triangle lists of levels 1 and up, fewer than requested when the mesh can not be reduced further
+     */
+    static std::vector<std::vector<unsigned>> generateLods(const std::vector<unsigned> &indices, size_t vertexCount,
+                                                           const void *positions, size_t stride, int levels);
+
+    /*!
+     * Get reports of every mesh optimized since the start of the process
+     * @return Reports in load order
+     */
+    static const std::vector<Report> &reports();
+  };
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Indexed triangles of one part of a loaded mesh, for draws issued outside of the Mesh classes.
+   * The vertex array already has the element buffer bound, every level of detail is a range of it.
+   */
+  struct MeshPart {
+    struct Lod {
+      size_t offset = 0;         // Bytes into the element buffer
+      GLsizei count = 0;         // Indices
+    };
+
+    GLuint vao = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    std::vector<Lod> lods;       // Full detail first, at least one
+  };
+}
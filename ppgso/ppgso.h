@@ -18,12 +18,24 @@ namespace ppgso {
 #endif
 }
 
+#include "mesh_optimizer.h"
 #include "shader.h"
+#include "program_cache.h"
 #include "image.h"
 #include "image_bmp.h"
 #include "image_raw.h"
+#include "image_dds.h"
+#include "image_filter.h"
 #include "texture.h"
+#include "texture_stream.h"
+#include "render_target.h"
+#include "convolution.h"
+#include "render_state.h"
+#include "render_queue.h"
+#include "instance_culler.h"
+#include "animation_clip.h"
 #include "window.h"
+#include "resource_cache.h"
 
 namespace ppgso {
   /*!
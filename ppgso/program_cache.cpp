@@ -0,0 +1,188 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "program_cache.h"
+
+namespace {
+  const char MAGIC[4] = {'P', 'P', 'G', 'B'};
+  const uint32_t VERSION = 1;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t driver;   // Hash of vendor, renderer and version strings
+    uint32_t format;   // Driver specific binary format
+    uint32_t length;   // Bytes of binary data following the header
+  };
+
+  struct State {
+    std::string directory;
+    ppgso::ProgramCache::Stats stats;
+  };
+
+  State &state() {
+    static State instance;
+    return instance;
+  }
+
+  const uint64_t FNV_OFFSET = 14695981039346656037ull, FNV_PRIME = 1099511628211ull;
+
+  uint64_t fnv1a(uint64_t hash, const void *data, size_t length) {
+    auto bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < length; i++) {
+      hash ^= bytes[i];
+      hash *= FNV_PRIME;
+    }
+    return hash;
+  }
+
+  /*!
+   * Hash sources with their lengths so that moving text between stages changes the key
+   */
+  std::string hexKey(const char *stage, const std::string *sources, size_t count) {
+    auto hash = fnv1a(FNV_OFFSET, stage, std::strlen(stage));
+    for (size_t i = 0; i < count; i++) {
+      uint64_t length = sources[i].size();
+      hash = fnv1a(hash, &length, sizeof(length));
+      hash = fnv1a(hash, sources[i].data(), sources[i].size());
+    }
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+  }
+
+  /*!
+   * Binaries are only valid for the exact driver that produced them
+   */
+  uint64_t driverHash() {
+    auto hash = FNV_OFFSET;
+    for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+      auto text = (const char *) glGetString(name);
+      if (text) hash = fnv1a(hash, text, std::strlen(text) + 1);
+    }
+    return hash;
+  }
+
+  bool supported() {
+    if (state().directory.empty() || !GLEW_ARB_get_program_binary) return false;
+    // Some drivers expose the extension without any binary format
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }
+
+  std::string path(const std::string &key) {
+    return state().directory + "/" + key + ".bin";
+  }
+}
+
+void ppgso::ProgramCache::setDirectory(const std::string &directory) {
+  state().directory = directory;
+  if (directory.empty()) return;
+  // An existing directory is fine, anything else shows up as failed writes later
+#ifdef _WIN32
+  _mkdir(directory.c_str());
+#else
+  mkdir(directory.c_str(), 0755);
+#endif
+}
+
+const std::string &ppgso::ProgramCache::getDirectory() {
+  return state().directory;
+}
+
+std::string ppgso::ProgramCache::key(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  std::string sources[] = {vertex_shader_code, fragment_shader_code};
+  return hexKey("graphics", sources, 2);
+}
+
+std::string ppgso::ProgramCache::key(const std::string &compute_shader_code) {
+  return hexKey("compute", &compute_shader_code, 1);
+}
+
+bool ppgso::ProgramCache::load(const std::string &key, GLuint program) {
+  if (!supported()) return false;
+
+  std::ifstream file{path(key), std::ios::binary};
+  if (!file) return false;
+
+  Header header;
+  file.read((char *) &header, sizeof(header));
+  bool valid = file && std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+               header.driver == driverHash();
+  std::vector<char> binary;
+  if (valid) {
+    binary.resize(header.length);
+    file.read(binary.data(), header.length);
+    valid = (bool) file;
+  }
+
+  GLint linked = GL_FALSE;
+  if (valid) {
+    glProgramBinary(program, header.format, binary.data(), (GLsizei) header.length);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  }
+  if (linked == GL_FALSE) {
+    // Stale or truncated, drop it so the freshly compiled program replaces it
+    file.close();
+    std::remove(path(key).c_str());
+    state().stats.rejected++;
+    return false;
+  }
+
+  state().stats.loaded++;
+  return true;
+}
+
+void ppgso::ProgramCache::prepare(GLuint program) {
+  state().stats.compiled++;
+  if (supported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ppgso::ProgramCache::store(const std::string &key, GLuint program) {
+  if (!supported()) return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  std::vector<char> binary((size_t) length);
+  GLenum format = 0;
+  GLsizei written = 0;
+  glGetProgramBinary(program, length, &written, &format, binary.data());
+  if (written <= 0) return;
+
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.driver = driverHash();
+  header.format = format;
+  header.length = (uint32_t) written;
+
+  // Write aside and rename, another instance starting at the same time never sees half a file
+  auto target = path(key);
+  auto temporary = target + ".tmp";
+  {
+    std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+    if (!file) return;
+    file.write((const char *) &header, sizeof(header));
+    file.write(binary.data(), written);
+    if (!file) return;
+  }
+  std::remove(target.c_str());
+  if (std::rename(temporary.c_str(), target.c_str()) == 0) state().stats.stored++;
+}
+
+ppgso::ProgramCache::Stats ppgso::ProgramCache::stats() {
+  return state().stats;
+}
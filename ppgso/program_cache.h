@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * On disk cache of linked program binaries (ARB_get_program_binary).
+   * Programs are stored under a hash of their sources, a later launch loads the binary
+   * instead of compiling and linking GLSL again. Binaries record the driver they were built by,
+   * after a driver update they are rejected and the program is compiled from source as usual.
+   *
+   * The cache is disabled until a directory is set.
+   */
+  class ProgramCache {
+  public:
+    struct Stats {
+      size_t loaded = 0;    // Programs created from a stored binary
+      size_t compiled = 0;  // Programs compiled from source
+      size_t stored = 0;    // Binaries written to disk
+      size_t rejected = 0;  // Stored binaries the driver refused, or written by another driver
+    };
+
+    /*!
+     * Set directory for program binaries, it is created when missing
+     *
+     * @param directory - Cache directory, empty disables the cache
+     */
+    static void setDirectory(const std::string &directory);
+
+    /*!
+     * Get current cache directory
+     * @return Directory, empty when the cache is disabled
+     */
+    static const std::string &getDirectory();
+
+    /*!
+     * Get key identifying a vertex and fragment program
+     *
+     * @param vertex_shader_code - Source of the vertex shader
+     * @param fragment_shader_code - Source of the fragment shader
+     * @return 64 bit FNV-1a hash of the sources as 16 hex digits
+     */
+    static std::string key(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
+
+    /*!
+     * Get key identifying a compute program
+     *
+     * @param compute_shader_code - Source of the compute shader
+     * @return 64 bit FNV-1a hash of the source as 16 hex digits
+     */
+    static std::string key(const std::string &compute_shader_code);
+
+    /*!
+     * Load stored binary into program
+     *
+     * @param key - Program key
+     * @param program - Program object without attached shaders
+     * @return True when the program is linked and ready, false when it has to be compiled
+     */
+    static bool load(const std::string &key, GLuint program);
+
+    /*!
+     * Request a retrievable binary, call before linking a program that will be stored
+     * @param program - Program object about to be linked
+     */
+    static void prepare(GLuint program);
+
+    /*!
+     * Store binary of a freshly linked program
+     *
+     * @param key - Program key
+     * @param program - Linked program object
+     */
+    static void store(const std::string &key, GLuint program);
+
+    /*!
+     * Get cache counters since the start of the process
+     * @return Loaded, compiled, stored and rejected programs
+     */
+    static Stats stats();
+  };
+}
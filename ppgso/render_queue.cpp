@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cstring>
+
+#include "render_queue.h"
+#include "render_state.h"
+
+namespace {
+  // Key layout from the most significant bit, alpha draws swap depth in front of the material
+  // | pass 2 | shader 10 | texture 12 | mesh 12 | depth 28 |
+  const uint64_t SHADER_BITS = 10, TEXTURE_BITS = 12, MESH_BITS = 12, DEPTH_BITS = 28;
+  const uint64_t MATERIAL_BITS = SHADER_BITS + TEXTURE_BITS + MESH_BITS;
+
+  /*!
+   * Quantize view depth so that integer order matches float order, objects behind the camera map to 0
+   */
+  uint64_t depthBits(float depth) {
+    if (!(depth > 0.0f)) return 0;
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    // Positive floats compare like integers, dropping the sign and 3 mantissa bits leaves 28
+    return bits >> 3;
+  }
+}
+
+uint64_t ppgso::RenderQueue::id(std::unordered_map<const void *, uint64_t> &ids, const void *resource, uint64_t bits) {
+  // Ids are handed out in submission order, resources past the limit share the last one
+  auto found = ids.find(resource);
+  if (found != ids.end()) return found->second;
+  auto next = std::min<uint64_t>(ids.size(), (1ull << bits) - 1);
+  ids.emplace(resource, next);
+  return next;
+}
+
+void ppgso::RenderQueue::submit(Pass pass, const Shader *shader, const Texture *texture, const void *mesh,
+                                float depth, std::function<void()> draw) {
+  uint64_t key = (uint64_t) pass << 62;
+  if (pass != Pass::Background) {
+    auto material = id(shaders, shader, SHADER_BITS) << (TEXTURE_BITS + MESH_BITS) |
+                    id(textures, texture, TEXTURE_BITS) << MESH_BITS |
+                    id(meshes, mesh, MESH_BITS);
+    auto distance = depthBits(depth);
+    if (pass == Pass::Alpha)
+      key |= ((1ull << DEPTH_BITS) - 1 - distance) << MATERIAL_BITS | material;
+    else
+      key |= material << DEPTH_BITS | distance;
+  }
+  items.push_back({key, pass, std::move(draw)});
+}
+
+void ppgso::RenderQueue::flush() {
+  order.clear();
+  for (size_t i = 0; i < items.size(); i++) order.emplace_back(items[i].key, i);
+  // Equal keys keep submission order, background draws rely on it
+  std::stable_sort(order.begin(), order.end(), [](const std::pair<uint64_t, size_t> &a,
+                                                  const std::pair<uint64_t, size_t> &b) {
+    return a.first < b.first;
+  });
+
+  for (auto &entry : order) {
+    auto &item = items[entry.second];
+    switch (item.pass) {
+      case Pass::Background:
+        RenderState::setEnabled(GL_BLEND, false);
+        RenderState::setDepthMask(false);
+        break;
+      case Pass::Opaque:
+        RenderState::setEnabled(GL_BLEND, false);
+        RenderState::setDepthMask(true);
+        break;
+      case Pass::Alpha:
+        // Blended surfaces must not hide each other, they are only occluded by opaque ones
+        RenderState::setEnabled(GL_BLEND, true);
+        RenderState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        RenderState::setDepthMask(false);
+        break;
+      case Pass::Additive:
+        RenderState::setEnabled(GL_BLEND, true);
+        RenderState::setBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        RenderState::setDepthMask(false);
+        break;
+    }
+    item.draw();
+  }
+
+  RenderState::setDepthMask(true);
+  RenderState::setEnabled(GL_BLEND, false);
+  items.clear();
+  shaders.clear();
+  textures.clear();
+  meshes.clear();
+}
+
+size_t ppgso::RenderQueue::size() const {
+  return items.size();
+}
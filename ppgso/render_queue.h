@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+#include "texture.h"
+
+namespace ppgso {
+
+  /*!
+   * Collects the draws of a frame and issues them ordered by a 64 bit sort key.
+   *
+   * Opaque and additive draws are grouped by shader, texture and mesh so RenderState can skip
+   * the repeated binds, ties are drawn front to back to help early depth rejection.
+   * Alpha blended draws are ordered back to front first and by material only within equal depth.
+   * Background draws keep their submission order.
+   */
+  class RenderQueue {
+  public:
+    enum class Pass {
+      Background,  // Depth writes off, drawn before everything else
+      Opaque,      // Depth writes on, no blending
+      Alpha,       // Standard alpha blending, depth writes off
+      Additive     // Additive blending, depth writes off
+    };
+
+    /*!
+     * Queue a draw for the next flush
+     *
+     * @param pass - Pass deciding blending, depth writes and ordering
+     * @param shader - Program the draw uses, only its address is used for grouping
+     * @param texture - Main texture of the draw, may be nullptr
+     * @param mesh - Geometry the draw uses, any address identifying it, may be nullptr
+     * @param depth - Distance from the camera along its view direction
+     * @param draw - Issues the draw, must not change blending or depth writes
+     */
+    void submit(Pass pass, const Shader *shader, const Texture *texture, const void *mesh, float depth,
+                std::function<void()> draw);
+
+    /*!
+     * Sort and issue all queued draws, then empty the queue
+     * Leaves depth writes enabled and blending disabled
+     */
+    void flush();
+
+    /*!
+     * Get the number of queued draws
+     * @return Draws submitted since the last flush
+     */
+    size_t size() const;
+
+  private:
+    struct Item {
+      uint64_t key;
+      Pass pass;
+      std::function<void()> draw;
+    };
+
+    uint64_t id(std::unordered_map<const void *, uint64_t> &ids, const void *resource, uint64_t bits);
+
+    // All containers are kept between frames to reuse their allocations
+    std::vector<Item> items;
+    std::vector<std::pair<uint64_t, size_t>> order;
+    std::unordered_map<const void *, uint64_t> shaders, textures, meshes;
+  };
+}
@@ -0,0 +1,163 @@
+#include <map>
+
+#include "render_state.h"
+
+namespace {
+  // Texture units tracked by the cache, higher units always reach OpenGL
+  const int UNITS = 32;
+
+  // Marks a binding the cache knows nothing about
+  const GLuint UNKNOWN = ~0u;
+
+  struct State {
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    int activeUnit = -1;
+    GLuint textures[UNITS];
+    std::map<GLenum, int> capabilities;  // 1 enabled, 0 disabled, missing unknown
+    int depthMask = -1;
+    GLenum blendSource = GL_NONE, blendDestination = GL_NONE;
+    ppgso::RenderState::Stats current, previous;
+
+    State() {
+      for (auto &texture : textures) texture = UNKNOWN;
+    }
+  };
+
+  State &state() {
+    static State instance;
+    return instance;
+  }
+}
+
+size_t ppgso::RenderState::Stats::changes() const {
+  return programs + textures + vertexArrays + states;
+}
+
+void ppgso::RenderState::useProgram(GLuint program) {
+  auto &cache = state();
+  if (cache.program == program) {
+    cache.current.skipped++;
+    return;
+  }
+  glUseProgram(program);
+  cache.program = program;
+  cache.current.programs++;
+}
+
+void ppgso::RenderState::bindTexture(int unit, GLuint texture) {
+  auto &cache = state();
+  if (unit < UNITS && cache.textures[unit] == texture) {
+    cache.current.skipped++;
+    return;
+  }
+  if (cache.activeUnit != unit) {
+    glActiveTexture((GLenum) (GL_TEXTURE0 + unit));
+    cache.activeUnit = unit;
+  }
+  glBindTexture(GL_TEXTURE_2D, texture);
+  if (unit < UNITS) cache.textures[unit] = texture;
+  cache.current.textures++;
+}
+
+void ppgso::RenderState::bindVertexArray(GLuint vertexArray) {
+  auto &cache = state();
+  if (cache.vertexArray == vertexArray) {
+    cache.current.skipped++;
+    return;
+  }
+  glBindVertexArray(vertexArray);
+  cache.vertexArray = vertexArray;
+  cache.current.vertexArrays++;
+}
+
+void ppgso::RenderState::setEnabled(GLenum capability, bool enabled) {
+  auto &cache = state();
+  auto found = cache.capabilities.find(capability);
+  if (found != cache.capabilities.end() && found->second == (int) enabled) {
+    cache.current.skipped++;
+    return;
+  }
+  if (enabled) glEnable(capability);
+  else glDisable(capability);
+  cache.capabilities[capability] = enabled;
+  cache.current.states++;
+}
+
+bool ppgso::RenderState::isEnabled(GLenum capability) {
+  auto &cache = state();
+  auto found = cache.capabilities.find(capability);
+  if (found != cache.capabilities.end()) return found->second != 0;
+  bool enabled = glIsEnabled(capability) == GL_TRUE;
+  cache.capabilities[capability] = enabled;
+  return enabled;
+}
+
+void ppgso::RenderState::setDepthMask(bool write) {
+  auto &cache = state();
+  if (cache.depthMask == (int) write) {
+    cache.current.skipped++;
+    return;
+  }
+  glDepthMask(write ? GL_TRUE : GL_FALSE);
+  cache.depthMask = write;
+  cache.current.states++;
+}
+
+void ppgso::RenderState::setBlendFunc(GLenum source, GLenum destination) {
+  auto &cache = state();
+  if (cache.blendSource == source && cache.blendDestination == destination) {
+    cache.current.skipped++;
+    return;
+  }
+  glBlendFunc(source, destination);
+  cache.blendSource = source;
+  cache.blendDestination = destination;
+  cache.current.states++;
+}
+
+void ppgso::RenderState::countDraw(size_t triangles) {
+  auto &cache = state();
+  cache.current.drawCalls++;
+  cache.current.triangles += triangles;
+}
+
+void ppgso::RenderState::forgetProgram(GLuint program) {
+  // A deleted program stays in use until another one is made current
+  auto &cache = state();
+  if (cache.program == program) cache.program = UNKNOWN;
+}
+
+void ppgso::RenderState::forgetTexture(GLuint texture) {
+  // OpenGL unbinds deleted textures from every unit of the current context
+  auto &cache = state();
+  for (auto &bound : cache.textures)
+    if (bound == texture) bound = 0;
+}
+
+void ppgso::RenderState::forgetVertexArray(GLuint vertexArray) {
+  auto &cache = state();
+  if (cache.vertexArray == vertexArray) cache.vertexArray = 0;
+}
+
+void ppgso::RenderState::invalidate() {
+  auto &cache = state();
+  auto current = cache.current, previous = cache.previous;
+  cache = State{};
+  cache.current = current;
+  cache.previous = previous;
+}
+
+void ppgso::RenderState::endFrame() {
+  auto &cache = state();
+  cache.previous = cache.current;
+  cache.current = Stats{};
+}
+
+ppgso::RenderState::Stats ppgso::RenderState::stats() {
+  return state().current;
+}
+
+ppgso::RenderState::Stats ppgso::RenderState::lastFrame() {
+  return state().previous;
+}
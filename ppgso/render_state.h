@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Cache of the OpenGL binding and pipeline state of the current context.
+   * Shader, Texture, Mesh and the post-processing classes change state only through it,
+   * calls that would set the value already in place are skipped and counted.
+   *
+   * State changed with raw OpenGL calls is unknown to the cache, report it with invalidate().
+   */
+  class RenderState {
+  public:
+    struct Stats {
+      size_t programs = 0;      // glUseProgram calls issued
+      size_t textures = 0;      // glBindTexture calls issued
+      size_t vertexArrays = 0;  // glBindVertexArray calls issued
+      size_t states = 0;        // glEnable/glDisable, glDepthMask and glBlendFunc calls issued
+      size_t skipped = 0;       // Redundant calls that never reached the driver
+      size_t drawCalls = 0;     // Draws reported by countDraw, not state changes
+      size_t triangles = 0;     // Triangles of those draws
+
+      /*!
+       * Get the number of state changes sent to the driver
+       * @return Sum of all issued calls
+       */
+      size_t changes() const;
+    };
+
+    /*!
+     * Make program current
+     * @param program - OpenGL program identifier
+     */
+    static void useProgram(GLuint program);
+
+    /*!
+     * Bind 2D texture to a texture unit
+     * @param unit - Texture unit index
+     * @param texture - OpenGL texture identifier
+     */
+    static void bindTexture(int unit, GLuint texture);
+
+    /*!
+     * Bind vertex array object
+     * @param vertexArray - OpenGL vertex array identifier
+     */
+    static void bindVertexArray(GLuint vertexArray);
+
+    /*!
+     * Enable or disable a capability such as GL_BLEND, GL_DEPTH_TEST or GL_CULL_FACE
+     * @param capability - OpenGL capability
+     * @param enabled - New state
+     */
+    static void setEnabled(GLenum capability, bool enabled);
+
+    /*!
+     * Get capability state, queried from OpenGL only the first time it is needed
+     * @param capability - OpenGL capability
+     * @return True when enabled
+     */
+    static bool isEnabled(GLenum capability);
+
+    /*!
+     * Enable or disable depth buffer writes
+     * @param write - New depth mask
+     */
+    static void setDepthMask(bool write);
+
+    /*!
+     * Set blending factors
+     * @param source - Source factor
+     * @param destination - Destination factor
+     */
+    static void setBlendFunc(GLenum source, GLenum destination);
+
+    /*!
+     * Record a draw call in the frame counters, Mesh classes report every draw they issue
+     * @param triangles - Triangles drawn by the call
+     */
+    static void countDraw(size_t triangles);
+
+    /*!
+     * Drop cached bindings of objects being deleted, OpenGL may hand out their names again
+     * @param program - Deleted program, 0 for none
+     */
+    static void forgetProgram(GLuint program);
+    static void forgetTexture(GLuint texture);
+    static void forgetVertexArray(GLuint vertexArray);
+
+    /*!
+     * Forget everything, the next call of each kind always reaches OpenGL
+     */
+    static void invalidate();
+
+    /*!
+     * Close the frame, its counters become available through lastFrame()
+     */
+    static void endFrame();
+
+    /*!
+     * Get counters of the frame being recorded
+     * @return Counts since the last endFrame()
+     */
+    static Stats stats();
+
+    /*!
+     * Get counters of the previous frame
+     * @return Counts between the last two endFrame() calls
+     */
+    static Stats lastFrame();
+  };
+}
@@ -0,0 +1,219 @@
+#include <sstream>
+#include <algorithm>
+
+#include "render_target.h"
+#include "resource_cache.h"
+#include "render_state.h"
+
+#include <shaders/post_vert_glsl.h>
+#include <shaders/post_copy_frag_glsl.h>
+
+ppgso::RenderTarget::RenderTarget(int width, int height, Texture::Format format, bool depth)
+    : texture{width, height, format, Texture::Attachment} {
+  if (texture.getPixelBytes() == 0)
+    throw std::runtime_error("Render target can not use a compressed format!");
+
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture.getTexture(), 0);
+
+  // Post-processing targets only sample colour, they skip the depth buffer entirely
+  if (depth) {
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
+  auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    if (rbo) glDeleteRenderbuffers(1, &rbo);
+    glDeleteFramebuffers(1, &fbo);
+    std::stringstream msg;
+    msg << "Cannot create framebuffer " << width << "x" << height << ", status " << status;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+ppgso::RenderTarget::~RenderTarget() {
+  if (rbo) glDeleteRenderbuffers(1, &rbo);
+  glDeleteFramebuffers(1, &fbo);
+}
+
+void ppgso::RenderTarget::bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, texture.getWidth(), texture.getHeight());
+}
+
+ppgso::Texture &ppgso::RenderTarget::getTexture() {
+  return texture;
+}
+
+GLuint ppgso::RenderTarget::getFramebuffer() const {
+  return fbo;
+}
+
+int ppgso::RenderTarget::getWidth() const {
+  return texture.getWidth();
+}
+
+int ppgso::RenderTarget::getHeight() const {
+  return texture.getHeight();
+}
+
+bool ppgso::RenderTarget::hasDepth() const {
+  return rbo != 0;
+}
+
+size_t ppgso::RenderTarget::getByteSize() const {
+  // GL_DEPTH24_STENCIL8 takes 4 bytes per pixel
+  auto depthBytes = hasDepth() ? (size_t) getWidth() * getHeight() * 4 : 0;
+  return texture.getByteSize() + depthBytes;
+}
+
+std::shared_ptr<ppgso::RenderTarget> ppgso::RenderTargetPool::acquire(int width, int height, Texture::Format format,
+                                                                     bool depth) {
+  for (auto &target : targets) {
+    // Only the pool holds a reference, nobody renders to or samples from the target
+    if (target.use_count() > 1) continue;
+    if (target->getWidth() != width || target->getHeight() != height) continue;
+    if (target->getTexture().getFormat() != format || target->hasDepth() != depth) continue;
+    return target;
+  }
+  targets.push_back(std::make_shared<RenderTarget>(width, height, format, depth));
+  return targets.back();
+}
+
+void ppgso::RenderTargetPool::trim() {
+  targets.erase(std::remove_if(targets.begin(), targets.end(), [](const std::shared_ptr<RenderTarget> &target) {
+    return target.use_count() == 1;
+  }), targets.end());
+}
+
+size_t ppgso::RenderTargetPool::size() const {
+  return targets.size();
+}
+
+size_t ppgso::RenderTargetPool::getByteSize() const {
+  size_t bytes = 0;
+  for (auto &target : targets) bytes += target->getByteSize();
+  return bytes;
+}
+
+ppgso::RenderTargetPool &ppgso::RenderTargetPool::instance() {
+  static RenderTargetPool pool;
+  return pool;
+}
+
+ppgso::PostChain::PostChain(RenderTargetPool &pool) : pool{pool} {
+  // Core profile refuses to draw without a vertex array, even when no attributes are read
+  glGenVertexArrays(1, &vao);
+
+  // Presents the result when no shader pass writes to the screen, the default framebuffer
+  // may be multisampled and therefore can not be the target of a blit
+  copy = ShaderCache::get(post_vert_glsl, post_copy_frag_glsl);
+}
+
+ppgso::PostChain::~PostChain() {
+  RenderState::forgetVertexArray(vao);
+  glDeleteVertexArrays(1, &vao);
+}
+
+size_t ppgso::PostChain::add(std::shared_ptr<Shader> shader, float scale, Setup setup) {
+  passes.push_back({std::move(shader), scale, std::move(setup), nullptr, true});
+  return passes.size() - 1;
+}
+
+size_t ppgso::PostChain::addCustom(Run run, float scale) {
+  passes.push_back({nullptr, scale, nullptr, std::move(run), true});
+  return passes.size() - 1;
+}
+
+void ppgso::PostChain::setEnabled(size_t pass, bool enabled) {
+  passes.at(pass).enabled = enabled;
+}
+
+bool ppgso::PostChain::isEnabled(size_t pass) const {
+  return passes.at(pass).enabled;
+}
+
+void ppgso::PostChain::begin(int width, int height) {
+  // Targets of the previous size would never be matched again
+  if (width != this->width || height != this->height) pool.trim();
+  this->width = width;
+  this->height = height;
+
+  scene = pool.acquire(width, height, Texture::Format::RGBA8, true);
+  scene->bind();
+}
+
+void ppgso::PostChain::end() {
+  if (!scene)
+    throw std::runtime_error("PostChain::end called without begin!");
+
+  std::vector<const Pass *> active;
+  for (auto &pass : passes)
+    if (pass.enabled) active.push_back(&pass);
+
+  // Fullscreen passes cover every pixel exactly once, depth and blending would only cost bandwidth
+  auto depthTest = RenderState::isEnabled(GL_DEPTH_TEST);
+  auto blend = RenderState::isEnabled(GL_BLEND);
+  auto cullFace = RenderState::isEnabled(GL_CULL_FACE);
+  RenderState::setEnabled(GL_DEPTH_TEST, false);
+  RenderState::setEnabled(GL_BLEND, false);
+  RenderState::setEnabled(GL_CULL_FACE, false);
+
+  auto source = scene;
+  bool presented = false;
+  for (size_t i = 0; i < active.size(); i++) {
+    auto &pass = *active[i];
+    auto passWidth = std::max(1, (int) ((float) width * pass.scale));
+    auto passHeight = std::max(1, (int) ((float) height * pass.scale));
+
+    if (pass.run) {
+      auto output = pool.acquire(passWidth, passHeight);
+      pass.run(source->getTexture(), *output);
+      source = output;
+      continue;
+    }
+
+    // Last pass goes straight to the screen, the others to the next free pooled target
+    std::shared_ptr<RenderTarget> output;
+    if (i + 1 == active.size()) {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glViewport(0, 0, width, height);
+      presented = true;
+    } else {
+      output = pool.acquire(passWidth, passHeight);
+      output->bind();
+    }
+
+    pass.shader->use();
+    pass.shader->setUniform("Source", source->getTexture(), 0);
+    pass.shader->setUniform("Scene", scene->getTexture(), 1);
+    pass.shader->setUniform("TexelSize", glm::vec2{1.0f / (float) source->getWidth(), 1.0f / (float) source->getHeight()});
+    if (pass.setup) pass.setup(*pass.shader);
+    RenderState::bindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Releasing the input returns it to the pool for the pass after next
+    source = output;
+  }
+
+  if (!presented) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    copy->use();
+    copy->setUniform("Source", source->getTexture(), 0);
+    RenderState::bindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, width, height);
+  RenderState::setEnabled(GL_DEPTH_TEST, depthTest);
+  RenderState::setEnabled(GL_BLEND, blend);
+  RenderState::setEnabled(GL_CULL_FACE, cullFace);
+  scene.reset();
+}
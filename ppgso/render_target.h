@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include "texture.h"
+#include "shader.h"
+
+namespace ppgso {
+
+  /*!
+   * Framebuffer object with a colour texture and an optional depth/stencil renderbuffer,
+   * the reusable form of the framebuffer set up by hand in gl8_framebuffer.
+   */
+  class RenderTarget {
+  public:
+    /*!
+     * Create framebuffer and its attachments
+     *
+     * @param width - Width in pixels
+     * @param height - Height in pixels
+     * @param format - Uncompressed format of the colour texture (RGBA8 default)
+     * @param depth - Attach a depth/stencil renderbuffer, needed when rendering geometry (true default)
+     */
+    RenderTarget(int width, int height, Texture::Format format = Texture::Format::RGBA8, bool depth = true);
+
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget &operator=(const RenderTarget&) = delete;
+
+    /*!
+     * Direct rendering into this target and set the viewport to cover it
+     */
+    void bind() const;
+
+    /*!
+     * Get the colour attachment, can be passed to Shader::setUniform as any other texture
+     * @return Colour texture
+     */
+    Texture &getTexture();
+
+    /*!
+     * Get OpenGL framebuffer identifier number
+     * @return OpenGL framebuffer identifier number
+     */
+    GLuint getFramebuffer() const;
+
+    int getWidth() const;
+    int getHeight() const;
+    bool hasDepth() const;
+
+    /*!
+     * Get the GPU memory used by the attachments
+     * @return Size in bytes
+     */
+    size_t getByteSize() const;
+
+  private:
+    Texture texture;
+    GLuint fbo = 0;
+    GLuint rbo = 0;
+  };
+
+  /*!
+   * Pool of render targets reused across passes and frames.
+   * A target is free again as soon as every shared pointer handed out for it is released,
+   * so two passes of the same size alternating between acquire and release ping-pong between two targets.
+   */
+  class RenderTargetPool {
+  public:
+    /*!
+     * Get a free target with the requested properties, creating one only if none is free
+     *
+     * @param width - Width in pixels
+     * @param height - Height in pixels
+     * @param format - Format of the colour texture
+     * @param depth - Target needs a depth/stencil attachment
+     * @return Shared target, returned to the pool when released
+     */
+    std::shared_ptr<RenderTarget> acquire(int width, int height, Texture::Format format = Texture::Format::RGBA8,
+                                          bool depth = false);
+
+    /*!
+     * Destroy targets that are not in use, for example after the window was resized
+     */
+    void trim();
+
+    /*!
+     * Get the number of targets held by the pool
+     * @return Number of free and used targets
+     */
+    size_t size() const;
+
+    /*!
+     * Get the GPU memory used by all targets held by the pool
+     * @return Size in bytes
+     */
+    size_t getByteSize() const;
+
+    static RenderTargetPool &instance();
+
+  private:
+    std::vector<std::shared_ptr<RenderTarget>> targets;
+  };
+
+  /*!
+   * Chain of fullscreen post-processing passes applied once per screen pixel after the scene is rendered.
+   *
+   * The scene is rendered into a pooled target between begin() and end(), every enabled pass then draws
+   * a fullscreen triangle into the next pooled target and the last one draws to the default framebuffer.
+   * Each pass shader has the following inputs:
+   *  - Source - Output of the previous pass (the scene for the first one)
+   *  - Scene - Colour of the rendered scene at full resolution
+   *  - TexelSize - Size of one Source texel in texture coordinates
+   * Vertex shader of a pass receives no attributes, shader/post_vert.glsl generates the triangle from gl_VertexID.
+   */
+  class PostChain {
+  public:
+    /*!
+     * Callback setting the pass specific uniforms, the shader is already in use when called
+     */
+    using Setup = std::function<void(const Shader &)>;
+
+    /*!
+     * Pass that renders by itself, for example with a compute shader, from source into output
+     */
+    using Run = std::function<void(Texture &source, RenderTarget &output)>;
+
+    /*!
+     * Create empty chain
+     *
+     * @param pool - Pool the intermediate targets are taken from (shared pool default)
+     */
+    PostChain(RenderTargetPool &pool = RenderTargetPool::instance());
+
+    ~PostChain();
+
+    PostChain(const PostChain&) = delete;
+    PostChain &operator=(const PostChain&) = delete;
+
+    /*!
+     * Append a pass to the chain
+     *
+     * @param shader - Pass shader program
+     * @param scale - Resolution of the pass output relative to the screen, 0.5 for half resolution passes (1 default)
+     * @param setup - Optional callback setting additional uniforms
+     * @return Index of the pass for setEnabled()
+     */
+    size_t add(std::shared_ptr<Shader> shader, float scale = 1.0f, Setup setup = nullptr);
+
+    /*!
+     * Append a pass doing its own rendering, its output is copied to the screen when it ends the chain
+     *
+     * @param run - Function filling the pooled output target from the source texture
+     * @param scale - Resolution of the pass output relative to the screen (1 default)
+     * @return Index of the pass for setEnabled()
+     */
+    size_t addCustom(Run run, float scale = 1.0f);
+
+    /*!
+     * Switch a pass on or off, disabled passes are skipped without any cost
+     *
+     * @param pass - Index returned by add()
+     * @param enabled - New state of the pass
+     */
+    void setEnabled(size_t pass, bool enabled);
+
+    /*!
+     * Check if pass is switched on
+     * @param pass - Index returned by add()
+     * @return True when the pass runs
+     */
+    bool isEnabled(size_t pass) const;
+
+    /*!
+     * Start rendering the scene into an offscreen target with depth.
+     * The target is bound and its viewport set, clearing is left to the caller.
+     *
+     * @param width - Width of the screen framebuffer in pixels
+     * @param height - Height of the screen framebuffer in pixels
+     */
+    void begin(int width, int height);
+
+    /*!
+     * Run all enabled passes and present the result in the default framebuffer
+     */
+    void end();
+
+  private:
+    struct Pass {
+      std::shared_ptr<Shader> shader;
+      float scale;
+      Setup setup;
+      Run run;
+      bool enabled;
+    };
+
+    RenderTargetPool &pool;
+    std::vector<Pass> passes;
+    std::shared_ptr<Shader> copy;
+    std::shared_ptr<RenderTarget> scene;
+    GLuint vao = 0;
+    int width = 0, height = 0;
+  };
+}
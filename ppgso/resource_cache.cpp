@@ -0,0 +1,92 @@
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include "resource_cache.h"
+
+namespace {
+  bool endsWith(const std::string &value, const std::string &suffix) {
+    if (suffix.size() > value.size()) return false;
+    return std::equal(suffix.rbegin(), suffix.rend(), value.rbegin(),
+                      [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+  }
+
+  // Programs are keyed by their full sources, a hash collision must never hand out a different program.
+  // The vertex source length marks where the fragment source starts, compute keys start with a letter instead.
+  std::string programKey(const std::string &vertex, const std::string &fragment) {
+    return std::to_string(vertex.size()) + '#' + vertex + fragment;
+  }
+
+  std::string programKey(const std::string &compute) {
+    return "compute#" + compute;
+  }
+}
+
+std::shared_ptr<ppgso::Texture> ppgso::TextureCache::get(const std::string &path, Texture::Format format, int flags) {
+  std::stringstream key;
+  key << path << '#' << (int) format;
+  return instance().get(key.str(), [&]() {
+    if (endsWith(path, ".dds"))
+      return std::make_unique<Texture>(image::loadDDS(path));
+    return std::make_unique<Texture>(image::loadBMP(path), format, flags | Texture::Immutable);
+  });
+}
+
+bool ppgso::TextureCache::stream(size_t bytes) {
+  bool complete = true;
+  instance().forEach([&](Texture &texture) {
+    if (texture.isComplete()) return;
+    if (bytes == 0) {
+      complete = false;
+      return;
+    }
+    // Charge the budget by what this texture is going to move
+    size_t slice = std::min(bytes, texture.getPendingBytes());
+    complete = texture.stream(slice) && complete;
+    bytes -= slice;
+  });
+  return complete;
+}
+
+ppgso::ResourceCache<ppgso::Texture> &ppgso::TextureCache::instance() {
+  static ResourceCache<Texture> cache;
+  return cache;
+}
+
+std::shared_ptr<ppgso::Mesh> ppgso::MeshCache::get(const std::string &path, int lodLevels) {
+  std::stringstream key;
+  key << path << '#' << lodLevels;
+  return instance().get(key.str(), [&]() {
+    return std::make_unique<Mesh>(path, lodLevels);
+  });
+}
+
+ppgso::ResourceCache<ppgso::Mesh> &ppgso::MeshCache::instance() {
+  static ResourceCache<Mesh> cache;
+  return cache;
+}
+
+std::shared_ptr<ppgso::Shader> ppgso::ShaderCache::get(const std::string &vertex_shader_code,
+                                                       const std::string &fragment_shader_code) {
+  return instance().get(programKey(vertex_shader_code, fragment_shader_code), [&]() {
+    return std::make_unique<Shader>(vertex_shader_code, fragment_shader_code);
+  });
+}
+
+std::shared_ptr<ppgso::Shader> ppgso::ShaderCache::get(const std::string &vertex_shader_code,
+                                                       const std::string &fragment_shader_code, int features) {
+  // Permutations are keyed like any other program, by the sources with their #defines in place
+  auto defines = Shader::defines(features);
+  return get(Shader::withDefines(vertex_shader_code, defines), Shader::withDefines(fragment_shader_code, defines));
+}
+
+std::shared_ptr<ppgso::Shader> ppgso::ShaderCache::getCompute(const std::string &compute_shader_code) {
+  return instance().get(programKey(compute_shader_code), [&]() {
+    return std::make_unique<Shader>(compute_shader_code);
+  });
+}
+
+ppgso::ResourceCache<ppgso::Shader> &ppgso::ShaderCache::instance() {
+  static ResourceCache<Shader> cache;
+  return cache;
+}
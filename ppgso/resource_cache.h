@@ -0,0 +1,209 @@
+#pragma once
+#include <string>
+#include <map>
+#include <memory>
+#include <functional>
+
+#include "ppgso.h"
+
+namespace ppgso {
+
+  /*!
+   * Process wide cache of GPU resources keyed by a string (usually the file path).
+   * Resources are handed out as shared pointers so identical assets are loaded and uploaded once,
+   * the cache keeps its own reference until the entry is evicted.
+   */
+  template<typename T>
+  class ResourceCache {
+  public:
+    struct Stats {
+      size_t entries = 0;   // Resources currently held by the cache
+      size_t bytes = 0;     // GPU memory used by the held resources
+      size_t hits = 0;      // Requests served from the cache
+      size_t misses = 0;    // Requests that had to load the resource
+      size_t evictions = 0; // Resources released by eviction
+    };
+
+    /*!
+     * Get resource stored under key, loading it on first use
+     *
+     * @param key - Unique key of the resource
+     * @param load - Function creating the resource on a cache miss
+     * @return Shared pointer to the resource
+     */
+    std::shared_ptr<T> get(const std::string &key, const std::function<std::unique_ptr<T>()> &load) {
+      auto found = entries.find(key);
+      if (found != entries.end()) {
+        found->second.lastUse = ++clock;
+        statistics.hits++;
+        return found->second.resource;
+      }
+
+      statistics.misses++;
+      Entry entry;
+      entry.resource = std::shared_ptr<T>(load());
+      entry.bytes = byteSize(*entry.resource);
+      entry.lastUse = ++clock;
+      statistics.bytes += entry.bytes;
+      auto resource = entry.resource;
+      entries.emplace(key, std::move(entry));
+
+      if (budget) evict(budget);
+      return resource;
+    }
+
+    /*!
+     * Release least recently used resources not referenced outside the cache
+     * until the memory used drops below the limit
+     *
+     * @param limit - Memory limit in bytes, 0 releases all unreferenced resources
+     */
+    void evict(size_t limit = 0) {
+      while (statistics.bytes > limit || limit == 0) {
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+          if (it->second.resource.use_count() > 1) continue;
+          if (victim == entries.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+        }
+        if (victim == entries.end()) break;
+        statistics.bytes -= victim->second.bytes;
+        statistics.evictions++;
+        entries.erase(victim);
+      }
+    }
+
+    /*!
+     * Set memory budget, unreferenced resources are evicted when a new load exceeds it
+     *
+     * @param bytes - Budget in bytes, 0 disables automatic eviction
+     */
+    void setBudget(size_t bytes) {
+      budget = bytes;
+      if (budget) evict(budget);
+    }
+
+    /*!
+     * Drop all entries, resources still referenced elsewhere stay alive until released by their owners
+     */
+    void clear() {
+      statistics.evictions += entries.size();
+      statistics.bytes = 0;
+      entries.clear();
+    }
+
+    /*!
+     * Call function for every resource held by the cache
+     * @param function - Callback receiving each resource
+     */
+    void forEach(const std::function<void(T &)> &function) {
+      for (auto &entry : entries) function(*entry.second.resource);
+    }
+
+    /*!
+     * Get cache statistics
+     * @return Current entry count, memory usage and hit/miss counters
+     */
+    Stats stats() const {
+      auto result = statistics;
+      result.entries = entries.size();
+      return result;
+    }
+
+  private:
+    struct Entry {
+      std::shared_ptr<T> resource;
+      size_t bytes = 0;
+      size_t lastUse = 0;
+    };
+
+    static size_t byteSize(const T &resource) {
+      return resource.getByteSize();
+    }
+
+    std::map<std::string, Entry> entries;
+    Stats statistics;
+    size_t budget = 0;
+    size_t clock = 0;
+  };
+
+  /*!
+   * Shared texture cache, keyed by file path and storage format
+   * Cached textures are shared and therefore immutable, their CPU side images are released after upload.
+   */
+  class TextureCache {
+  public:
+    /*!
+     * Get texture loaded from a BMP or DDS image (chosen by file extension)
+     *
+     * @param path - File path to the image
+     * @param format - Storage format for uncompressed images
+     * @param flags - Texture flags used when the texture is first loaded, Immutable is always added
+     * @return Shared texture
+     */
+    static std::shared_ptr<Texture> get(const std::string &path, Texture::Format format = Texture::Format::RGB8,
+                                        int flags = Texture::Immutable);
+
+    /*!
+     * Continue uploading cached Streamed textures, call once per frame
+     *
+     * @param bytes - Upload budget shared by all pending textures
+     * @return True when no texture has pending rows left
+     */
+    static bool stream(size_t bytes = 1 << 20);
+
+    static ResourceCache<Texture> &instance();
+  };
+
+  /*!
+   * Shared mesh cache, keyed by file path and levels of detail
+   */
+  class MeshCache {
+  public:
+    /*!
+     * Get mesh loaded from a model file
+     *
+     * @param path - File path to the model
+     * @param lodLevels - Levels of detail including the full mesh, 1 builds none (1 default)
+     * @return Shared mesh
+     */
+    static std::shared_ptr<Mesh> get(const std::string &path, int lodLevels = 1);
+
+    static ResourceCache<Mesh> &instance();
+  };
+
+  /*!
+   * Shared shader cache, keyed by the shader sources
+   */
+  class ShaderCache {
+  public:
+    /*!
+     * Get shader program compiled from the given sources
+     *
+     * @param vertex_shader_code - Source of the vertex shader
+     * @param fragment_shader_code - Source of the fragment shader
+     * @return Shared shader program
+     */
+    static std::shared_ptr<Shader> get(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
+
+    /*!
+     * Get permutation of a shader program, every combination of features is compiled once
+     *
+     * @param vertex_shader_code - Source of the vertex shader
+     * @param fragment_shader_code - Source of the fragment shader
+     * @param features - Combination of Shader::Feature flags
+     * @return Shared shader program
+     */
+    static std::shared_ptr<Shader> get(const std::string &vertex_shader_code, const std::string &fragment_shader_code,
+                                       int features);
+
+    /*!
+     * Get compute program compiled from the given source
+     *
+     * @param compute_shader_code - Source of the compute shader
+     * @return Shared compute program
+     */
+    static std::shared_ptr<Shader> getCompute(const std::string &compute_shader_code);
+
+    static ResourceCache<Shader> &instance();
+  };
+}
@@ -7,82 +7,161 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "render_state.h"
+#include "program_cache.h"
+
+
+namespace {
+  /*!
+   * Compile a single shader stage, throws with the driver log on failure
+   */
+  GLuint compileShader(GLenum type, const std::string &code, const char *stage) {
+    auto shader_id = glCreateShader(type);
+    auto result = GL_FALSE;
+    auto info_length = 0;
+
+    auto shader_code_ptr = code.c_str();
+    glShaderSource(shader_id, 1, &shader_code_ptr, nullptr);
+    glCompileShader(shader_id);
+
+    // Check shader log
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_length);
+      std::string shader_log((unsigned long) info_length, ' ');
+      glGetShaderInfoLog(shader_id, info_length, nullptr, &shader_log[0]);
+      glDeleteShader(shader_id);
+      std::stringstream msg;
+      msg << "Error Compiling " << stage << " Shader ..." << std::endl;
+      msg << shader_log << std::endl;
+      throw std::runtime_error(msg.str());
+    }
+    return shader_id;
+  }
 
+  /*!
+   * Check program link status, throws with the driver log on failure
+   */
+  void checkProgram(GLuint program_id) {
+    auto result = GL_FALSE;
+    auto info_length = 0;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_length);
+      std::string program_log((unsigned long) info_length, ' ');
+      glGetProgramInfoLog(program_id, info_length, nullptr, &program_log[0]);
+      glDeleteProgram(program_id);
+      std::stringstream msg;
+      msg << "Error Linking Shader Program ..." << std::endl;
+      msg << program_log;
+      throw std::runtime_error(msg.str());
+    }
+  }
+}
 
 ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
-  // Create shaders
-  auto vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-  auto fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
-  auto result = GL_FALSE;
-  auto info_length = 0;
-
-  // Compile vertex shader
-  auto vertex_shader_code_ptr = vertex_shader_code.c_str();
-  glShaderSource(vertex_shader_id, 1, &vertex_shader_code_ptr, nullptr);
-  glCompileShader(vertex_shader_id);
-
-  // Check vertex shader log
-  glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string vertex_shader_log((unsigned int) info_length, ' ');
-    glGetShaderInfoLog(vertex_shader_id, info_length, nullptr,
-                       &vertex_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Vertex Shader ..." << std::endl;
-    msg << vertex_shader_log;
-    throw std::runtime_error(msg.str());
+  // Binary stored by an earlier run skips compilation and linking entirely
+  auto key = ProgramCache::key(vertex_shader_code, fragment_shader_code);
+  auto program_id = glCreateProgram();
+  if (ProgramCache::load(key, program_id)) {
+    program = program_id;
+    use();
+    return;
   }
 
-  // Compile fragment shader
-  auto fragment_shader_code_ptr = fragment_shader_code.c_str();
-  glShaderSource(fragment_shader_id, 1, &fragment_shader_code_ptr, nullptr);
-  glCompileShader(fragment_shader_id);
-
-  // Check fragment shader log
-  glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string fragment_shader_log((unsigned long) info_length, ' ');
-    glGetShaderInfoLog(fragment_shader_id, info_length, nullptr,
-                       &fragment_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Fragment Shader ..." << std::endl;
-    msg << fragment_shader_log << std::endl;
-    throw std::runtime_error(msg.str());
+  // Compile shaders
+  GLuint vertex_shader_id;
+  try {
+    vertex_shader_id = compileShader(GL_VERTEX_SHADER, vertex_shader_code, "Vertex");
+  } catch (...) {
+    glDeleteProgram(program_id);
+    throw;
+  }
+  GLuint fragment_shader_id;
+  try {
+    fragment_shader_id = compileShader(GL_FRAGMENT_SHADER, fragment_shader_code, "Fragment");
+  } catch (...) {
+    glDeleteShader(vertex_shader_id);
+    glDeleteProgram(program_id);
+    throw;
   }
 
-  // Create and link the program
-  auto program_id = glCreateProgram();
+  // Link the program
   glAttachShader(program_id, vertex_shader_id);
   glAttachShader(program_id, fragment_shader_id);
   glBindFragDataLocation(program_id, 0, "FragmentColor");
+  ProgramCache::prepare(program_id);
   glLinkProgram(program_id);
+  glDeleteShader(vertex_shader_id);
+  glDeleteShader(fragment_shader_id);
 
   // Check program log
-  glGetProgramiv(program_id, GL_LINK_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string program_log((unsigned long) info_length, ' ');
-    glGetProgramInfoLog(program_id, info_length, nullptr, &program_log[0]);
-    std::stringstream msg;
-    msg << "Error Linking Shader Program ..." << std::endl;
-    msg << program_log;
-    throw std::runtime_error(msg.str());
+  checkProgram(program_id);
+  ProgramCache::store(key, program_id);
+
+  program = program_id;
+  use();
+}
+
+ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code, int features)
+    : Shader{withDefines(vertex_shader_code, defines(features)), withDefines(fragment_shader_code, defines(features))} {}
+
+ppgso::Shader::Shader(const std::string &compute_shader_code) {
+  if (!GLEW_ARB_compute_shader)
+    throw std::runtime_error("Compute shaders are not supported by the OpenGL driver!");
+
+  auto key = ProgramCache::key(compute_shader_code);
+  auto program_id = glCreateProgram();
+  if (ProgramCache::load(key, program_id)) {
+    program = program_id;
+    use();
+    return;
   }
-  glDeleteShader(vertex_shader_id);
-  glDeleteShader(fragment_shader_id);
+
+  GLuint compute_shader_id;
+  try {
+    compute_shader_id = compileShader(GL_COMPUTE_SHADER, compute_shader_code, "Compute");
+  } catch (...) {
+    glDeleteProgram(program_id);
+    throw;
+  }
+
+  glAttachShader(program_id, compute_shader_id);
+  ProgramCache::prepare(program_id);
+  glLinkProgram(program_id);
+  glDeleteShader(compute_shader_id);
+
+  checkProgram(program_id);
+  ProgramCache::store(key, program_id);
 
   program = program_id;
   use();
 }
 
 ppgso::Shader::~Shader() {
+  RenderState::forgetProgram(program);
   glDeleteProgram( program );
 }
 
+std::string ppgso::Shader::defines(int features) {
+  std::string result;
+  if (features & NormalMap) result += "#define NORMAL_MAP\n";
+  if (features & PointLight) result += "#define POINT_LIGHT\n";
+  if (features & Transparent) result += "#define TRANSPARENT\n";
+  if (features & Fog) result += "#define FOG\n";
+  if (features & Lighting) result += "#define LIGHTING\n";
+  return result;
+}
+
+std::string ppgso::Shader::withDefines(const std::string &code, const std::string &defines) {
+  // GLSL requires #version to come first, everything else may follow it
+  auto line = code.find('\n');
+  if (line == std::string::npos) return code + "\n" + defines;
+  return code.substr(0, line + 1) + defines + code.substr(line + 1);
+}
+
 void ppgso::Shader::use() const {
-  glUseProgram(program);
+  RenderState::useProgram(program);
 }
 
 GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
@@ -120,6 +199,13 @@ void ppgso::Shader::setUniform(const std::string &name, float value) const {
   glUniform1f(uniform, value);
 }
 
+size_t ppgso::Shader::getByteSize() const {
+  if (!GLEW_ARB_get_program_binary) return 0;
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  return (size_t) length;
+}
+
 GLuint ppgso::Shader::getProgram() const {
   return program;
 }
@@ -11,6 +11,17 @@ namespace ppgso {
 
   class Shader {
   public:
+    /*!
+     * Optional features of a program, each one is compiled in as a #define of the same name
+     * in upper case with underscores. Shaders document which of them they understand.
+     */
+    enum Feature {
+      NormalMap = 1 << 0,   // NORMAL_MAP, shade with the normal map texture
+      PointLight = 1 << 1,  // POINT_LIGHT, point light diffuse and specular terms
+      Transparent = 1 << 2, // TRANSPARENT, alpha from the texture and the Transparency uniform
+      Fog = 1 << 3,         // FOG, exponential fog by distance from the camera
+      Lighting = 1 << 4     // LIGHTING, lit instead of plain base color where a shader offers both
+    };
 
     /*!
      * Compile and manage an GLSL program and its inputs.
@@ -20,8 +31,41 @@ namespace ppgso {
      */
     Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
 
+    /*!
+     * Compile a permutation of the program with the feature #defines injected into both stages.
+     *
+     * @param vertex_shader_code - String containing the source of the vertex shader.
+     * @param fragment_shader_code - String containing the source of the fragment shader.
+     * @param features - Combination of Feature flags.
+     */
+    Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code, int features);
+
+    /*!
+     * Compile compute program, requires ARB_compute_shader (OpenGL 4.3).
+     *
+     * @param compute_shader_code - String containing the source of the compute shader.
+     */
+    explicit Shader(const std::string &compute_shader_code);
+
     ~Shader();
 
+    /*!
+     * Get preprocessor definitions of features
+     *
+     * @param features - Combination of Feature flags.
+     * @return - One #define line per feature.
+     */
+    static std::string defines(int features);
+
+    /*!
+     * Insert preprocessor definitions right after the #version line of a shader source
+     *
+     * @param code - Shader source starting with its #version line.
+     * @param defines - Lines to insert.
+     * @return - Modified source.
+     */
+    static std::string withDefines(const std::string &code, const std::string &defines);
+
     /*!
      * Set up the program for use in OpenGL state.
      */
@@ -50,6 +94,13 @@ namespace ppgso {
      */
     GLuint getProgram() const;
 
+    /*!
+     * Get the driver reported size of the linked program binary.
+     *
+     * @return - Size in bytes, 0 when program binaries are not supported.
+     */
+    size_t getByteSize() const;
+
     /*!
      * Set a floating point value as an input for the shader program variable "name"
      *
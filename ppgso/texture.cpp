@@ -1,53 +1,296 @@
 #include <iostream>
+#include <sstream>
+#include <algorithm>
 
 #include "texture.h"
+#include "render_state.h"
 
-ppgso::Texture::Texture(int width, int height) : image{width, height} {
-  initGL();
-  update();
+namespace {
+  // OpenGL internal format, upload format and bytes per pixel for uncompressed storage
+  struct FormatInfo {
+    GLenum internalFormat;
+    GLenum dataFormat;
+    size_t channels;
+  };
+
+  FormatInfo formatInfo(ppgso::Texture::Format format) {
+    using Format = ppgso::Texture::Format;
+    switch (format) {
+      case Format::RGB8: return {GL_RGB8, GL_RGB, 3};
+      case Format::RGBA8: return {GL_RGBA8, GL_RGBA, 4};
+      case Format::SRGB8: return {GL_SRGB8, GL_RGB, 3};
+      case Format::SRGB8_ALPHA8: return {GL_SRGB8_ALPHA8, GL_RGBA, 4};
+      case Format::R8: return {GL_R8, GL_RED, 1};
+      case Format::RG8: return {GL_RG8, GL_RG, 2};
+      case Format::BC1: return {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0};
+      case Format::BC1_SRGB: return {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0};
+      case Format::BC3: return {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0};
+      case Format::BC3_SRGB: return {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0};
+      case Format::BC5: return {GL_COMPRESSED_RG_RGTC2, 0, 0};
+    }
+    return {GL_RGB8, GL_RGB, 3};
+  }
+
+  ppgso::Texture::Format textureFormat(ppgso::CompressedImage::Format format) {
+    using Format = ppgso::CompressedImage::Format;
+    switch (format) {
+      case Format::BC1: return ppgso::Texture::Format::BC1;
+      case Format::BC1_SRGB: return ppgso::Texture::Format::BC1_SRGB;
+      case Format::BC3: return ppgso::Texture::Format::BC3;
+      case Format::BC3_SRGB: return ppgso::Texture::Format::BC3_SRGB;
+      case Format::BC5: return ppgso::Texture::Format::BC5;
+    }
+    return ppgso::Texture::Format::BC1;
+  }
+}
+
+ppgso::Texture::Texture(int width, int height, Format format, int flags)
+    : image{flags & Attachment ? 0 : width, flags & Attachment ? 0 : height}, format{format}, flags{flags}, width{width}, height{height} {
+  initGL(width, height);
+  if (!(flags & Attachment)) upload();
 }
 
-ppgso::Texture::Texture(Image&& image) : image{std::move(image)} {
-  initGL();
-  update();
+ppgso::Texture::Texture(Image&& image, Format format, int flags)
+    : image{std::move(image)}, format{format}, flags{flags}, width{this->image.width}, height{this->image.height} {
+  initGL(width, height);
+
+  if (!(flags & Streamed)) {
+    upload();
+    finishUpload();
+    return;
+  }
+
+  // Until the slices arrive only the 1x1 level holding the average colour is sampled
+  auto &framebuffer = this->image.getFramebuffer();
+  auto &alpha = this->image.getAlpha();
+  size_t sum[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < framebuffer.size(); i++) {
+    sum[0] += framebuffer[i].r;
+    sum[1] += framebuffer[i].g;
+    sum[2] += framebuffer[i].b;
+    sum[3] += alpha.empty() ? 255 : alpha[i];
+  }
+  auto count = std::max<size_t>(1, framebuffer.size());
+  uint8_t average[4] = {(uint8_t) (sum[0] / count), (uint8_t) (sum[1] / count),
+                        (uint8_t) (sum[2] / count), (uint8_t) (sum[3] / count)};
+  auto info = formatInfo(format);
+  GLenum averageFormat = info.channels == 1 ? GL_RED : info.channels == 2 ? GL_RG : GL_RGBA;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, levels - 1, 0, 0, 1, 1, averageFormat, GL_UNSIGNED_BYTE, average);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+
+  glGenBuffers(1, &pixelBuffer);
+}
+
+ppgso::Texture::Texture(CompressedImage&& compressed)
+    : image{0, 0}, format{textureFormat(compressed.format)}, flags{Immutable}, width{compressed.width}, height{compressed.height} {
+  if (compressed.format == CompressedImage::Format::BC1 || compressed.format == CompressedImage::Format::BC1_SRGB ||
+      compressed.format == CompressedImage::Format::BC3 || compressed.format == CompressedImage::Format::BC3_SRGB) {
+    if (!GLEW_EXT_texture_compression_s3tc)
+      throw std::runtime_error("S3TC texture compression is not supported by the OpenGL driver!");
+  }
+
+  // Only the levels present in the file are allocated, sampling is clamped to them
+  levels = (int) compressed.levels.size();
+  glGenTextures(1, &texture);
+  bind(0);
+  glTexStorage2D(GL_TEXTURE_2D, levels, formatInfo(format).internalFormat, compressed.width, compressed.height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+  // Upload the blocks directly, no driver side conversion takes place
+  for (int level = 0; level < levels; level++) {
+    auto &data = compressed.levels[level];
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, std::max(1, width >> level), std::max(1, height >> level),
+                              formatInfo(format).internalFormat, (GLsizei) data.size(), data.data());
+    byteSize += data.size();
+  }
 }
 
 ppgso::Texture::~Texture() {
+  if (pixelBuffer) glDeleteBuffers(1, &pixelBuffer);
+  RenderState::forgetTexture(texture);
   glDeleteTextures(1, &texture);
 }
 
-void ppgso::Texture::initGL() {
+void ppgso::Texture::initGL(int width, int height) {
+  if (isCompressed())
+    throw std::runtime_error("Compressed textures can only be created from a CompressedImage!");
+
   // Create new texture object
   glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  bind(0);
+
+  // Reserve texture storage for the full mip chain, render targets are only ever sampled at level 0
+  levels = flags & Attachment ? 1 : mipLevels(width, height);
+  glTexStorage2D(GL_TEXTURE_2D, levels, formatInfo(format).internalFormat, width, height);
+
+  // Each level is a quarter of the previous one, 4/3 of the base level in total
+  auto channels = formatInfo(format).channels;
+  for (int level = 0; level < levels; level++)
+    byteSize += (size_t) std::max(1, width >> level) * (size_t) std::max(1, height >> level) * channels;
 
-  // Reserve texture storage
-  glTexStorage2D(GL_TEXTURE_2D, 3, GL_RGB8, image.width, image.height);
+  if (flags & Attachment) {
+    // Screen space filters must not wrap around the edges
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    return;
+  }
 
   // Set up mipmapping
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-  // Update texture with data from image framebuffer
-  update();
 }
 
 void ppgso::Texture::update() {
+  if (isCompressed()) return;
+  if (flags & (Immutable | Attachment))
+    throw std::runtime_error("Immutable texture has no CPU side image to update!");
+  upload();
+}
+
+void ppgso::Texture::upload() {
   bind();
+  auto info = formatInfo(format);
+
+  // Rows are tightly packed regardless of width
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
   // Upload texture to GPU
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+  if (info.channels == 3) {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, info.dataFormat, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+  } else {
+    std::vector<uint8_t> data((size_t) (width * height) * info.channels);
+    packRows(data.data(), 0, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, info.dataFormat, GL_UNSIGNED_BYTE, data.data());
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
   // Re-generate mipmaps
   glGenerateMipmap(GL_TEXTURE_2D);
 }
 
+bool ppgso::Texture::stream(size_t bytes) {
+  if (isComplete()) return true;
+
+  auto info = formatInfo(format);
+  auto rowBytes = (size_t) width * info.channels;
+  auto rows = (int) std::min<size_t>((size_t) (height - streamedRows), std::max<size_t>(1, bytes / rowBytes));
+  auto sliceBytes = rowBytes * rows;
+
+  // Orphan the previous slice so mapping never waits for the pending transfer
+  bind();
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) sliceBytes, nullptr, GL_STREAM_DRAW);
+  auto data = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) sliceBytes,
+                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (!data) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    throw std::runtime_error("Could not map texture pixel buffer!");
+  }
+  packRows(data, streamedRows, rows);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  // Source pointer is an offset into the bound pixel buffer, the copy happens asynchronously
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, streamedRows, width, rows, info.dataFormat, GL_UNSIGNED_BYTE, nullptr);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  streamedRows += rows;
+  if (!isComplete()) return false;
+
+  // Whole base level is resident, switch sampling over to the full chain
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glDeleteBuffers(1, &pixelBuffer);
+  pixelBuffer = 0;
+  finishUpload();
+  return true;
+}
+
+bool ppgso::Texture::isComplete() const {
+  return !(flags & Streamed) || streamedRows >= height;
+}
+
+size_t ppgso::Texture::getPendingBytes() const {
+  if (isComplete()) return 0;
+  return (size_t) (height - streamedRows) * width * formatInfo(format).channels;
+}
+
+void ppgso::Texture::packRows(uint8_t *data, int first, int count) {
+  // Repack the RGB framebuffer (and alpha if present) to the requested channel count
+  auto channels = formatInfo(format).channels;
+  auto &framebuffer = image.getFramebuffer();
+  auto &alpha = image.getAlpha();
+  auto begin = (size_t) first * width, end = (size_t) (first + count) * width;
+  if (channels == 3) {
+    std::copy((uint8_t *) &framebuffer[begin], (uint8_t *) &framebuffer[begin] + (end - begin) * 3, data);
+    return;
+  }
+  for (size_t i = begin; i < end; i++) {
+    auto &pixel = framebuffer[i];
+    auto out = data + (i - begin) * channels;
+    out[0] = pixel.r;
+    if (channels > 1) out[1] = pixel.g;
+    if (channels > 2) out[2] = pixel.b;
+    if (channels > 3) out[3] = alpha.empty() ? (uint8_t) 255 : alpha[i];
+  }
+}
+
+void ppgso::Texture::finishUpload() {
+  // Immutable textures do not need the CPU copy any more
+  if (flags & Immutable) image = Image{0, 0};
+}
+
 void ppgso::Texture::bind(int id) const {
-  glActiveTexture((GLenum) (GL_TEXTURE0 + id));
-  glBindTexture(GL_TEXTURE_2D, texture);
+  RenderState::bindTexture(id, texture);
 }
 
 GLuint ppgso::Texture::getTexture() {
   return texture;
 }
+
+ppgso::Texture::Format ppgso::Texture::getFormat() const {
+  return format;
+}
+
+int ppgso::Texture::getWidth() const {
+  return width;
+}
+
+int ppgso::Texture::getHeight() const {
+  return height;
+}
+
+size_t ppgso::Texture::getPixelBytes() const {
+  return formatInfo(format).channels;
+}
+
+GLenum ppgso::Texture::getDataFormat() const {
+  return formatInfo(format).dataFormat;
+}
+
+size_t ppgso::Texture::getByteSize() const {
+  return byteSize;
+}
+
+int ppgso::Texture::mipLevels(int width, int height) {
+  int levels = 1;
+  for (int size = std::max(width, height); size > 1; size >>= 1) levels++;
+  return levels;
+}
+
+bool ppgso::Texture::isCompressed() const {
+  return formatInfo(format).channels == 0;
+}
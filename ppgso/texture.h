@@ -7,34 +7,97 @@
 #include <GL/glew.h>
 
 #include "image.h"
+#include "image_dds.h"
 
 namespace ppgso {
 
   class Texture {
   public:
+    /*!
+     * GPU storage format of the texture.
+     * Uncompressed formats are filled from the Image, block compressed ones from a CompressedImage.
+     */
+    enum class Format {
+      RGB8,
+      RGBA8,
+      SRGB8,
+      SRGB8_ALPHA8,
+      R8,       // Red channel of the image only
+      RG8,      // Red and green channels of the image only
+      BC1,
+      BC1_SRGB,
+      BC3,
+      BC3_SRGB,
+      BC5
+    };
+
+    /*!
+     * Texture creation flags, combine with bitwise or
+     */
+    enum Flags {
+      Dynamic = 0,    // Keep the CPU side image for later update() calls
+      Immutable = 1,  // Release the CPU side image once the upload is finished
+      Streamed = 2,   // Upload the image in slices through a pixel buffer object, see stream()
+      Attachment = 4  // GPU only single level storage rendered to through a RenderTarget
+    };
 
     /*!
      * Create new empty texture and bind it to OpenGL.
      *
      * @param width - Width in pixels.
      * @param height - Height in pixels.
+     * @param format - Uncompressed storage format (RGB8 default)
+     * @param flags - Dynamic or Attachment (Dynamic default)
      */
-    Texture(int width, int height);
+    Texture(int width, int height, Format format = Format::RGB8, int flags = Dynamic);
 
     /*!
      * Load from image.
      *
      * @param image - Image to use
+     * @param format - Uncompressed storage format (RGB8 default)
+     * @param flags - Combination of Flags (Dynamic default)
      */
-    Texture(Image&& image);
+    Texture(Image&& image, Format format = Format::RGB8, int flags = Dynamic);
+
+    /*!
+     * Load from pre-compressed image, all mip levels present in the image are uploaded as is.
+     * The CPU side image of such texture is empty and update() has no effect.
+     *
+     * @param image - Block compressed image to use
+     */
+    Texture(CompressedImage&& image);
 
     ~Texture();
 
     /*!
      * Update the OpenGL texture in memory.
+     * Immutable and Attachment textures have no CPU side image and throw when updated.
      */
     void update();
 
+    /*!
+     * Upload the next slice of rows of a Streamed texture through the pixel buffer object.
+     * Until the last slice arrives the texture samples a single average colour, mip levels
+     * are generated once the whole image is resident.
+     *
+     * @param bytes - Upload budget for this call, at least one row is always uploaded
+     * @return True when the texture is completely uploaded
+     */
+    bool stream(size_t bytes = 1 << 20);
+
+    /*!
+     * Check if all image data has reached the GPU
+     * @return False while a Streamed texture still has rows pending
+     */
+    bool isComplete() const;
+
+    /*!
+     * Get the amount of image data a Streamed texture still has to upload
+     * @return Size in bytes, 0 once complete
+     */
+    size_t getPendingBytes() const;
+
     /*!
      * Get OpenGL texture identifier number.
      *
@@ -49,10 +112,65 @@ namespace ppgso {
      */
     void bind(int id = 0) const;
 
+    /*!
+     * Get the storage format of the texture
+     * @return Format used when the texture storage was allocated
+     */
+    Format getFormat() const;
+
+    /*!
+     * Get texture width, valid even after the CPU side image was released
+     * @return Width in pixels
+     */
+    int getWidth() const;
+
+    /*!
+     * Get texture height, valid even after the CPU side image was released
+     * @return Height in pixels
+     */
+    int getHeight() const;
+
+    /*!
+     * Get the number of bytes per pixel of uploaded data
+     * @return Channel count of the format, 0 for block compressed formats
+     */
+    size_t getPixelBytes() const;
+
+    /*!
+     * Get the OpenGL pixel data format used for uploads
+     * @return GL_RED, GL_RG, GL_RGB or GL_RGBA, 0 for block compressed formats
+     */
+    GLenum getDataFormat() const;
+
+    /*!
+     * Get the estimated GPU memory used by the texture including all mip levels
+     * @return Size in bytes
+     */
+    size_t getByteSize() const;
+
+    /*!
+     * Number of mip levels in a full chain down to 1x1
+     * @param width - Width of the base level in pixels
+     * @param height - Height of the base level in pixels
+     * @return floor(log2(max(width, height))) + 1
+     */
+    static int mipLevels(int width, int height);
+
     Image image;
   private:
-    void initGL();
+    void initGL(int width, int height);
+    bool isCompressed() const;
+    void upload();
+    void packRows(uint8_t *data, int first, int count);
+    void finishUpload();
     GLuint texture;
+    GLuint pixelBuffer = 0;
+    Format format;
+    int flags = Dynamic;
+    int width, height;
+    int levels;
+    int streamedRows = 0;
+    size_t byteSize = 0;
   };
 }
 
@@ -0,0 +1,102 @@
+#include <sstream>
+
+#include "texture_stream.h"
+
+ppgso::TextureStream::TextureStream(Texture &texture, int slots) : texture{texture}, fences((size_t) slots, nullptr) {
+  if (texture.getPixelBytes() == 0)
+    throw std::runtime_error("Compressed textures can not be streamed!");
+  if (slots < 1)
+    throw std::runtime_error("Texture stream needs at least one slot!");
+
+  // Keep every slot on its own cache lines so CPU writers never share them across frames
+  slotBytes = (size_t) texture.getWidth() * texture.getHeight() * texture.getPixelBytes();
+  slotStride = (slotBytes + 255) & ~(size_t) 255;
+  auto totalBytes = (GLsizeiptr) (slotStride * slots);
+
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  if (GLEW_ARB_buffer_storage) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, flags);
+    persistent = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes, flags);
+    if (!persistent) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      throw std::runtime_error("Could not persistently map texture stream buffer!");
+    }
+  } else {
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+ppgso::TextureStream::~TextureStream() {
+  for (auto fence : fences)
+    if (fence) glDeleteSync(fence);
+  if (persistent) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+  glDeleteBuffers(1, &buffer);
+}
+
+uint8_t *ppgso::TextureStream::map() {
+  if (mapped)
+    throw std::runtime_error("Texture stream slot is already mapped!");
+
+  // Wait for the copy that last read this slot, usually signalled frames ago
+  auto &fence = fences[current];
+  if (fence) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  mapped = true;
+  auto offset = slotStride * current;
+  if (persistent) return persistent + offset;
+
+  // The fence already guarantees the range is idle, so no implicit synchronization is needed
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  auto data = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr) offset, (GLsizeiptr) slotBytes,
+                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  if (!data) {
+    mapped = false;
+    throw std::runtime_error("Could not map texture stream buffer!");
+  }
+  return data;
+}
+
+void ppgso::TextureStream::unmap(bool generateMipmaps) {
+  if (!mapped)
+    throw std::runtime_error("Texture stream slot was not mapped!");
+  mapped = false;
+
+  texture.bind();
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  if (!persistent) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  // Copy from the slot offset, the transfer runs asynchronously to the CPU
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.getWidth(), texture.getHeight(), texture.getDataFormat(),
+                  GL_UNSIGNED_BYTE, (const void *) (slotStride * current));
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  // Skipped mip rebuilds would leave stale levels, keep sampling on level 0 until the next rebuild
+  if (generateMipmaps) {
+    if (!mipmapsValid) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  } else if (mipmapsValid) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  }
+  mipmapsValid = generateMipmaps;
+
+  fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  current = (current + 1) % (int) fences.size();
+}
+
+bool ppgso::TextureStream::isPersistent() const {
+  return persistent != nullptr;
+}
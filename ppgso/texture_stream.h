@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "texture.h"
+
+namespace ppgso {
+
+  /*!
+   * Ring of pixel buffer slots used to update a dynamic texture every frame without stalling.
+   * The CPU writes the next frame straight into mapped buffer memory while the GPU is still
+   * copying the previous ones, each slot is guarded by a fence so it is never overwritten in flight.
+   *
+   * With ARB_buffer_storage the ring is mapped once as persistent and coherent memory,
+   * otherwise every slot is mapped unsynchronized on demand and the fences do the same job.
+   */
+  class TextureStream {
+  public:
+    /*!
+     * Create pixel buffer ring for a texture
+     *
+     * @param texture - Uncompressed texture to update, has to outlive the stream
+     * @param slots - Number of frames that may be in flight (3 default)
+     */
+    TextureStream(Texture &texture, int slots = 3);
+
+    ~TextureStream();
+
+    TextureStream(const TextureStream&) = delete;
+    TextureStream &operator=(const TextureStream&) = delete;
+
+    /*!
+     * Acquire the next slot for writing, waits only if the GPU has not finished reading it yet.
+     * Rows are tightly packed in the channel layout of the texture format.
+     *
+     * @return Pointer to width * height * getPixelBytes() bytes of writable memory
+     */
+    uint8_t *map();
+
+    /*!
+     * Queue the slot acquired by map() for upload to the texture.
+     *
+     * @param generateMipmaps - Rebuild the mip chain from the new data, otherwise sampling is clamped to level 0
+     */
+    void unmap(bool generateMipmaps = false);
+
+    /*!
+     * Check which path the ring uses
+     * @return True when the ring memory is persistently mapped
+     */
+    bool isPersistent() const;
+
+  private:
+    Texture &texture;
+    GLuint buffer = 0;
+    std::vector<GLsync> fences;
+    size_t slotBytes, slotStride;
+    int current = 0;
+    uint8_t *persistent = nullptr;
+    bool mapped = false;
+    bool mipmapsValid = true;
+  };
+}
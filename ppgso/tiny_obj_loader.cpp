@@ -28,6 +28,7 @@
 // version 0.9.0 : Initial
 //
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
@@ -40,8 +41,14 @@
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <memory>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "tiny_obj_loader.h"
+#include "mapped_file.h"
 
 namespace tinyobj {
 
@@ -54,18 +61,6 @@ struct vertex_index {
   vertex_index(int vidx, int vtidx, int vnidx)
       : v_idx(vidx), vt_idx(vtidx), vn_idx(vnidx){};
 };
-// for std::map
-static inline bool operator<(const vertex_index &a, const vertex_index &b) {
-  if (a.v_idx != b.v_idx)
-    return (a.v_idx < b.v_idx);
-  if (a.vn_idx != b.vn_idx)
-    return (a.vn_idx < b.vn_idx);
-  if (a.vt_idx != b.vt_idx)
-    return (a.vt_idx < b.vt_idx);
-
-  return false;
-}
-
 struct obj_shape {
   std::vector<float> v;
   std::vector<float> vn;
@@ -295,18 +290,104 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
   return vi;
 }
 
-static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
-             std::vector<float> &positions, std::vector<float> &normals,
-             std::vector<float> &texcoords,
-             const std::vector<float> &in_positions,
-             const std::vector<float> &in_normals,
-             const std::vector<float> &in_texcoords, const vertex_index &i) {
-  const std::map<vertex_index, unsigned int>::iterator it = vertexCache.find(i);
+// Open addressing hash from vertex_index to the welded vertex, replaces
+// std::map in the face group export. Linear probing over a power of two table
+// kept at most half full, sized up front for a corner shared by four faces.
+class vertex_weld {
+public:
+  explicit vertex_weld(size_t corners) {
+    size_t capacity = 16;
+    while (capacity < corners / 2)
+      capacity <<= 1;
+    slots.resize(capacity);
+    mask = capacity - 1;
+  }
+
+  // Returns the slot of the key, 'inserted' tells whether it was empty.
+  // The reference is valid until the next call.
+  unsigned int &find(const vertex_index &key, bool &inserted) {
+    if (2 * (count + 1) > slots.size())
+      grow();
+    size_t h = hash(key) & mask;
+    for (;;) {
+      slot &s = slots[h];
+      if (s.value == EMPTY) {
+        s.key = key;
+        count++;
+        inserted = true;
+        return s.value;
+      }
+      if (s.key.v_idx == key.v_idx && s.key.vt_idx == key.vt_idx &&
+          s.key.vn_idx == key.vn_idx) {
+        inserted = false;
+        return s.value;
+      }
+      h = (h + 1) & mask;
+    }
+  }
 
-  if (it != vertexCache.end()) {
+private:
+  static const unsigned int EMPTY = ~0u;
+
+  struct slot {
+    vertex_index key;
+    unsigned int value = EMPTY;
+  };
+
+  void grow() {
+    std::vector<slot> old(slots.size() * 2);
+    old.swap(slots);
+    mask = slots.size() - 1;
+    for (const slot &s : old) {
+      if (s.value == EMPTY)
+        continue;
+      size_t h = hash(s.key) & mask;
+      while (slots[h].value != EMPTY)
+        h = (h + 1) & mask;
+      slots[h] = s;
+    }
+  }
+
+  // Faces reference nearby positions, keeping consecutive positions in
+  // neighbouring slots turns most probes into cache hits
+  static size_t hash(const vertex_index &i) {
+    unsigned int attributes =
+        (unsigned int)i.vt_idx * 0x9E3779B1u ^ (unsigned int)i.vn_idx * 0x85EBCA77u;
+    return ((size_t)(unsigned int)i.v_idx << 2) + (attributes >> 30);
+  }
+
+  std::vector<slot> slots;
+  size_t mask;
+  size_t count = 0;
+};
+
+// Faces of one group stored flat, corners of all faces followed by the
+// number of corners of each face.
+struct face_group {
+  std::vector<vertex_index> corners;
+  std::vector<unsigned int> sizes;
+
+  bool empty() const { return sizes.empty(); }
+  void clear() {
+    corners.clear();
+    sizes.clear();
+  }
+};
+
+static unsigned int updateVertex(vertex_weld &vertexCache,
+                                 std::vector<float> &positions,
+                                 std::vector<float> &normals,
+                                 std::vector<float> &texcoords,
+                                 const std::vector<float> &in_positions,
+                                 const std::vector<float> &in_normals,
+                                 const std::vector<float> &in_texcoords,
+                                 const vertex_index &i) {
+  bool inserted;
+  unsigned int &cached = vertexCache.find(i, inserted);
+
+  if (!inserted) {
     // found cache
-    return it->second;
+    return cached;
   }
 
   assert(in_positions.size() > (unsigned int)(3 * i.v_idx + 2));
@@ -326,10 +407,9 @@ updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
     texcoords.push_back(in_texcoords[2 * i.vt_idx + 1]);
   }
 
-  unsigned int idx = static_cast<unsigned int>(positions.size() / 3 - 1);
-  vertexCache[i] = idx;
+  cached = static_cast<unsigned int>(positions.size() / 3 - 1);
 
-  return idx;
+  return cached;
 }
 
 void InitMaterial(material_t &material) {
@@ -355,27 +435,31 @@ void InitMaterial(material_t &material) {
   material.unknown_parameter.clear();
 }
 
-static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
-    const std::vector<float> &in_positions,
-    const std::vector<float> &in_normals,
-    const std::vector<float> &in_texcoords,
-    const std::vector<std::vector<vertex_index>> &faceGroup,
-    const int material_id, const std::string &name, bool clearCache) {
+static bool exportFaceGroupToShape(shape_t &shape,
+                                   const std::vector<float> &in_positions,
+                                   const std::vector<float> &in_normals,
+                                   const std::vector<float> &in_texcoords,
+                                   const face_group &faceGroup,
+                                   const int material_id,
+                                   const std::string &name) {
   if (faceGroup.empty()) {
     return false;
   }
 
+  // Every group welds its own vertices
+  vertex_weld vertexCache(faceGroup.corners.size());
+
   // Flatten vertices and indices
-  for (size_t i = 0; i < faceGroup.size(); i++) {
-    const std::vector<vertex_index> &face = faceGroup[i];
+  const vertex_index *face = faceGroup.corners.data();
+  for (size_t i = 0; i < faceGroup.sizes.size(); face += faceGroup.sizes[i++]) {
+    size_t npolys = faceGroup.sizes[i];
+    if (npolys < 3)
+      continue;
 
     vertex_index i0 = face[0];
     vertex_index i1(-1);
     vertex_index i2 = face[1];
 
-    size_t npolys = face.size();
-
     // Polygon -> face fan conversion
     for (size_t k = 2; k < npolys; k++) {
       i1 = i2;
@@ -401,9 +485,6 @@ static bool exportFaceGroupToShape(
 
   shape.name = name;
 
-  if (clearCache)
-    vertexCache.clear();
-
   return true;
 }
 
@@ -692,12 +773,11 @@ std::string LoadObj(std::vector<shape_t> &shapes,
   std::vector<float> v;
   std::vector<float> vn;
   std::vector<float> vt;
-  std::vector<std::vector<vertex_index>> faceGroup;
+  face_group faceGroup;
   std::string name;
 
   // material
   std::map<std::string, int> material_map;
-  std::map<vertex_index, unsigned int> vertexCache;
   int material = -1;
 
   shape_t shape;
@@ -772,17 +852,18 @@ std::string LoadObj(std::vector<shape_t> &shapes,
       token += 2;
       token += strspn(token, " \t");
 
-      std::vector<vertex_index> face;
+      unsigned int corners = 0;
       while (!isNewLine(token[0])) {
         vertex_index vi = parseTriple(token, static_cast<int>(v.size() / 3),
                                       static_cast<int>(vn.size() / 3),
                                       static_cast<int>(vt.size() / 2));
-        face.push_back(vi);
+        faceGroup.corners.push_back(vi);
+        corners++;
         size_t n = strspn(token, " \t\r");
         token += n;
       }
 
-      faceGroup.push_back(face);
+      faceGroup.sizes.push_back(corners);
 
       continue;
     }
@@ -799,8 +880,8 @@ std::string LoadObj(std::vector<shape_t> &shapes,
 #endif
 
       // Create face group per material.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
+      bool ret = exportFaceGroupToShape(shape, v, vn, vt, faceGroup,
+                                        material, name);
       if (ret) {
         shapes.push_back(shape);
       }
@@ -840,8 +921,8 @@ std::string LoadObj(std::vector<shape_t> &shapes,
     if (token[0] == 'g' && isSpace((token[1]))) {
 
       // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
+      bool ret = exportFaceGroupToShape(shape, v, vn, vt, faceGroup,
+                                        material, name);
       if (ret) {
         shapes.push_back(shape);
       }
@@ -874,8 +955,8 @@ std::string LoadObj(std::vector<shape_t> &shapes,
     if (token[0] == 'o' && isSpace((token[1]))) {
 
       // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
+      bool ret = exportFaceGroupToShape(shape, v, vn, vt, faceGroup,
+                                        material, name);
       if (ret) {
         shapes.push_back(shape);
       }
@@ -900,8 +981,8 @@ std::string LoadObj(std::vector<shape_t> &shapes,
     // Ignore unknown command.
   }
 
-  bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                    material, name, true);
+  bool ret =
+      exportFaceGroupToShape(shape, v, vn, vt, faceGroup, material, name);
   if (ret) {
     shapes.push_back(shape);
   }
@@ -909,4 +990,283 @@ std::string LoadObj(std::vector<shape_t> &shapes,
 
   return err.str();
 }
+
+// Bytes per chunk of the parallel parser, small files stay a single chunk
+#define TINYOBJ_PARALLEL_CHUNK_SIZE (1 << 20)
+
+// Statement whose effect depends on the faces before it: usemtl, mtllib, g, o
+struct obj_statement {
+  char type; // 'u', 'm', 'g' or 'o'
+  size_t face; // Number of faces of the chunk preceding the statement
+  std::string name;
+};
+
+// Result of parsing one chunk of lines on its own. Relative face indices
+// refer to the vertex counts of the chunk and are listed for the merge.
+struct obj_chunk {
+  std::vector<float> v;
+  std::vector<float> vn;
+  std::vector<float> vt;
+  face_group faces;
+  std::vector<size_t> relative; // corner * 3 + 0 (v), 1 (vt) or 2 (vn)
+  std::vector<obj_statement> statements;
+};
+
+static inline const char *skipSpace(const char *token, const char *end) {
+  while (token < end && isSpace(*token))
+    token++;
+  return token;
+}
+
+// Bounded variants of the parsers above, mapped lines are not terminated
+static inline float parseFloat(const char *&token, const char *end) {
+  token = skipSpace(token, end);
+  const char *e = token;
+  while (e < end && !isSpace(*e) && *e != '\r')
+    e++;
+  double val = 0.0;
+  tryParseDouble(token, e, &val);
+  token = e;
+  return static_cast<float>(val);
+}
+
+static inline int parseIndex(const char *&token, const char *end) {
+  bool negative = false;
+  if (token < end && (*token == '-' || *token == '+'))
+    negative = *token++ == '-';
+  int value = 0;
+  while (token < end && *token >= '0' && *token <= '9')
+    value = value * 10 + (*token++ - '0');
+  // Skip anything else up to the next separator like strcspn does above
+  while (token < end && *token != '/' && !isSpace(*token) && *token != '\r')
+    token++;
+  return negative ? -value : value;
+}
+
+static inline std::string parseWord(const char *token, const char *end) {
+  token = skipSpace(token, end);
+  const char *e = token;
+  while (e < end && !isSpace(*e) && *e != '\r')
+    e++;
+  return std::string(token, e);
+}
+
+static void parseChunk(const char *begin, const char *end, obj_chunk &chunk) {
+  // Make index zero-base, relative ones are resolved against the chunk counts
+  auto fix = [&chunk](int idx, int n, size_t component) {
+    if (idx > 0)
+      return idx - 1;
+    if (idx == 0)
+      return 0;
+    chunk.relative.push_back(chunk.faces.corners.size() * 3 + component);
+    return n + idx;
+  };
+
+  for (const char *line = begin; line < end;) {
+    const char *lineEnd =
+        static_cast<const char *>(memchr(line, '\n', (size_t)(end - line)));
+    if (!lineEnd)
+      lineEnd = end;
+    const char *token = skipSpace(line, lineEnd);
+    line = lineEnd + 1;
+
+    if (lineEnd - token < 2 || token[0] == '#')
+      continue;
+
+    // vertex
+    if (token[0] == 'v' && isSpace(token[1])) {
+      token += 2;
+      chunk.v.push_back(parseFloat(token, lineEnd));
+      chunk.v.push_back(parseFloat(token, lineEnd));
+      chunk.v.push_back(parseFloat(token, lineEnd));
+      continue;
+    }
+
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && lineEnd - token > 2 &&
+        isSpace(token[2])) {
+      token += 3;
+      chunk.vn.push_back(parseFloat(token, lineEnd));
+      chunk.vn.push_back(parseFloat(token, lineEnd));
+      chunk.vn.push_back(parseFloat(token, lineEnd));
+      continue;
+    }
+
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && lineEnd - token > 2 &&
+        isSpace(token[2])) {
+      token += 3;
+      chunk.vt.push_back(parseFloat(token, lineEnd));
+      chunk.vt.push_back(parseFloat(token, lineEnd));
+      continue;
+    }
+
+    // face, triples i, i/j/k, i//k, i/j
+    if (token[0] == 'f' && isSpace(token[1])) {
+      token = skipSpace(token + 2, lineEnd);
+      int vsize = static_cast<int>(chunk.v.size() / 3);
+      int vnsize = static_cast<int>(chunk.vn.size() / 3);
+      int vtsize = static_cast<int>(chunk.vt.size() / 2);
+
+      unsigned int corners = 0;
+      while (token < lineEnd && *token != '\r') {
+        vertex_index vi(-1);
+        vi.v_idx = fix(parseIndex(token, lineEnd), vsize, 0);
+        if (token < lineEnd && *token == '/') {
+          token++;
+          if (token < lineEnd && *token != '/')
+            vi.vt_idx = fix(parseIndex(token, lineEnd), vtsize, 1);
+          if (token < lineEnd && *token == '/') {
+            token++;
+            vi.vn_idx = fix(parseIndex(token, lineEnd), vnsize, 2);
+          }
+        }
+        chunk.faces.corners.push_back(vi);
+        corners++;
+        token = skipSpace(token, lineEnd);
+      }
+      chunk.faces.sizes.push_back(corners);
+      continue;
+    }
+
+    obj_statement statement;
+    statement.face = chunk.faces.sizes.size();
+    if (lineEnd - token > 6 && isSpace(token[6]) &&
+        (0 == strncmp(token, "usemtl", 6) || 0 == strncmp(token, "mtllib", 6))) {
+      statement.type = token[0] == 'u' ? 'u' : 'm';
+      statement.name = parseWord(token + 7, lineEnd);
+    } else if ((token[0] == 'g' || token[0] == 'o') && isSpace(token[1])) {
+      statement.type = token[0];
+      statement.name = parseWord(token + 2, lineEnd);
+    } else {
+      // Ignore unknown command.
+      continue;
+    }
+    chunk.statements.push_back(statement);
+  }
+}
+
+std::string LoadObjParallel(std::vector<shape_t> &shapes,
+                            std::vector<material_t> &materials, // [output]
+                            const char *filename, const char *mtl_basepath) {
+  shapes.clear();
+
+  std::stringstream err;
+
+  std::unique_ptr<ppgso::MappedFile> file;
+  try {
+    file.reset(new ppgso::MappedFile(filename));
+  } catch (std::exception &) {
+    err << "Cannot open file [" << filename << "]" << std::endl;
+    return err.str();
+  }
+  const char *data = reinterpret_cast<const char *>(file->data());
+  const char *end = data + file->size();
+
+  // Split on line breaks, every chunk holds whole lines
+  std::vector<const char *> bounds(1, data);
+  while (bounds.back() < end) {
+    const char *split =
+        bounds.back() +
+        std::min<size_t>(TINYOBJ_PARALLEL_CHUNK_SIZE, (size_t)(end - bounds.back()));
+    const char *newline =
+        static_cast<const char *>(memchr(split, '\n', (size_t)(end - split)));
+    bounds.push_back(newline ? newline + 1 : end);
+  }
+
+  std::vector<obj_chunk> chunks(bounds.size() - 1);
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < (int)chunks.size(); i++)
+    parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+
+  // Concatenate vertex data in file order and resolve relative indices
+  size_t vCount = 0, vnCount = 0, vtCount = 0;
+  for (auto &chunk : chunks) {
+    vCount += chunk.v.size();
+    vnCount += chunk.vn.size();
+    vtCount += chunk.vt.size();
+  }
+  std::vector<float> v, vn, vt;
+  v.reserve(vCount);
+  vn.reserve(vnCount);
+  vt.reserve(vtCount);
+  for (auto &chunk : chunks) {
+    int base[3] = {static_cast<int>(v.size() / 3),
+                   static_cast<int>(vt.size() / 2),
+                   static_cast<int>(vn.size() / 3)};
+    for (size_t r : chunk.relative) {
+      vertex_index &vi = chunk.faces.corners[r / 3];
+      int *idx[3] = {&vi.v_idx, &vi.vt_idx, &vi.vn_idx};
+      *idx[r % 3] += base[r % 3];
+    }
+    v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+    vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+    vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+    std::vector<float>().swap(chunk.v);
+    std::vector<float>().swap(chunk.vn);
+    std::vector<float>().swap(chunk.vt);
+  }
+
+  std::string basePath;
+  if (mtl_basepath) {
+    basePath = mtl_basepath;
+  }
+  MaterialFileReader matFileReader(basePath);
+
+  // Replay faces and statements in file order, as LoadObj does line by line
+  std::map<std::string, int> material_map;
+  int material = -1;
+  std::string name;
+  shape_t shape;
+  face_group faceGroup;
+
+  auto flush = [&]() {
+    if (exportFaceGroupToShape(shape, v, vn, vt, faceGroup, material, name))
+      shapes.push_back(std::move(shape));
+    shape = shape_t();
+    faceGroup.clear();
+  };
+
+  for (auto &chunk : chunks) {
+    size_t face = 0, corner = 0;
+    auto append = [&](size_t until) {
+      size_t corners = corner;
+      for (size_t i = face; i < until; i++)
+        corners += chunk.faces.sizes[i];
+      faceGroup.corners.insert(faceGroup.corners.end(),
+                               chunk.faces.corners.begin() + corner,
+                               chunk.faces.corners.begin() + corners);
+      faceGroup.sizes.insert(faceGroup.sizes.end(),
+                             chunk.faces.sizes.begin() + face,
+                             chunk.faces.sizes.begin() + until);
+      face = until;
+      corner = corners;
+    };
+
+    for (auto &statement : chunk.statements) {
+      append(statement.face);
+      if (statement.type == 'm') {
+        std::string err_mtl =
+            matFileReader(statement.name, materials, material_map);
+        if (!err_mtl.empty()) {
+          return err_mtl;
+        }
+        continue;
+      }
+
+      // Create face group per material, group and object.
+      flush();
+      if (statement.type == 'u') {
+        auto it = material_map.find(statement.name);
+        material = it != material_map.end() ? it->second : -1;
+      } else {
+        name = statement.name;
+      }
+    }
+    append(chunk.faces.sizes.size());
+  }
+  flush();
+
+  return err.str();
+}
 }
@@ -81,6 +81,15 @@ std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
                     std::vector<material_t> &materials, // [output]
                     const char *filename, const char *mtl_basepath = nullptr);
 
+/// Loads .obj from a file like LoadObj, with the same output.
+/// The file is memory mapped and split into chunks on line breaks,
+/// the chunks are parsed in parallel when OpenMP is available.
+/// Returns empty string when loading .obj success.
+std::string LoadObjParallel(std::vector<shape_t> &shapes,       // [output]
+                            std::vector<material_t> &materials, // [output]
+                            const char *filename,
+                            const char *mtl_basepath = nullptr);
+
 /// Loads object from a std::istream, uses GetMtlIStreamFn to retrieve
 /// std::istream for materials.
 /// Returns empty string when loading .obj success.
@@ -18,11 +18,7 @@ ppgso::Window::Window(std::string title, int width, int height) : title{title},
   // Set up glfw
   glfwInstance::Init();
 
-  glfwSetErrorCallback(glfw_error_callback);
-
   glfwWindowHint(GLFW_SAMPLES, 4);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -30,7 +26,17 @@ ppgso::Window::Window(std::string title, int width, int height) : title{title},
   glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
 
-  window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+  // Compute shaders and indirect draws need 4.3, everything else runs on 3.3 (macOS stops at 4.1)
+  const int versions[][2] = {{4, 3}, {3, 3}};
+  window = nullptr;
+  for (size_t i = 0; i < 2 && !window; i++) {
+    // Only the last attempt reports errors, failing to get a newer context is expected
+    glfwSetErrorCallback(i == 1 ? glfw_error_callback : nullptr);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versions[i][0]);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versions[i][1]);
+    window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+  }
+  glfwSetErrorCallback(glfw_error_callback);
   if (!window)
     throw std::runtime_error("Failed to initialize GLFW Window!");
 
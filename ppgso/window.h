@@ -44,7 +44,8 @@ namespace ppgso {
     int width, height;
 
     /*!
-     * Open new Window and initialize OpenGL 3.3 context
+     * Open new Window and initialize OpenGL 4.3 core context, or 3.3 core where 4.3 is not available
+     * Code needing 4.3 features checks GLEW_VERSION_4_3 or the matching extension.
      * @param title Window title to show in the title bar
      * @param width Horizontal size of the window
      * @param height Vertical size of the window
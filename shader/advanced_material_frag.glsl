@@ -1,5 +1,10 @@
 #version 330 core
 
+// Variants, defined by ppgso::Shader from its feature flags
+//   LIGHTING    - directional light with an ambient term, plain base color otherwise
+//   NORMAL_MAP  - lighting uses NormalMapTexture instead of the interpolated normal
+//   POINT_LIGHT - adds the point light with metallic specular, needs LightPosition, LightColor and CameraPosition
+
 in vec2 FragTexCoord;
 in vec3 FragNormal;
 in vec3 FragPosition;
@@ -7,41 +12,55 @@ in vec3 FragPosition;
 // Base color texture
 uniform sampler2D BaseColorTexture;
 
-// Metallic and roughness texture
-uniform sampler2D MetallicRoughnessTexture;
-
+#ifdef LIGHTING
+#ifdef NORMAL_MAP
 // Normal map texture
 uniform sampler2D NormalMapTexture;
+#endif
 
 // Directional light properties
 uniform vec3 LightDirection;
 
+#ifdef POINT_LIGHT
+// Metallic and roughness texture
+uniform sampler2D MetallicRoughnessTexture;
+
 // Point light (lamp) properties
 uniform vec3 LightPosition; // Position of the lamp
 uniform vec3 LightColor;    // Color/intensity of the lamp light
 
 // Camera position (for specular reflection)
 uniform vec3 CameraPosition;
+#endif
+#endif
 
 // Final output color
 out vec4 FragColor;
 
 void main() {
     // 1. Sample base color
-    vec3 baseColor = texture(BaseColorTexture, FragTexCoord).rgb;
+    vec4 baseColor = texture(BaseColorTexture, FragTexCoord);
 
-    // 2. Sample metallic and roughness values
-    vec2 metallicRoughness = texture(MetallicRoughnessTexture, FragTexCoord).rg;
-    float metallic = metallicRoughness.r;
-    float roughness = clamp(metallicRoughness.g, 0.05, 1.0); // Avoid extreme smoothness for stability
-
-    // 3. Sample and normalize normal map
+#ifdef LIGHTING
+    // 2. Sample and normalize normal map
+#ifdef NORMAL_MAP
     vec3 normalMap = texture(NormalMapTexture, FragTexCoord).rgb;
     vec3 normal = normalize(normalMap * 2.0 - 1.0); // Transform [0,1] range to [-1,1]
+#else
+    vec3 normal = normalize(FragNormal);
+#endif
 
-    // 4. Compute lighting for directional light
+    // 3. Compute lighting for directional light
     vec3 lightDirDir = normalize(-LightDirection); // Ensure normalized light direction
     float lightIntensityDir = max(dot(normal, lightDirDir), 0.0);
+    vec3 ambient = baseColor.rgb * 0.1; // Add a simple ambient term
+    vec3 finalColor = ambient + baseColor.rgb * lightIntensityDir;
+
+#ifdef POINT_LIGHT
+    // 4. Sample metallic and roughness values
+    vec2 metallicRoughness = texture(MetallicRoughnessTexture, FragTexCoord).rg;
+    float metallic = metallicRoughness.r;
+    float roughness = clamp(metallicRoughness.g, 0.05, 1.0); // Avoid extreme smoothness for stability
 
     // 5. Compute lighting for point light
     vec3 lightDirPoint = normalize(LightPosition - FragPosition);
@@ -54,17 +73,13 @@ void main() {
     vec3 halfwayDir = normalize(lightDirPoint + viewDir);
     float specular = pow(max(dot(normal, halfwayDir), 0.0), 32.0 * (1.0 - roughness)) * attenuation;
 
-    // 7. Combine lighting contributions
-    vec3 diffuse = baseColor * (lightIntensityDir + lightIntensityPoint * LightColor);
-    vec3 ambient = baseColor * 0.1; // Add a simple ambient term
-    vec3 finalColor = ambient + diffuse + specular * metallic;
-
-
-    // Post-Processing shaders
-    vec4 color = texture(BaseColorTexture, FragTexCoord);
-    float grayscale = 0.299 * color.r + 0.587 * color.g + 0.114 * color.b;
-    FragColor = vec4(vec3(grayscale), color.a);
+    finalColor += baseColor.rgb * lightIntensityPoint * LightColor + specular * metallic;
+#endif
 
-    // 8. Output the final color
-    // FragColor = vec4(finalColor, 1.0);
+    // 7. Output the final color
+    FragColor = vec4(finalColor, 1.0);
+#else
+    // Post-processing such as grayscale runs once per screen pixel in the PostChain of gl9_scene
+    FragColor = baseColor;
+#endif
 }
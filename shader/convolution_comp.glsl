@@ -0,0 +1,43 @@
+#version 430
+// RADIUS and KERNEL are defined by ppgso::Convolution before compilation
+// Each work group loads its tile and the surrounding halo to shared memory once,
+// all (2 * RADIUS + 1)^2 taps are then read from there instead of from the texture
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// Input image, same size as the output
+uniform sampler2D Source;
+
+// Output image
+layout(rgba8, binding = 0) uniform writeonly image2D Target;
+
+// Result is divided by the factor and the bias is added
+uniform float Factor;
+uniform float Bias;
+
+const int SIZE = 2 * RADIUS + 1;
+const int TILE = 16 + 2 * RADIUS;
+const float kernel[SIZE * SIZE] = float[] (KERNEL);
+
+shared vec4 tile[TILE * TILE];
+
+void main() {
+  // Cooperative load of the tile, pixels outside the image are clamped to the edge
+  ivec2 size = textureSize(Source, 0);
+  ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16 - RADIUS;
+  for (int i = int(gl_LocalInvocationIndex); i < TILE * TILE; i += 256) {
+    ivec2 position = clamp(origin + ivec2(i % TILE, i / TILE), ivec2(0), size - 1);
+    tile[i] = texelFetch(Source, position, 0);
+  }
+  barrier();
+
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(pixel, size))) return;
+
+  ivec2 local = ivec2(gl_LocalInvocationID.xy);
+  vec4 color = vec4(0);
+  for (int y = 0; y < SIZE; y++)
+    for (int x = 0; x < SIZE; x++)
+      color += tile[(local.y + y) * TILE + local.x + x] * kernel[y * SIZE + x];
+  imageStore(Target, pixel, vec4(color.rgb / Factor + vec3(Bias), 1.0));
+}
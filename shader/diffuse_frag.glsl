@@ -1,13 +1,28 @@
 #version 330
 
+// Variants, defined by ppgso::Shader from its feature flags
+//   POINT_LIGHT - point light diffuse and specular terms, needs LightPosition, LightColor and CameraPosition
+//   TRANSPARENT - alpha of the texture scaled by Transparency, fully opaque otherwise
+//   FOG         - exponential fog towards FogColor, needs CameraPosition
+
 // Uniforms
 uniform sampler2D Texture;
 uniform vec3 LightDirection;
+uniform vec2 TextureOffset;
+#ifdef POINT_LIGHT
 uniform vec3 LightPosition; // Point light position
 uniform vec3 LightColor;    // Point light color
-uniform vec3 CameraPosition; // Camera position for specular calculations
+#endif
+#if defined(POINT_LIGHT) || defined(FOG)
+uniform vec3 CameraPosition; // Camera position for specular calculations and fog
+#endif
+#ifdef TRANSPARENT
 uniform float Transparency;
-uniform vec2 TextureOffset;
+#endif
+#ifdef FOG
+uniform vec3 FogColor;
+uniform float FogDensity;  // Inverse of the distance at which the fog reaches 63%
+#endif
 
 // Inputs from vertex shader
 in vec2 texCoord;
@@ -24,6 +39,11 @@ void main() {
   // Compute diffuse lighting for directional light
   float diffuseDir = max(dot(norm, -normalize(LightDirection)), 0.0);
 
+  // Sample the texture color
+  vec4 textureColor = texture(Texture, vec2(texCoord.x, 1.0 - texCoord.y) + TextureOffset);
+  vec3 lighting = textureColor.rgb * diffuseDir;
+
+#ifdef POINT_LIGHT
   // Compute point light contribution
   vec3 lightDir = normalize(LightPosition - FragPosition);
   float distance = length(LightPosition - FragPosition);
@@ -35,12 +55,17 @@ void main() {
   vec3 halfwayDir = normalize(lightDir + viewDir);
   float specular = pow(max(dot(norm, halfwayDir), 0.0), 32.0) * attenuation;
 
-  // Sample the texture color
-  vec4 textureColor = texture(Texture, vec2(texCoord.x, 1.0 - texCoord.y) + TextureOffset);
+  lighting += textureColor.rgb * diffusePoint * LightColor + vec3(specular);
+#endif
 
-  // Combine lighting contributions
-  vec3 lighting = textureColor.rgb * (diffuseDir + diffusePoint * LightColor) + vec3(specular);
+#ifdef FOG
+  lighting = mix(FogColor, lighting, exp(-FogDensity * length(CameraPosition - FragPosition)));
+#endif
 
   // Output the final color
+#ifdef TRANSPARENT
   FragmentColor = vec4(lighting, textureColor.a * Transparency);
+#else
+  FragmentColor = vec4(lighting, 1.0);
+#endif
 }
@@ -0,0 +1,41 @@
+#version 430
+// diffuse_vert.glsl for ppgso::InstanceCuller draws, the model matrix comes from the visible instances
+
+// Vertex attributes
+layout(location = 0) in vec3 Position;
+layout(location = 1) in vec2 TexCoord;
+layout(location = 2) in vec3 Normal;
+
+// Model matrices of visible instances written by instance_cull_comp.glsl
+layout(std430, binding = 1) readonly buffer Visible {
+  mat4 visible[];
+};
+
+// First instance of the level being drawn
+uniform int InstanceBase;
+
+// Matrices for transformations
+uniform mat4 ProjectionMatrix;
+uniform mat4 ViewMatrix;
+
+// Output to fragment shader
+out vec2 texCoord;        // Texture coordinates
+out vec3 FragPosition;    // World-space fragment position
+out vec3 FragNormal;      // World-space normal
+
+void main() {
+  mat4 ModelMatrix = visible[InstanceBase + gl_InstanceID];
+
+  // Pass texture coordinates directly
+  texCoord = TexCoord;
+
+  // Calculate world-space position of the fragment
+  vec4 worldPosition = ModelMatrix * vec4(Position, 1.0);
+  FragPosition = worldPosition.xyz;
+
+  // Calculate world-space normal
+  FragNormal = mat3(transpose(inverse(ModelMatrix))) * Normal;
+
+  // Final vertex position in clip space
+  gl_Position = ProjectionMatrix * ViewMatrix * worldPosition;
+}
@@ -0,0 +1,40 @@
+#version 430
+// First pass of the counting sort of GpuFlock
+// Counts the fish of every grid cell and remembers the rank of each fish within its cell
+
+layout(local_size_x = 64) in;
+
+struct Fish {
+  vec4 position; // w is the size of the fish
+  vec4 velocity;
+};
+
+// Fish in the order they were added in
+layout(std430, binding = 0) readonly buffer State {
+  Fish fish[];
+};
+
+// Fish per cell, cleared before the dispatch
+layout(std430, binding = 2) buffer CellBuffer {
+  uint cells[];
+};
+
+// Cell and rank of every fish
+layout(std430, binding = 3) writeonly buffer Slots {
+  uvec2 slots[];
+};
+
+uniform uint Count;
+uniform vec3 Minimum;
+uniform ivec3 Grid;
+uniform float InverseCell;
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= Count) return;
+
+  // Fish on the boundary belong to the outer cells, like in Flock::sort
+  ivec3 c = clamp(ivec3((fish[index].position.xyz - Minimum) * InverseCell), ivec3(0), Grid - 1);
+  uint cell = uint((c.z * Grid.y + c.y) * Grid.x + c.x);
+  slots[index] = uvec2(cell, atomicAdd(cells[cell], 1u));
+}
@@ -0,0 +1,44 @@
+#version 430
+// Second pass of the counting sort of GpuFlock, a single work group
+// Turns the fish count of every cell into the index of its first fish, the entry after the last cell gets the total
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 2) buffer CellBuffer {
+  uint cells[];
+};
+
+uniform uint CellCount;
+
+shared uint sums[256];
+
+void main() {
+  // Every invocation sums a contiguous chunk of cells
+  uint thread = gl_LocalInvocationID.x;
+  uint chunk = (CellCount + 255u) / 256u;
+  uint begin = min(thread * chunk, CellCount);
+  uint end = min(begin + chunk, CellCount);
+  uint sum = 0u;
+  for (uint cell = begin; cell < end; cell++) sum += cells[cell];
+  sums[thread] = sum;
+  memoryBarrierShared();
+  barrier();
+
+  // Inclusive scan of the chunk sums (Hillis and Steele)
+  for (uint offset = 1u; offset < 256u; offset <<= 1u) {
+    uint add = thread >= offset ? sums[thread - offset] : 0u;
+    memoryBarrierShared();
+    barrier();
+    sums[thread] += add;
+    memoryBarrierShared();
+    barrier();
+  }
+
+  uint start = sums[thread] - sum;
+  for (uint cell = begin; cell < end; cell++) {
+    uint count = cells[cell];
+    cells[cell] = start;
+    start += count;
+  }
+  if (thread == 255u) cells[CellCount] = sums[255];
+}
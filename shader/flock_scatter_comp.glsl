@@ -0,0 +1,40 @@
+#version 430
+// Last pass of the counting sort of GpuFlock
+// Copies every fish to its slot in grid order, so the fish of a grid row are one contiguous run
+
+layout(local_size_x = 64) in;
+
+struct Fish {
+  vec4 position;
+  vec4 velocity;
+};
+
+layout(std430, binding = 0) readonly buffer State {
+  Fish fish[];
+};
+
+// Fish in grid order, velocity.w holds the index of the fish in State
+layout(std430, binding = 1) writeonly buffer Sorted {
+  Fish sorted[];
+};
+
+// Index of the first fish of every cell
+layout(std430, binding = 2) readonly buffer CellBuffer {
+  uint cells[];
+};
+
+layout(std430, binding = 3) readonly buffer Slots {
+  uvec2 slots[];
+};
+
+uniform uint Count;
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= Count) return;
+
+  uvec2 slot = slots[index];
+  Fish copy = fish[index];
+  copy.velocity.w = uintBitsToFloat(index);
+  sorted[cells[slot.x] + slot.y] = copy;
+}
@@ -0,0 +1,132 @@
+#version 430
+// Boids step of GpuFlock, the same rules as Flock::step
+// One invocation per fish in grid order, writes the new state and the model matrix of the fish
+
+layout(local_size_x = 64) in;
+
+struct Fish {
+  vec4 position;
+  vec4 velocity;
+};
+
+// New state of every fish, in the order they were added in
+layout(std430, binding = 0) writeonly buffer State {
+  Fish fish[];
+};
+
+// State of the previous step in grid order
+layout(std430, binding = 1) readonly buffer Sorted {
+  Fish sorted[];
+};
+
+layout(std430, binding = 2) readonly buffer CellBuffer {
+  uint cells[];
+};
+
+// Model matrices the instanced renderer draws, see ppgso::InstanceCuller
+layout(std430, binding = 4) writeonly buffer Instances {
+  mat4 instances[];
+};
+
+// Neighbours seen by all fish, cleared before the dispatch
+layout(std430, binding = 5) buffer Statistics {
+  uint neighbours;
+};
+
+const int MAX_PREDATORS = 16;
+
+uniform uint Count;
+uniform vec3 Minimum;
+uniform vec3 Maximum;
+uniform ivec3 Grid;
+uniform float InverseCell;
+uniform float TimeStep;
+
+uniform float Perception;
+uniform float Separation;
+uniform float SeparationWeight;
+uniform float AlignmentWeight;
+uniform float CohesionWeight;
+uniform float PredatorRadius;
+uniform float PredatorWeight;
+uniform float WallMargin;
+uniform float WallWeight;
+uniform float MinSpeed;
+uniform float MaxSpeed;
+uniform float MaxForce;
+
+uniform vec3 Predators[MAX_PREDATORS];
+uniform int PredatorCount;
+
+// Inverse of the mesh axes, see Flock::meshRotation
+uniform mat3 MeshRotation;
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= Count) return;
+
+  vec3 position = sorted[index].position.xyz;
+  vec3 velocity = sorted[index].velocity.xyz;
+  ivec3 c = clamp(ivec3((position - Minimum) * InverseCell), ivec3(0), Grid - 1);
+  int x0 = max(c.x - 1, 0), x1 = min(c.x + 1, Grid.x - 1);
+
+  float perception2 = Perception * Perception, separation2 = Separation * Separation;
+  float seen = 0.0;
+  vec3 offset = vec3(0.0), heading = vec3(0.0), push = vec3(0.0);
+  for (int gz = max(c.z - 1, 0); gz <= min(c.z + 1, Grid.z - 1); gz++) {
+    for (int gy = max(c.y - 1, 0); gy <= min(c.y + 1, Grid.y - 1); gy++) {
+      // Three neighbouring cells of a row are one run of fish
+      int row = (gz * Grid.y + gy) * Grid.x;
+      uint end = cells[row + x1 + 1];
+      for (uint other = cells[row + x0]; other < end; other++) {
+        vec3 d = sorted[other].position.xyz - position;
+        float d2 = dot(d, d);
+        // The fish itself is at distance 0
+        float near = float(d2 < perception2 && d2 > 0.0);
+        seen += near;
+        offset += near * d;
+        heading += near * sorted[other].velocity.xyz;
+        push -= float(d2 < separation2 && d2 > 0.0) / max(d2, 1e-6) * d;
+      }
+    }
+  }
+  atomicAdd(neighbours, uint(seen));
+
+  vec3 steer = SeparationWeight * push;
+  if (seen > 0.0) {
+    steer += AlignmentWeight * (heading / seen - velocity);
+    steer += CohesionWeight * offset / seen;
+  }
+
+  for (int i = 0; i < PredatorCount; i++) {
+    vec3 away = position - Predators[i];
+    float d2 = dot(away, away);
+    if (d2 >= PredatorRadius * PredatorRadius || d2 <= 0.0) continue;
+    float distance = sqrt(d2);
+    steer += PredatorWeight * MaxSpeed * (1.0 - distance / PredatorRadius) * away / distance;
+  }
+
+  vec3 low = Minimum + WallMargin - position;
+  vec3 high = position - (Maximum - WallMargin);
+  steer += WallWeight * MaxSpeed * (max(low, 0.0) - max(high, 0.0)) / WallMargin;
+
+  float force = length(steer);
+  if (force > MaxForce) steer *= MaxForce / force;
+  velocity += steer * TimeStep;
+  float speed = length(velocity);
+  if (speed > MaxSpeed) velocity *= MaxSpeed / speed;
+  else if (speed < MinSpeed) velocity = speed > 1e-6 ? velocity * (MinSpeed / speed) : vec3(MinSpeed, 0.0, 0.0);
+  position = clamp(position + velocity * TimeStep, Minimum, Maximum);
+
+  uint id = floatBitsToUint(sorted[index].velocity.w);
+  float size = sorted[index].position.w;
+  fish[id] = Fish(vec4(position, size), vec4(velocity, 0.0));
+
+  // Velocity frame like Flock::writeModels
+  vec3 forward = normalize(velocity);
+  vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+  vec3 side = normalize(cross(up, forward));
+  up = cross(forward, side);
+  mat3 rotation = mat3(side, up, forward) * MeshRotation * size;
+  instances[id] = mat4(vec4(rotation[0], 0.0), vec4(rotation[1], 0.0), vec4(rotation[2], 0.0), vec4(position, 1.0));
+}
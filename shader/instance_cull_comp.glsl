@@ -0,0 +1,66 @@
+#version 430
+// Frustum culling and level of detail selection for ppgso::InstanceCuller
+// One invocation per instance, visible instances are appended to the region of their level
+// and counted in the indirect draw commands of every mesh part
+
+layout(local_size_x = 64) in;
+
+struct Command {
+  uint count;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+// Model matrices of all instances
+layout(std430, binding = 0) readonly buffer Instances {
+  mat4 instances[];
+};
+
+// Model matrices of visible instances, Capacity entries per level
+layout(std430, binding = 1) writeonly buffer Visible {
+  mat4 visible[];
+};
+
+// Levels commands per part, instance counts reset to 0 before the dispatch
+layout(std430, binding = 2) buffer Commands {
+  Command commands[];
+};
+
+uniform uint InstanceCount;
+uniform uint Capacity;
+uniform uint Parts;
+uniform uint Levels;
+
+// Normalized frustum planes, inside is positive
+uniform vec4 Planes[6];
+uniform mat4 ViewMatrix;
+// ProjectionMatrix[1][1], projects a radius at unit depth to half the screen height
+uniform float ProjectionScale;
+// Bounding radius of the mesh around its origin
+uniform float Radius;
+// Projected sizes below which the next coarser level is used
+uniform float Thresholds[3];
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= InstanceCount) return;
+
+  // Bounding sphere, scaled by the largest axis of the model matrix
+  mat4 model = instances[index];
+  vec3 center = model[3].xyz;
+  float scale = max(max(dot(model[0].xyz, model[0].xyz), dot(model[1].xyz, model[1].xyz)), dot(model[2].xyz, model[2].xyz));
+  float radius = Radius * sqrt(scale);
+  for (int i = 0; i < 6; i++)
+    if (dot(Planes[i].xyz, center) + Planes[i].w < -radius) return;
+
+  float depth = max(-(ViewMatrix * vec4(center, 1.0)).z, 0.001);
+  float projected = radius * ProjectionScale / depth;
+  uint level = 0u;
+  while (level + 1u < Levels && projected < Thresholds[level]) level++;
+
+  uint slot = atomicAdd(commands[level].instanceCount, 1u);
+  for (uint part = 1u; part < Parts; part++) atomicAdd(commands[part * Levels + level].instanceCount, 1u);
+  visible[level * Capacity + slot] = model;
+}
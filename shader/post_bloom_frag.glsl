@@ -0,0 +1,20 @@
+#version 330
+// Blurred bright parts of the scene
+uniform sampler2D Source;
+
+// Full resolution scene
+uniform sampler2D Scene;
+
+// Strength of the glow
+uniform float Intensity;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  vec4 color = texture(Scene, texCoord);
+  FragmentColor = vec4(color.rgb + texture(Source, texCoord).rgb * Intensity, color.a);
+}
@@ -0,0 +1,18 @@
+#version 330
+// Output of the previous pass
+uniform sampler2D Source;
+
+// Luminance above which pixels start to glow
+uniform float Threshold;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  vec3 color = texture(Source, texCoord).rgb;
+  float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+  FragmentColor = vec4(color * smoothstep(Threshold, 1.0, luminance), 1.0);
+}
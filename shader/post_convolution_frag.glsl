@@ -0,0 +1,30 @@
+#version 330
+// TAPS, OFFSETS and WEIGHTS are defined by ppgso::Convolution before compilation
+// Zero taps are left out, separable kernels are split into a horizontal and a vertical pass
+// and neighbouring taps are merged into single bilinear fetches between the two texels
+
+// Output of the previous pass
+uniform sampler2D Source;
+
+// Size of one Source texel in texture coordinates
+uniform vec2 TexelSize;
+
+// Result is divided by the factor and the bias is added
+uniform float Factor;
+uniform float Bias;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+const vec2 offsets[TAPS] = vec2[] (OFFSETS);
+const float weights[TAPS] = float[] (WEIGHTS);
+
+void main() {
+  vec4 color = vec4(0);
+  for (int i = 0; i < TAPS; i++)
+    color += texture(Source, texCoord + offsets[i] * TexelSize) * weights[i];
+  FragmentColor = vec4(color.rgb / Factor + vec3(Bias), 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330
+// Output of the previous pass
+uniform sampler2D Source;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  FragmentColor = texture(Source, texCoord);
+}
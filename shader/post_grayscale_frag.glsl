@@ -0,0 +1,18 @@
+#version 330
+// Output of the previous pass
+uniform sampler2D Source;
+
+// 0 keeps the colors, 1 is fully gray
+uniform float Strength;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  vec4 color = texture(Source, texCoord);
+  float grayscale = 0.299 * color.r + 0.587 * color.g + 0.114 * color.b;
+  FragmentColor = vec4(mix(color.rgb, vec3(grayscale), Strength), color.a);
+}
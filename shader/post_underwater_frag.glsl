@@ -0,0 +1,25 @@
+#version 330
+// Output of the previous pass
+uniform sampler2D Source;
+
+// Time in seconds, animates the ripples
+uniform float Time;
+
+// Color of the water, applied towards the bottom of the screen
+uniform vec3 Tint;
+
+// The vertex shader will feed this input
+in vec2 texCoord;
+
+// The final color
+out vec4 FragmentColor;
+
+void main() {
+  // Slight wobble of the image as seen through moving water
+  vec2 ripple = vec2(sin(texCoord.y * 30.0 + Time * 2.0), cos(texCoord.x * 25.0 + Time * 1.5)) * 0.002;
+  vec4 color = texture(Source, texCoord + ripple);
+
+  // Light is absorbed more the deeper we look
+  float depth = mix(0.35, 0.6, 1.0 - texCoord.y);
+  FragmentColor = vec4(mix(color.rgb, color.rgb * Tint, depth), color.a);
+}
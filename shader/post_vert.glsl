@@ -0,0 +1,12 @@
+#version 330
+// Fullscreen triangle generated from the vertex index, no vertex buffer is needed
+// Vertices (-1,-1), (3,-1), (-1,3) cover the whole screen, the overhang is clipped
+
+// This will be passed to the fragment shader
+out vec2 texCoord;
+
+void main() {
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  texCoord = position;
+  gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
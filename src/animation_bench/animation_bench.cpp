@@ -0,0 +1,143 @@
+// Benchmark animation_bench
+// - Samples one shared AnimationClip for many instances, each with its own time offset, for a number of frames
+// - Scan: linear search for the segment and a copy of the keys per instance, like the old Shark animation
+// - Search: AnimationClip::sample with a binary search of every sample
+// - Cached: AnimationClip::sample starting from the segment of the previous frame of each instance
+// - Batched: AnimationClip::sample of all instances at once, on all threads
+// - Prints the time per frame of each and checks that cached and batched poses match the binary search,
+//   and that scan rotations do (scan positions are linear, the clip's are Catmull-Rom)
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <ppgso/animation_clip.h>
+
+// Animated instances and keys of the clip they share
+const size_t INSTANCES = 10000;
+const int KEYS = 64;
+
+// Frames sampled at 60 Hz, the best of REPEAT runs is reported
+const int FRAMES = 300;
+const int REPEAT = 3;
+const float STEP = 1.0f / 60.0f;
+
+// Allowed position distance, and rotation difference as 1 - |cos| of half the angle between the quaternions
+const float POSITION_TOLERANCE = 1e-4f;
+const float ROTATION_TOLERANCE = 1e-6f;
+
+/*!
+ * Generate keys on a wobbly circle with unevenly spaced times
+ * @return Keys in time order, the last one matches the first
+ */
+std::vector<ppgso::AnimationClip::Key> circleKeys() {
+  std::mt19937 random{1};
+  std::uniform_real_distribution<float> spacing{0.1f, 0.4f};
+  std::vector<ppgso::AnimationClip::Key> keys;
+  float time = 0.0f;
+  for (int i = 0; i <= KEYS; i++) {
+    auto angle = 6.2831853f * (float) i / KEYS;
+    glm::vec3 position{10.0f * std::cos(angle), std::sin(3.0f * angle), 10.0f * std::sin(angle)};
+    keys.push_back({time, position, glm::angleAxis(-angle, glm::vec3{0.0f, 1.0f, 0.0f})});
+    time += spacing(random);
+  }
+  return keys;
+}
+
+/*!
+ * Sample keys with a linear scan, linear position and slerp rotation
+ * @param keys - Keys of the instance
+ * @param time - Time in seconds, wrapped around the duration
+ * @return Interpolated pose
+ */
+ppgso::AnimationClip::Pose scanSample(const std::vector<ppgso::AnimationClip::Key> &keys, float time) {
+  time = std::fmod(time, keys.back().time);
+  for (size_t i = 0; i + 1 < keys.size(); i++) {
+    if (time >= keys[i].time && time < keys[i + 1].time) {
+      auto t = (time - keys[i].time) / (keys[i + 1].time - keys[i].time);
+      return {glm::mix(keys[i].position, keys[i + 1].position, t), glm::slerp(keys[i].rotation, keys[i + 1].rotation, t)};
+    }
+  }
+  return {keys.back().position, keys.back().rotation};
+}
+
+/*!
+ * Compare two rotations, q and -q are the same rotation
+ * @param a - First rotation
+ * @param b - Second rotation
+ * @return 0 for equal rotations, 1 for rotations half a turn apart
+ */
+float rotationDifference(const glm::quat &a, const glm::quat &b) {
+  return 1.0f - std::abs(glm::dot(glm::normalize(a), glm::normalize(b)));
+}
+
+/*!
+ * Time frames of one method, best of REPEAT runs
+ * @param frame - Samples all instances at a time
+ * @return Milliseconds per frame
+ */
+double measure(const std::function<void(float)> &frame) {
+  double best = 1e30;
+  for (int run = 0; run < REPEAT; run++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < FRAMES; i++) frame((float) i * STEP);
+    auto end = std::chrono::high_resolution_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count() / FRAMES);
+  }
+  return best;
+}
+
+int main() {
+  auto keys = circleKeys();
+  ppgso::AnimationClip clip{keys, true};
+
+  std::mt19937 random{2};
+  std::uniform_real_distribution<float> offset{0.0f, clip.getDuration()};
+  std::vector<float> offsets(INSTANCES);
+  for (auto &o : offsets) o = offset(random);
+
+  std::vector<std::vector<ppgso::AnimationClip::Key>> copies(INSTANCES, keys);
+  std::vector<ppgso::AnimationClip::Pose> scanned(INSTANCES), poses(INSTANCES), batched;
+  std::vector<size_t> segments(INSTANCES, 0);
+
+  auto scan = measure([&](float time) {
+    for (size_t i = 0; i < INSTANCES; i++) scanned[i] = scanSample(copies[i], time + offsets[i]);
+  });
+  auto search = measure([&](float time) {
+    for (size_t i = 0; i < INSTANCES; i++) poses[i] = clip.sample(time + offsets[i]);
+  });
+  auto cached = measure([&](float time) {
+    for (size_t i = 0; i < INSTANCES; i++) poses[i] = clip.sample(time + offsets[i], segments[i]);
+  });
+  auto batch = measure([&](float time) {
+    clip.sample(time, offsets, batched);
+  });
+
+  // All methods sampled the same last frame, poses holds the cached samples
+  float positionError = 0.0f, rotationError = 0.0f;
+  auto time = (float) (FRAMES - 1) * STEP;
+  for (size_t i = 0; i < INSTANCES; i++) {
+    auto expected = clip.sample(time + offsets[i]);
+    positionError = std::max(positionError, glm::length(expected.position - poses[i].position));
+    positionError = std::max(positionError, glm::length(expected.position - batched[i].position));
+    rotationError = std::max(rotationError, rotationDifference(expected.rotation, poses[i].rotation));
+    rotationError = std::max(rotationError, rotationDifference(expected.rotation, batched[i].rotation));
+    rotationError = std::max(rotationError, rotationDifference(expected.rotation, scanned[i].rotation));
+  }
+
+  std::cout << INSTANCES << " instances, " << KEYS << " keys, ms per frame:" << std::endl;
+  std::cout << "Scan: " << scan << std::endl;
+  std::cout << "Search: " << search << std::endl;
+  std::cout << "Cached: " << cached << std::endl;
+  std::cout << "Batched: " << batch << std::endl;
+  if (positionError > POSITION_TOLERANCE || rotationError > ROTATION_TOLERANCE) {
+    std::cerr << "Samples differ by " << positionError << " in position and " << rotationError << " in rotation!"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+// Benchmark boids_bench
+// - Runs the fish_tank Flock simulation headless for growing schools at a constant fish density
+// - Four predators circle through the box, like the sharks of the fish tank
+// - Prints the time per step on one thread and on all threads, and whether 60 steps per second are sustained
+// - Checks the grid neighbour search against a brute force count on a small school first
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../fish_tank/Flock.h"
+
+// Fish per cubic unit, about 14 fish within the 1.2 perception radius before the schools form
+const float DENSITY = 2.0f;
+
+// Simulation rate the fish tank needs
+const float STEP = 1.0f / 60.0f;
+
+// Steps before timing, the schools form in the first seconds and neighbour counts grow with them
+const int WARMUP = 120;
+const int STEPS = 120;
+
+/*!
+ * Get box with a 2:1:1 shape holding count fish at DENSITY
+ * @param count - Number of fish
+ * @return Half size of the box around the origin
+ */
+glm::vec3 boxExtent(size_t count) {
+  // The whole box is 2 side x side x side
+  auto side = std::cbrt((float) count / DENSITY / 2.0f);
+  return {side, side / 2.0f, side / 2.0f};
+}
+
+/*!
+ * Move predators on circles through the box
+ * @param flock - Flock to update
+ * @param time - Simulation time in seconds
+ * @param extent - Half size of the box
+ */
+void movePredators(Flock &flock, float time, const glm::vec3 &extent) {
+  std::vector<glm::vec3> predators;
+  for (int i = 0; i < 4; i++) {
+    auto angle = time * 0.5f + (float) i * 1.5708f;
+    predators.emplace_back(std::cos(angle) * extent.x * 0.6f, std::sin(angle * 0.7f) * extent.y * 0.5f,
+                           std::sin(angle) * extent.z * 0.6f);
+  }
+  flock.setPredators(predators);
+}
+
+/*!
+ * Time steps of a flock
+ * @param count - Number of fish
+ * @param neighbours - Average neighbours per fish in the last step
+ * @return Milliseconds per step
+ */
+double measure(size_t count, float &neighbours) {
+  auto extent = boxExtent(count);
+  Flock flock{-extent, extent};
+  flock.spawn(count);
+
+  float time = 0.0f;
+  for (int i = 0; i < WARMUP; i++, time += STEP) {
+    movePredators(flock, time, extent);
+    flock.step(STEP);
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < STEPS; i++, time += STEP) {
+    movePredators(flock, time, extent);
+    flock.step(STEP);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  neighbours = flock.getAverageNeighbours();
+  return std::chrono::duration<double, std::milli>(end - start).count() / STEPS;
+}
+
+/*!
+ * Compare the grid neighbour count with all pairs
+ * @return True when both agree
+ */
+bool checkNeighbours() {
+  const size_t count = 2000;
+  auto extent = boxExtent(count);
+  Flock flock{-extent, extent};
+  flock.spawn(count, 7);
+  for (int i = 0; i < 60; i++) flock.step(STEP);
+
+  // A step of zero length counts the neighbours without moving anybody
+  flock.step(0.0f);
+  auto perception2 = flock.parameters.perception * flock.parameters.perception;
+  size_t pairs = 0;
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < count; j++) {
+      auto d = flock.getPosition(i) - flock.getPosition(j);
+      auto d2 = glm::dot(d, d);
+      if (d2 < perception2 && d2 > 0.0f) pairs++;
+    }
+  }
+  auto expected = (float) pairs / (float) count;
+  std::cout << "Neighbours per fish: grid " << flock.getAverageNeighbours() << ", all pairs " << expected << std::endl;
+  return std::abs(expected - flock.getAverageNeighbours()) < 1e-3f * std::max(expected, 1.0f);
+}
+
+int main() {
+  if (!checkNeighbours()) {
+    std::cerr << "Grid search missed neighbours!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  for (size_t count : {10000, 50000, 100000}) {
+    float neighbours;
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    auto single = measure(count, neighbours);
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    auto parallel = measure(count, neighbours);
+    std::cout << count << " fish, " << neighbours << " neighbours each: " << single << " ms per step on 1 thread, "
+              << parallel << " ms on " << threads << " threads (" << (parallel <= 1000.0 * STEP ? "" : "not ")
+              << "real time at 60 Hz)" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
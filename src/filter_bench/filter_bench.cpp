@@ -0,0 +1,233 @@
+// Benchmark filter_bench
+// - Runs the ppgso::image filters on lena.bmp
+// - Compares each against a straightforward per pixel implementation (direct 2D loops)
+// - Prints the time of both, the speedup and the largest per channel difference
+// - Saves the filtered images as filter_*.bmp
+// - Runs ppgso::Convolution with asymmetric kernels on the GPU and fails when it differs from the CPU
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+
+#include <ppgso/ppgso.h>
+
+// Number of runs, the best one is reported
+const int REPEAT = 5;
+
+// Largest per channel difference allowed between the GPU and the CPU convolution,
+// the separable path rounds its first pass to 8 bits
+const int GPU_TOLERANCE = 2;
+
+/*!
+ * Direct 2D convolution with clamped edges, one pixel and channel at a time
+ * @param image Image to filter
+ * @param kernel Row major size x size weights
+ * @param size Kernel width and height
+ * @return Filtered image
+ */
+ppgso::Image naiveConvolve(ppgso::Image &image, const std::vector<float> &kernel, int size) {
+  ppgso::Image result{image.width, image.height};
+  int radius = size / 2;
+  for (int y = 0; y < image.height; y++) {
+    for (int x = 0; x < image.width; x++) {
+      float r = 0, g = 0, b = 0;
+      for (int ky = 0; ky < size; ky++) {
+        for (int kx = 0; kx < size; kx++) {
+          int sx = std::min(std::max(x + kx - radius, 0), image.width - 1);
+          int sy = std::min(std::max(y + ky - radius, 0), image.height - 1);
+          auto &pixel = image.getPixel(sx, sy);
+          float weight = kernel[ky * size + kx];
+          r += pixel.r * weight;
+          g += pixel.g * weight;
+          b += pixel.b * weight;
+        }
+      }
+      result.setPixel(x, y, r / 255.0f, g / 255.0f, b / 255.0f);
+    }
+  }
+  return result;
+}
+
+/*!
+ * Build the 2D Gaussian kernel matching ppgso::image::gaussianBlur
+ * @param sigma Standard deviation in pixels
+ * @param size Output kernel width and height
+ * @return Row major weights
+ */
+std::vector<float> gaussianKernel(float sigma, int &size) {
+  int radius = std::max(1, (int) std::ceil(sigma * 3.0f));
+  size = 2 * radius + 1;
+  std::vector<float> line((size_t) size);
+  float total = 0;
+  for (int i = -radius; i <= radius; i++) {
+    line[i + radius] = std::exp(-(float) (i * i) / (2.0f * sigma * sigma));
+    total += line[i + radius];
+  }
+  std::vector<float> kernel((size_t) (size * size));
+  for (int y = 0; y < size; y++)
+    for (int x = 0; x < size; x++)
+      kernel[y * size + x] = line[y] * line[x] / (total * total);
+  return kernel;
+}
+
+/*!
+ * Time a filter, keeping the best of several runs
+ * @param filter Function producing the filtered image
+ * @param result Output of the last run
+ * @return Best time in milliseconds
+ */
+double measure(const std::function<ppgso::Image()> &filter, ppgso::Image &result) {
+  double best = 1e9;
+  for (int i = 0; i < REPEAT; i++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    result = filter();
+    auto end = std::chrono::high_resolution_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return best;
+}
+
+/*!
+ * Run both implementations of a filter and report the comparison
+ * @param name Filter label, also used for the output file name
+ * @param fast Library implementation
+ * @param naive Reference implementation
+ */
+void compare(const std::string &name, const std::function<ppgso::Image()> &fast, const std::function<ppgso::Image()> &naive) {
+  ppgso::Image fastResult{0, 0}, naiveResult{0, 0};
+  auto fastTime = measure(fast, fastResult);
+  auto naiveTime = measure(naive, naiveResult);
+
+  int difference = 0;
+  auto &a = fastResult.getFramebuffer();
+  auto &b = naiveResult.getFramebuffer();
+  for (size_t i = 0; i < a.size(); i++) {
+    difference = std::max(difference, std::abs(a[i].r - b[i].r));
+    difference = std::max(difference, std::abs(a[i].g - b[i].g));
+    difference = std::max(difference, std::abs(a[i].b - b[i].b));
+  }
+
+  std::cout << name << ": naive " << naiveTime << " ms, ppgso " << fastTime << " ms, speedup "
+            << naiveTime / fastTime << "x, max difference " << difference << std::endl;
+  ppgso::image::saveBMP(fastResult, "filter_" + name + ".bmp");
+}
+
+/*!
+ * Filter the image with ppgso::Convolution and compare it to ppgso::image::convolve
+ * Edge pixels are skipped, the source texture repeats while the CPU filter clamps.
+ * @param name Filter label
+ * @param image Image to filter
+ * @param kernel Row major size x size weights, as expected by both implementations
+ * @param size Kernel width and height
+ * @param factor Result is divided by factor
+ * @param bias Added to the result, keeps negative responses of the kernel visible
+ * @return True when both agree within GPU_TOLERANCE
+ */
+bool compareGpu(const std::string &name, const ppgso::Image &image, const std::vector<float> &kernel, int size,
+                float factor, float bias) {
+  auto expected = ppgso::image::convolve(image, kernel, size, factor, bias);
+
+  ppgso::Texture source{ppgso::Image{image}};
+  ppgso::RenderTarget target{image.width, image.height, ppgso::Texture::Format::RGBA8, false};
+  ppgso::Convolution convolution{kernel, size, factor, bias};
+  convolution.apply(source, target);
+
+  ppgso::Image result{image.width, image.height};
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  target.getTexture().bind();
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, result.getFramebuffer().data());
+
+  int difference = 0, radius = size / 2;
+  for (int y = radius; y < image.height - radius; y++) {
+    for (int x = radius; x < image.width - radius; x++) {
+      auto &a = result.getPixel(x, y);
+      auto &b = expected.getPixel(x, y);
+      difference = std::max(difference, std::abs(a.r - b.r));
+      difference = std::max(difference, std::abs(a.g - b.g));
+      difference = std::max(difference, std::abs(a.b - b.b));
+    }
+  }
+
+  const char *methods[] = {"separable", "compute", "direct"};
+  std::cout << name << " on GPU (" << methods[(int) convolution.getMethod()] << "): max difference " << difference
+            << std::endl;
+  return difference <= GPU_TOLERANCE;
+}
+
+int main() {
+  auto image = ppgso::image::loadBMP("lena.bmp");
+
+  int gaussianSize;
+  auto gaussian = gaussianKernel(2.0f, gaussianSize);
+  compare("gaussian", [&]() { return ppgso::image::gaussianBlur(image, 2.0f); },
+          [&]() { return naiveConvolve(image, gaussian, gaussianSize); });
+
+  std::vector<float> box(7 * 7, 1.0f / 49.0f);
+  compare("box", [&]() { return ppgso::image::boxBlur(image, 3); },
+          [&]() { return naiveConvolve(image, box, 7); });
+
+  // The emboss kernel from gl8_framebuffer
+  std::vector<float> emboss = {
+           0.0f, -1.0f, -1.0f, -1.0f, -1.0f,
+           1.0f,  0.0f, -1.0f, -1.0f, -1.0f,
+           1.0f,  1.0f,  0.0f, -1.0f, -1.0f,
+           1.0f,  1.0f,  1.0f,  0.0f, -1.0f,
+           1.0f,  1.0f,  1.0f,  1.0f,  0.0f};
+  compare("emboss", [&]() { return ppgso::image::convolve(image, emboss, 5); },
+          [&]() { return naiveConvolve(image, emboss, 5); });
+
+  // Sepia tone, columns hold the contribution of r, g and b
+  glm::mat3 sepia{0.393f, 0.349f, 0.272f,
+                  0.769f, 0.686f, 0.534f,
+                  0.189f, 0.168f, 0.131f};
+  compare("sepia", [&]() { return ppgso::image::colorMatrix(image, sepia); },
+          [&]() {
+            ppgso::Image result{image.width, image.height};
+            for (int y = 0; y < image.height; y++) {
+              for (int x = 0; x < image.width; x++) {
+                auto &pixel = image.getPixel(x, y);
+                auto color = sepia * glm::vec3{pixel.r, pixel.g, pixel.b} / 255.0f;
+                result.setPixel(x, y, color.r, color.g, color.b);
+              }
+            }
+            return result;
+          });
+
+  compare("sharpen", [&]() { return ppgso::image::sharpen(image, 1.0f, 1.0f); },
+          [&]() {
+            int size;
+            auto kernel = gaussianKernel(1.0f, size);
+            auto blurred = naiveConvolve(image, kernel, size);
+            ppgso::Image result{image.width, image.height};
+            for (int y = 0; y < image.height; y++) {
+              for (int x = 0; x < image.width; x++) {
+                auto &pixel = image.getPixel(x, y);
+                auto &blur = blurred.getPixel(x, y);
+                result.setPixel(x, y, (2.0f * pixel.r - blur.r) / 255.0f, (2.0f * pixel.g - blur.g) / 255.0f,
+                                (2.0f * pixel.b - blur.b) / 255.0f);
+              }
+            }
+            return result;
+          });
+
+  // Neither kernel is symmetric, so a row/column mix-up between the two paths fails
+  try {
+    ppgso::Window window{"filter_bench", 64, 64};
+    std::vector<float> sobel = {
+            -1.0f, 0.0f, 1.0f,
+            -2.0f, 0.0f, 2.0f,
+            -1.0f, 0.0f, 1.0f};
+    bool matching = compareGpu("emboss", image, emboss, 5, 1.0f, 0.5f);
+    matching = compareGpu("sobel", image, sobel, 3, 4.0f, 0.5f) && matching;
+    if (!matching) {
+      std::cerr << "GPU convolution does not match the CPU one" << std::endl;
+      return EXIT_FAILURE;
+    }
+  } catch (const std::runtime_error &error) {
+    std::cout << "GPU comparison skipped: " << error.what() << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
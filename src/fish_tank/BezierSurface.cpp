@@ -15,16 +15,20 @@ BezierSurface::BezierSurface() {
     );
 
     // Load the ground texture
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/ground.bmp"));
+    if (!texture) texture = ppgso::TextureCache::get("textures/ground.bmp");
 
     // Generate the surface with a resolution of 20x20
     generateSurface(20);
 
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = this;
 }
 
 BezierSurface::~BezierSurface() {
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
+    ppgso::RenderState::forgetVertexArray(vao);
     glDeleteVertexArrays(1, &vao);
 }
 glm::vec3 BezierSurface::evaluateBezier(float u, float v) {
@@ -99,14 +103,11 @@ void BezierSurface::render(Scene& scene) {
     shader->setUniform("projection", scene.camera->projectionMatrix);
     shader->setUniform("Texture", *texture);
 
-    // Bind the texture
-    glActiveTexture(GL_TEXTURE0);
-    // glBindTexture(GL_TEXTURE_2D, texture->id);
+    // The texture is already bound to unit 0 by the uniform above
     shader->setUniform("textureSampler", 0);
 
     // Bind the VAO and draw the elements
-    glBindVertexArray(vao);
+    ppgso::RenderState::bindVertexArray(vao);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
@@ -16,7 +16,7 @@ private:
     std::vector<GLuint> indices;
 
     GLuint vao, vbo, ebo;   // OpenGL buffers
-    std::unique_ptr<ppgso::Texture> texture;         // Texture for the ground
+    std::shared_ptr<ppgso::Texture> texture;         // Texture for the ground
 
     std::unique_ptr<ppgso::Shader> shader;
 
@@ -0,0 +1,154 @@
+#include "FishSchool.h"
+#include "Shark.h"
+#include <shaders/diffuse_vert_glsl.h>
+#include <shaders/diffuse_instanced_vert_glsl.h>
+#include <shaders/diffuse_frag_glsl.h>
+
+// Static resources
+std::shared_ptr<ppgso::Mesh> FishSchool::mesh;
+std::shared_ptr<ppgso::Shader> FishSchool::shader;
+std::shared_ptr<ppgso::Shader> FishSchool::instancedShader;
+std::shared_ptr<ppgso::Texture> FishSchool::texture;
+
+// Axis fish_1 is modelled along, the flock turns it to the swimming direction
+const glm::vec3 FISH_FORWARD{0.0f, 1.0f, 0.0f};
+
+// Longest step the flock takes, a slow frame must not shoot fish through each other
+const float MAX_STEP = 1.0f / 30.0f;
+
+FishSchool::FishSchool(size_t count, const glm::vec3& center, const glm::vec3& extent)
+    : flock{center - extent, center + extent}
+{
+    // Load shared resources if not already loaded
+    if (!mesh) mesh = ppgso::MeshCache::get("fish_1.gltf", LOD_LEVELS);
+    if (!texture) texture = ppgso::TextureCache::get("textures/fish_1_baseColor.bmp");
+
+    flock.spawn(count);
+    scales.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        scales.push_back(glm::linearRand(0.5f, 1.5f));
+    flock.writeModels(models, FISH_FORWARD, scales);
+
+    if (ppgso::InstanceCuller::isSupported())
+    {
+        if (!instancedShader) instancedShader = ppgso::ShaderCache::get(diffuse_instanced_vert_glsl, diffuse_frag_glsl);
+        culler = std::make_unique<ppgso::InstanceCuller>(mesh->getParts(), mesh->getRadius(), count);
+        culler->setInstances(models);
+        renderShader = instancedShader.get();
+    }
+    else
+    {
+        if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+        lods.assign(count, 0);
+        renderShader = shader.get();
+    }
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
+}
+
+bool FishSchool::update(Scene& scene, float dt)
+{
+    std::vector<glm::vec3> predators;
+    for (auto& obj : scene.objects)
+        if (dynamic_cast<Shark*>(obj.get())) predators.push_back(obj->position);
+    flock.setPredators(predators);
+
+    dt = std::min(dt, MAX_STEP);
+    if (gpuSimulated)
+    {
+        // The matrices stay on the GPU, the culler only learns how many there are
+        gpuFlock->setPredators(predators);
+        gpuFlock->step(dt, culler->getInstanceBuffer(), FISH_FORWARD);
+        culler->setInstanceCount(gpuFlock->size());
+        return true;
+    }
+
+    flock.step(dt);
+    flock.writeModels(models, FISH_FORWARD, scales);
+    if (culler) culler->setInstances(models);
+    return true;
+}
+
+bool FishSchool::setGpuSimulated(bool enabled)
+{
+    if (enabled == gpuSimulated) return true;
+    if (enabled)
+    {
+        if (!culler || !GpuFlock::isSupported()) return false;
+        // Both simulations continue from the same state
+        if (!gpuFlock) gpuFlock = std::make_unique<GpuFlock>(flock, scales);
+        else gpuFlock->upload(flock);
+    }
+    else
+    {
+        gpuFlock->download(flock);
+    }
+    gpuSimulated = enabled;
+    return true;
+}
+
+bool FishSchool::isGpuSimulated() const
+{
+    return gpuSimulated;
+}
+
+float FishSchool::getAverageNeighbours() const
+{
+    return gpuSimulated ? gpuFlock->getAverageNeighbours() : flock.getAverageNeighbours();
+}
+
+void FishSchool::render(Scene& scene)
+{
+    auto& camera = *scene.camera;
+    if (culler)
+    {
+        culler->cull(camera.projectionMatrix, camera.viewMatrix);
+
+        instancedShader->setUniform("LightDirection", scene.lightDirection);
+        instancedShader->setUniform("ProjectionMatrix", camera.projectionMatrix);
+        instancedShader->setUniform("ViewMatrix", camera.viewMatrix);
+        instancedShader->setUniform("Texture", *texture);
+        culler->draw(*instancedShader);
+        return;
+    }
+
+    shader->setUniform("LightDirection", scene.lightDirection);
+    shader->setUniform("ProjectionMatrix", camera.projectionMatrix);
+    shader->setUniform("ViewMatrix", camera.viewMatrix);
+    shader->setUniform("Texture", *texture);
+
+    // Same sphere test as instance_cull_comp.glsl
+    auto matrix = glm::transpose(camera.projectionMatrix * camera.viewMatrix);
+    glm::vec4 planes[6] = {matrix[3] + matrix[0], matrix[3] - matrix[0], matrix[3] + matrix[1],
+                           matrix[3] - matrix[1], matrix[3] + matrix[2], matrix[3] - matrix[2]};
+    for (auto& plane : planes) plane /= glm::length(glm::vec3{plane});
+
+    auto lodCount = mesh->getLodCount();
+    drawn.assign(lodCount, 0);
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        auto& model = models[i];
+        glm::vec3 center{model[3]};
+        auto radius = mesh->getRadius() * glm::length(glm::vec3{model[0]});
+        bool inside = true;
+        for (auto& plane : planes)
+            inside = inside && glm::dot(glm::vec3{plane}, center) + plane.w >= -radius;
+        if (!inside) continue;
+
+        lods[i] = stepLod(scene, center, radius, lodCount, lods[i]);
+        drawn[lods[i]]++;
+        shader->setUniform("ModelMatrix", model);
+        mesh->render(lods[i]);
+    }
+}
+
+std::vector<size_t> FishSchool::getVisible() const
+{
+    if (culler) return culler->readVisible();
+    return drawn;
+}
+
+bool FishSchool::isGpuCulled() const
+{
+    return culler != nullptr;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <ppgso/ppgso.h>
+#include "scene.h"
+#include "object.h"
+#include "Flock.h"
+#include "GpuFlock.h"
+
+/*!
+ * Large school of FishType1 fish drawn as one object
+ *
+ * The fish swim as a Flock and flee the sharks of the scene. With OpenGL 4.3 the simulation can move to
+ * a GpuFlock, which writes the instance buffer of the culler directly.
+ * With an OpenGL 4.3 context the fish are culled and assigned a level of detail by ppgso::InstanceCuller
+ * on the GPU, so the CPU cost per frame is a few indirect draws no matter how many fish there are.
+ * Older contexts cull on the CPU and draw the visible fish one by one.
+ */
+class FishSchool final : public Object
+{
+private:
+    // Static resources shared across instances
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Shader> instancedShader;
+    static std::shared_ptr<ppgso::Texture> texture;
+
+    std::unique_ptr<ppgso::InstanceCuller> culler;
+    Flock flock;
+    std::unique_ptr<GpuFlock> gpuFlock;
+    bool gpuSimulated = false;
+    std::vector<float> scales;   // Size of every fish
+    std::vector<glm::mat4> models;
+    std::vector<size_t> lods;    // Level of every fish on the CPU path
+    std::vector<size_t> drawn;   // Fish per level drawn in the last frame on the CPU path
+
+public:
+    /*!
+     * Scatter fish in a box with random headings
+     * @param count Number of fish
+     * @param center Center of the box
+     * @param extent Half size of the box along each axis, the fish stay inside it
+     */
+    FishSchool(size_t count, const glm::vec3& center, const glm::vec3& extent);
+
+    /*!
+     * Update the FishSchool
+     * @param scene Scene to interact with
+     * @param dt Time delta for animation purposes
+     * @return False if the object should be deleted
+     */
+    bool update(Scene& scene, float dt) override;
+
+    /*!
+     * Cull and render the fish
+     * @param scene Scene to render in
+     */
+    void render(Scene& scene) override;
+
+    /*!
+     * Count fish drawn in the last frame per level of detail, reads back from the GPU on the GPU path
+     * @return Fish per level
+     */
+    std::vector<size_t> getVisible() const;
+
+    /*!
+     * Switch between the CPU and the GPU simulation, the fish keep their state
+     * @param enabled True to simulate on the GPU
+     * @return False when the GPU simulation is not supported
+     */
+    bool setGpuSimulated(bool enabled);
+
+    bool isGpuSimulated() const;
+
+    /*!
+     * Get neighbours each fish perceived in the last step, reads back from the GPU in the GPU simulation
+     * @return Neighbours per fish
+     */
+    float getAverageNeighbours() const;
+
+    /*!
+     * Check whether the fish are culled on the GPU
+     * @return True when ppgso::InstanceCuller is used
+     */
+    bool isGpuCulled() const;
+};
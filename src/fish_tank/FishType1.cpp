@@ -7,16 +7,19 @@
 #include <shaders/diffuse_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> FishType1::mesh;
-std::unique_ptr<ppgso::Shader> FishType1::shader;
-std::unique_ptr<ppgso::Texture> FishType1::texture;
+std::shared_ptr<ppgso::Mesh> FishType1::mesh;
+std::shared_ptr<ppgso::Shader> FishType1::shader;
+std::shared_ptr<ppgso::Texture> FishType1::texture;
 
 FishType1::FishType1()
 {
     // Load shared resources if not already loaded
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("fish_1.gltf");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/fish_1_baseColor.bmp"));
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+    if (!mesh) mesh = ppgso::MeshCache::get("fish_1.gltf", LOD_LEVELS);
+    if (!texture) texture = ppgso::TextureCache::get("textures/fish_1_baseColor.bmp");
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
     scale = glm::vec3(5.0f, 5.0f, 5.0f);
     rotation = glm::ballRand(ppgso::PI);
     rotMomentum = glm::ballRand(ppgso::PI);
@@ -45,6 +48,7 @@ bool FishType1::update(Scene& scene, float dt)
     rotation.x += rotMomentum.x * dt * 0.1f;
     rotation.y += rotMomentum.y * dt * 0.1f;
     generateModelMatrix();
+    selectLod(scene, mesh->getRadius(), mesh->getLodCount());
     return true;
 }
 
@@ -62,7 +66,7 @@ void FishType1::render(Scene& scene)
     shader->setUniform("Texture", *texture);
 
     // Render the mesh
-    mesh->render();
+    mesh->render(lod);
 }
 
 void FishType1::fleeFrom(const glm::vec3& predatorPosition, float fleeSpeed, float dt) {
@@ -7,16 +7,19 @@
 #include <shaders/diffuse_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> FishType2::mesh;
-std::unique_ptr<ppgso::Shader> FishType2::shader;
-std::unique_ptr<ppgso::Texture> FishType2::texture;
+std::shared_ptr<ppgso::Mesh> FishType2::mesh;
+std::shared_ptr<ppgso::Shader> FishType2::shader;
+std::shared_ptr<ppgso::Texture> FishType2::texture;
 
 FishType2::FishType2()
 {
     // Load shared resources if not already loaded
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("fish_2.gltf");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/fish_2_baseColor.bmp"));
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+    if (!mesh) mesh = ppgso::MeshCache::get("fish_2.gltf", LOD_LEVELS);
+    if (!texture) texture = ppgso::TextureCache::get("textures/fish_2_baseColor.bmp");
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
     scale = glm::vec3(0.05f, 0.05f, 0.05f);
     rotation = glm::ballRand(ppgso::PI);
     rotMomentum = glm::ballRand(ppgso::PI);
@@ -51,6 +54,7 @@ bool FishType2::update(Scene& scene, float dt)
     }
 
     generateModelMatrix();
+    selectLod(scene, mesh->getRadius(), mesh->getLodCount());
     return true;
 }
 
@@ -67,7 +71,7 @@ void FishType2::render(Scene& scene)
     shader->setUniform("Texture", *texture);
 
     // Render the mesh
-    mesh->render();
+    mesh->render(lod);
 }
 
 void FishType2::fleeFrom(const glm::vec3& predatorPosition, float fleeSpeed, float dt)
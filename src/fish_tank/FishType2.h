@@ -10,9 +10,9 @@ class FishType2 final : public Object
 {
 private:
  // Static resources shared across instances
- static std::unique_ptr<ppgso::Mesh> mesh;
- static std::unique_ptr<ppgso::Shader> shader;
- static std::unique_ptr<ppgso::Texture> texture;
+ static std::shared_ptr<ppgso::Mesh> mesh;
+ static std::shared_ptr<ppgso::Shader> shader;
+ static std::shared_ptr<ppgso::Texture> texture;
 
 public:
  glm::vec3 speed;
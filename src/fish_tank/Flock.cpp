@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "Flock.h"
+
+Flock::Flock(const glm::vec3& minimum, const glm::vec3& maximum, const Parameters& parameters)
+    : parameters{parameters}, minimum{minimum}, maximum{maximum}
+{
+}
+
+Flock::Flock(const glm::vec3& minimum, const glm::vec3& maximum) : Flock{minimum, maximum, Parameters{}}
+{
+}
+
+void Flock::spawn(size_t count, uint32_t seed)
+{
+    std::mt19937 random{seed};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f}, side{-1.0f, 1.0f};
+    for (size_t i = 0; i < count; i++)
+    {
+        auto position = minimum + (maximum - minimum) * glm::vec3{unit(random), unit(random), unit(random)};
+        glm::vec3 heading{side(random), side(random), side(random)};
+        if (glm::dot(heading, heading) < 1e-4f) heading = {1.0f, 0.0f, 0.0f};
+        auto velocity = glm::normalize(heading) * parameters.minSpeed;
+        px.push_back(position.x);
+        py.push_back(position.y);
+        pz.push_back(position.z);
+        vx.push_back(velocity.x);
+        vy.push_back(velocity.y);
+        vz.push_back(velocity.z);
+        fishIds.push_back((uint32_t) fishIds.size());
+    }
+}
+
+void Flock::setPredators(const std::vector<glm::vec3>& positions)
+{
+    predators = positions;
+}
+
+void Flock::sort()
+{
+    // Grid covering the box, fish on the boundary belong to the outer cells
+    inverseCell = 1.0f / parameters.perception;
+    auto extent = maximum - minimum;
+    for (int axis = 0; axis < 3; axis++)
+        cells[axis] = std::max(1, (int) std::ceil(extent[axis] * inverseCell));
+
+    auto count = px.size();
+    cellOf.resize(count);
+    cellStart.assign((size_t) cells[0] * cells[1] * cells[2] + 1, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto cx = std::min(std::max((int) ((px[i] - minimum.x) * inverseCell), 0), cells[0] - 1);
+        auto cy = std::min(std::max((int) ((py[i] - minimum.y) * inverseCell), 0), cells[1] - 1);
+        auto cz = std::min(std::max((int) ((pz[i] - minimum.z) * inverseCell), 0), cells[2] - 1);
+        cellOf[i] = (uint32_t) ((cz * cells[1] + cy) * cells[0] + cx);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t cell = 1; cell < cellStart.size(); cell++)
+        cellStart[cell] += cellStart[cell - 1];
+
+    // Counting sort, fish of a cell keep their relative order so the flock evolves deterministically
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    nx.resize(count), ny.resize(count), nz.resize(count);
+    nvx.resize(count), nvy.resize(count), nvz.resize(count);
+    nextIds.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto target = fill[cellOf[i]]++;
+        nx[target] = px[i], ny[target] = py[i], nz[target] = pz[i];
+        nvx[target] = vx[i], nvy[target] = vy[i], nvz[target] = vz[i];
+        nextIds[target] = fishIds[i];
+    }
+    px.swap(nx), py.swap(ny), pz.swap(nz);
+    vx.swap(nvx), vy.swap(nvy), vz.swap(nvz);
+    fishIds.swap(nextIds);
+}
+
+void Flock::step(float dt)
+{
+    sort();
+
+    auto count = (long) px.size();
+    const auto p = parameters;
+    auto perception2 = p.perception * p.perception, separation2 = p.separation * p.separation;
+    auto predatorRadius2 = p.predatorRadius * p.predatorRadius;
+    const float *x = px.data(), *y = py.data(), *z = pz.data();
+    const float *u = vx.data(), *v = vy.data(), *w = vz.data();
+    const uint32_t* start = cellStart.data();
+    double neighbours = 0.0;
+
+    // The new state goes to the sorting scratch, every fish reads the state of the previous step only
+    #pragma omp parallel for schedule(static) reduction(+:neighbours)
+    for (long i = 0; i < count; i++)
+    {
+        glm::vec3 position{x[i], y[i], z[i]}, velocity{u[i], v[i], w[i]};
+        auto cx = std::min(std::max((int) ((position.x - minimum.x) * inverseCell), 0), cells[0] - 1);
+        auto cy = std::min(std::max((int) ((position.y - minimum.y) * inverseCell), 0), cells[1] - 1);
+        auto cz = std::min(std::max((int) ((position.z - minimum.z) * inverseCell), 0), cells[2] - 1);
+        auto x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, cells[0] - 1);
+        auto fx = position.x, fy = position.y, fz = position.z;
+
+        float seen = 0.0f, offsetX = 0.0f, offsetY = 0.0f, offsetZ = 0.0f;
+        float headingX = 0.0f, headingY = 0.0f, headingZ = 0.0f, pushX = 0.0f, pushY = 0.0f, pushZ = 0.0f;
+        for (int gz = std::max(cz - 1, 0); gz <= std::min(cz + 1, cells[2] - 1); gz++)
+        {
+            for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, cells[1] - 1); gy++)
+            {
+                // Three neighbouring cells of a row are one run of fish
+                auto row = (gz * cells[1] + gy) * cells[0];
+                auto begin = (long) start[row + x0], end = (long) start[row + x1 + 1];
+                #pragma omp simd reduction(+:seen, offsetX, offsetY, offsetZ, headingX, headingY, headingZ, pushX, pushY, pushZ)
+                for (long j = begin; j < end; j++)
+                {
+                    auto dx = x[j] - fx, dy = y[j] - fy, dz = z[j] - fz;
+                    auto d2 = dx * dx + dy * dy + dz * dz;
+                    // Masks instead of branches keep the loop vectorized, the fish itself is at distance 0
+                    auto near = (float) ((d2 < perception2) & (d2 > 0.0f));
+                    auto push = (float) ((d2 < separation2) & (d2 > 0.0f)) / std::max(d2, 1e-6f);
+                    seen += near;
+                    offsetX += near * dx, offsetY += near * dy, offsetZ += near * dz;
+                    headingX += near * u[j], headingY += near * v[j], headingZ += near * w[j];
+                    pushX -= push * dx, pushY -= push * dy, pushZ -= push * dz;
+                }
+            }
+        }
+        neighbours += seen;
+
+        // Separation, alignment with the average heading and cohesion towards the average position
+        glm::vec3 steer = p.separationWeight * glm::vec3{pushX, pushY, pushZ};
+        if (seen > 0.0f)
+        {
+            steer += p.alignmentWeight * (glm::vec3{headingX, headingY, headingZ} / seen - velocity);
+            steer += p.cohesionWeight * glm::vec3{offsetX, offsetY, offsetZ} / seen;
+        }
+
+        // Flee predators, harder the closer they are
+        for (auto& predator : predators)
+        {
+            auto away = position - predator;
+            auto d2 = glm::dot(away, away);
+            if (d2 >= predatorRadius2 || d2 <= 0.0f) continue;
+            auto distance = std::sqrt(d2);
+            steer += p.predatorWeight * p.maxSpeed * (1.0f - distance / p.predatorRadius) * away / distance;
+        }
+
+        // Turn back from the walls before reaching them
+        for (int axis = 0; axis < 3; axis++)
+        {
+            auto low = minimum[axis] + p.wallMargin - position[axis];
+            auto high = position[axis] - (maximum[axis] - p.wallMargin);
+            if (low > 0.0f) steer[axis] += p.wallWeight * p.maxSpeed * low / p.wallMargin;
+            if (high > 0.0f) steer[axis] -= p.wallWeight * p.maxSpeed * high / p.wallMargin;
+        }
+
+        auto force = glm::length(steer);
+        if (force > p.maxForce) steer *= p.maxForce / force;
+        velocity += steer * dt;
+        auto speed = glm::length(velocity);
+        if (speed > p.maxSpeed) velocity *= p.maxSpeed / speed;
+        else if (speed < p.minSpeed) velocity = speed > 1e-6f ? velocity * (p.minSpeed / speed) : glm::vec3{p.minSpeed, 0, 0};
+        position = glm::clamp(position + velocity * dt, minimum, maximum);
+
+        nx[i] = position.x, ny[i] = position.y, nz[i] = position.z;
+        nvx[i] = velocity.x, nvy[i] = velocity.y, nvz[i] = velocity.z;
+    }
+    px.swap(nx), py.swap(ny), pz.swap(nz);
+    vx.swap(nvx), vy.swap(nvy), vz.swap(nvz);
+    averageNeighbours = count ? (float) (neighbours / (double) count) : 0.0f;
+}
+
+void Flock::writeModels(std::vector<glm::mat4>& models, const glm::vec3& forward, const std::vector<float>& scales) const
+{
+    auto mesh = meshRotation(forward);
+
+    auto count = (long) px.size();
+    models.resize(px.size());
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < count; i++)
+    {
+        glm::vec3 heading{vx[i], vy[i], vz[i]};
+        heading = glm::normalize(heading);
+        auto up = std::abs(heading.y) < 0.99f ? glm::vec3{0.0f, 1.0f, 0.0f} : glm::vec3{1.0f, 0.0f, 0.0f};
+        auto side = glm::normalize(glm::cross(up, heading));
+        up = glm::cross(heading, side);
+
+        glm::mat3 rotation = glm::mat3{side, up, heading} * mesh;
+        auto id = fishIds[i];
+        auto scale = id < scales.size() ? scales[id] : 1.0f;
+        glm::mat4 model{rotation * scale};
+        model[3] = glm::vec4{px[i], py[i], pz[i], 1.0f};
+        models[id] = model;
+    }
+}
+
+void Flock::assign(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities)
+{
+    auto count = std::min(positions.size(), velocities.size());
+    px.resize(count), py.resize(count), pz.resize(count);
+    vx.resize(count), vy.resize(count), vz.resize(count);
+    fishIds.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        px[i] = positions[i].x, py[i] = positions[i].y, pz[i] = positions[i].z;
+        vx[i] = velocities[i].x, vy[i] = velocities[i].y, vz[i] = velocities[i].z;
+        fishIds[i] = (uint32_t) i;
+    }
+}
+
+glm::mat3 Flock::meshRotation(const glm::vec3& forward)
+{
+    // Mesh axes, forward goes along the velocity and the axis after it stays close to world up
+    auto meshForward = glm::normalize(forward);
+    auto meshUp = std::abs(meshForward.y) < 0.9f ? glm::vec3{0.0f, 1.0f, 0.0f} : glm::vec3{0.0f, 0.0f, 1.0f};
+    auto meshSide = glm::normalize(glm::cross(meshUp, meshForward));
+    meshUp = glm::cross(meshForward, meshSide);
+    // Inverse of the orthonormal mesh basis
+    return glm::transpose(glm::mat3{meshSide, meshUp, meshForward});
+}
+
+size_t Flock::size() const
+{
+    return px.size();
+}
+
+const glm::vec3& Flock::getMinimum() const
+{
+    return minimum;
+}
+
+const glm::vec3& Flock::getMaximum() const
+{
+    return maximum;
+}
+
+glm::vec3 Flock::getPosition(size_t index) const
+{
+    return {px[index], py[index], pz[index]};
+}
+
+glm::vec3 Flock::getVelocity(size_t index) const
+{
+    return {vx[index], vy[index], vz[index]};
+}
+
+const std::vector<uint32_t>& Flock::ids() const
+{
+    return fishIds;
+}
+
+float Flock::getAverageNeighbours() const
+{
+    return averageNeighbours;
+}
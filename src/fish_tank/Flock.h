@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*!
+ * Boids schooling simulation (Reynolds 1987) for large fish schools
+ *
+ * Every fish steers by separation from close neighbours, alignment with and cohesion towards the neighbours
+ * it perceives, avoidance of predators and of the walls of its box. Neighbours are found through a uniform grid
+ * with cells as large as the perception radius. Each step counting-sorts the fish by cell, so the three cells
+ * of a grid row along X are one contiguous run of memory and the 27 cell neighbourhood is 9 runs that the
+ * inner loop walks without branches. Fish are updated in parallel with OpenMP.
+ *
+ * State is kept as separate position and velocity arrays per axis, in grid order. ids() maps them
+ * back to the order the fish were added in.
+ */
+class Flock
+{
+public:
+    struct Parameters
+    {
+        float perception = 1.2f;       // Radius of alignment and cohesion, also the grid cell size
+        float separation = 0.8f;       // Fish closer than this push each other away
+        float separationWeight = 2.0f;
+        float alignmentWeight = 1.0f;
+        float cohesionWeight = 0.5f;
+        float predatorRadius = 8.0f;   // Fish flee predators closer than this
+        float predatorWeight = 6.0f;
+        float wallMargin = 3.0f;       // Fish turn away from walls closer than this
+        float wallWeight = 4.0f;
+        float minSpeed = 2.0f;
+        float maxSpeed = 6.0f;
+        float maxForce = 10.0f;        // Largest acceleration of a single step
+    };
+
+    /*!
+     * Create flock inside a box
+     * @param minimum Lowest corner of the box
+     * @param maximum Highest corner of the box
+     * @param parameters Steering parameters, defaults when left out
+     */
+    Flock(const glm::vec3& minimum, const glm::vec3& maximum, const Parameters& parameters);
+    Flock(const glm::vec3& minimum, const glm::vec3& maximum);
+
+    /*!
+     * Add fish at random positions inside the box with random headings
+     * @param count Number of fish to add
+     * @param seed Random seed, the same seed gives the same flock
+     */
+    void spawn(size_t count, uint32_t seed = 1);
+
+    /*!
+     * Set predators the fish flee from in the next steps
+     * @param positions World positions of the predators
+     */
+    void setPredators(const std::vector<glm::vec3>& positions);
+
+    /*!
+     * Advance the simulation
+     * @param dt Time step in seconds
+     */
+    void step(float dt);
+
+    /*!
+     * Write a model matrix for every fish, in the order the fish were added in
+     * @param models Resized to the number of fish
+     * @param forward Axis of the mesh that should point along the velocity
+     * @param scales Uniform scale of each fish in the order the fish were added in, 1 when empty
+     */
+    void writeModels(std::vector<glm::mat4>& models, const glm::vec3& forward,
+                     const std::vector<float>& scales = {}) const;
+
+    /*!
+     * Replace all fish, for example with the state of a GpuFlock
+     * @param positions Positions in the order the fish were added in
+     * @param velocities Velocities in the same order
+     */
+    void assign(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& velocities);
+
+    /*!
+     * Get rotation taking the forward axis of a mesh to +Z, with the axis after it kept close to +Y
+     * Model matrices of the fish are the velocity frame times this rotation.
+     * @param forward Axis of the mesh that should point along the velocity
+     * @return Rotation of the mesh
+     */
+    static glm::mat3 meshRotation(const glm::vec3& forward);
+
+    size_t size() const;
+    const glm::vec3& getMinimum() const;
+    const glm::vec3& getMaximum() const;
+    glm::vec3 getPosition(size_t index) const;
+    glm::vec3 getVelocity(size_t index) const;
+
+    /*!
+     * Get order the fish were added in, of every fish in the current state order
+     * @return Id of each fish
+     */
+    const std::vector<uint32_t>& ids() const;
+
+    /*!
+     * Get the average number of neighbours each fish perceived in the last step
+     * @return Neighbours per fish
+     */
+    float getAverageNeighbours() const;
+
+    Parameters parameters;
+
+private:
+    void sort();
+
+    glm::vec3 minimum, maximum;
+    int cells[3] = {1, 1, 1};
+    float inverseCell = 1.0f;
+
+    // Fish state in grid order
+    std::vector<float> px, py, pz, vx, vy, vz;
+    std::vector<uint32_t> fishIds;
+    // Sorting scratch, the next state and the grid
+    std::vector<float> nx, ny, nz, nvx, nvy, nvz;
+    std::vector<uint32_t> nextIds, cellOf, cellStart;
+    std::vector<glm::vec3> predators;
+    float averageNeighbours = 0.0f;
+};
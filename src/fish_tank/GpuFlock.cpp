@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <shaders/flock_count_comp_glsl.h>
+#include <shaders/flock_scan_comp_glsl.h>
+#include <shaders/flock_scatter_comp_glsl.h>
+#include <shaders/flock_step_comp_glsl.h>
+
+#include "GpuFlock.h"
+
+// Invocations per work group of the per fish passes
+const GLuint GROUP = 64;
+
+constexpr size_t GpuFlock::MAX_PREDATORS;
+
+bool GpuFlock::isSupported()
+{
+    return GLEW_VERSION_4_3 != 0;
+}
+
+GpuFlock::GpuFlock(const Flock& flock, const std::vector<float>& scales)
+    : parameters{flock.parameters}, minimum{flock.getMinimum()}, maximum{flock.getMaximum()}, scales{scales}
+{
+    if (!isSupported())
+        throw std::runtime_error("GpuFlock needs an OpenGL 4.3 context");
+
+    count = ppgso::ShaderCache::getCompute(flock_count_comp_glsl);
+    scan = ppgso::ShaderCache::getCompute(flock_scan_comp_glsl);
+    scatter = ppgso::ShaderCache::getCompute(flock_scatter_comp_glsl);
+    simulate = ppgso::ShaderCache::getCompute(flock_step_comp_glsl);
+
+    fishCount = flock.size();
+    auto bytes = (GLsizeiptr) (std::max<size_t>(fishCount, 1) * sizeof(Fish));
+    glGenBuffers(1, &stateBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, stateBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+    glGenBuffers(1, &sortedBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, sortedBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+    glGenBuffers(1, &slotBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, slotBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (std::max<size_t>(fishCount, 1) * sizeof(glm::uvec2)), nullptr,
+                 GL_DYNAMIC_COPY);
+    glGenBuffers(1, &statisticsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statisticsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+    // The grid is sized in step, its cell count follows the perception radius
+    glGenBuffers(1, &cellBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    upload(flock);
+}
+
+GpuFlock::~GpuFlock()
+{
+    glDeleteBuffers(1, &cellBuffer);
+    glDeleteBuffers(1, &statisticsBuffer);
+    glDeleteBuffers(1, &slotBuffer);
+    glDeleteBuffers(1, &sortedBuffer);
+    glDeleteBuffers(1, &stateBuffer);
+}
+
+void GpuFlock::upload(const Flock& flock)
+{
+    if (flock.size() != fishCount)
+        throw std::runtime_error("GpuFlock can only upload a flock of the size it was created for");
+
+    std::vector<Fish> state(fishCount);
+    auto& ids = flock.ids();
+    for (size_t i = 0; i < fishCount; i++)
+    {
+        auto id = ids[i];
+        auto scale = id < scales.size() ? scales[id] : 1.0f;
+        state[id] = {glm::vec4{flock.getPosition(i), scale}, glm::vec4{flock.getVelocity(i), 0.0f}};
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, stateBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) (fishCount * sizeof(Fish)), state.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuFlock::download(Flock& flock) const
+{
+    std::vector<Fish> state(fishCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, stateBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) (fishCount * sizeof(Fish)), state.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    std::vector<glm::vec3> positions, velocities;
+    positions.reserve(fishCount);
+    velocities.reserve(fishCount);
+    for (auto& fish : state)
+    {
+        positions.emplace_back(fish.position);
+        velocities.emplace_back(fish.velocity);
+    }
+    flock.assign(positions, velocities);
+}
+
+void GpuFlock::setPredators(const std::vector<glm::vec3>& positions)
+{
+    predators.assign(positions.begin(), positions.begin() + std::min(positions.size(), MAX_PREDATORS));
+}
+
+void GpuFlock::step(float dt, GLuint instanceBuffer, const glm::vec3& forward)
+{
+    if (!fishCount) return;
+
+    // Same grid as Flock::sort
+    auto inverseCell = 1.0f / parameters.perception;
+    auto extent = maximum - minimum;
+    glm::ivec3 grid;
+    for (int axis = 0; axis < 3; axis++)
+        grid[axis] = std::max(1, (int) std::ceil(extent[axis] * inverseCell));
+    auto cells = (size_t) grid.x * grid.y * grid.z;
+    if (cells + 1 > cellCapacity)
+    {
+        cellCapacity = cells + 1;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (cellCapacity * sizeof(GLuint)), nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statisticsBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, stateBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sortedBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, cellBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, slotBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, statisticsBuffer);
+    auto groups = (GLuint) ((fishCount + GROUP - 1) / GROUP);
+
+    // Counting sort by cell, every pass reads what the one before wrote
+    count->use();
+    glUniform1ui(count->getUniformLocation("Count"), (GLuint) fishCount);
+    glUniform3iv(count->getUniformLocation("Grid"), 1, glm::value_ptr(grid));
+    count->setUniform("Minimum", minimum);
+    count->setUniform("InverseCell", inverseCell);
+    glDispatchCompute(groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    scan->use();
+    glUniform1ui(scan->getUniformLocation("CellCount"), (GLuint) cells);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    scatter->use();
+    glUniform1ui(scatter->getUniformLocation("Count"), (GLuint) fishCount);
+    glDispatchCompute(groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    simulate->use();
+    glUniform1ui(simulate->getUniformLocation("Count"), (GLuint) fishCount);
+    glUniform3iv(simulate->getUniformLocation("Grid"), 1, glm::value_ptr(grid));
+    simulate->setUniform("Minimum", minimum);
+    simulate->setUniform("Maximum", maximum);
+    simulate->setUniform("InverseCell", inverseCell);
+    simulate->setUniform("TimeStep", dt);
+    simulate->setUniform("Perception", parameters.perception);
+    simulate->setUniform("Separation", parameters.separation);
+    simulate->setUniform("SeparationWeight", parameters.separationWeight);
+    simulate->setUniform("AlignmentWeight", parameters.alignmentWeight);
+    simulate->setUniform("CohesionWeight", parameters.cohesionWeight);
+    simulate->setUniform("PredatorRadius", parameters.predatorRadius);
+    simulate->setUniform("PredatorWeight", parameters.predatorWeight);
+    simulate->setUniform("WallMargin", parameters.wallMargin);
+    simulate->setUniform("WallWeight", parameters.wallWeight);
+    simulate->setUniform("MinSpeed", parameters.minSpeed);
+    simulate->setUniform("MaxSpeed", parameters.maxSpeed);
+    simulate->setUniform("MaxForce", parameters.maxForce);
+    simulate->setUniform("MeshRotation", Flock::meshRotation(forward));
+    glUniform1i(simulate->getUniformLocation("PredatorCount"), (GLint) predators.size());
+    if (!predators.empty())
+        glUniform3fv(simulate->getUniformLocation("Predators"), (GLsizei) predators.size(),
+                     glm::value_ptr(predators[0]));
+    glDispatchCompute(groups, 1, 1);
+
+    // The culling pass reads the matrices, statistics and download read the buffers back
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+float GpuFlock::getAverageNeighbours() const
+{
+    GLuint neighbours = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statisticsBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &neighbours);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return fishCount ? (float) neighbours / (float) fishCount : 0.0f;
+}
+
+size_t GpuFlock::size() const
+{
+    return fishCount;
+}
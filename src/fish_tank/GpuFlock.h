@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <ppgso/ppgso.h>
+#include "Flock.h"
+
+/*!
+ * Flock simulated in compute shaders, needs an OpenGL 4.3 context
+ *
+ * Fish state lives in shader storage buffers. Every step counting-sorts the fish by grid cell on the GPU
+ * (count, scan and scatter passes) and a last pass applies the rules of Flock::step, so both simulations
+ * can be compared. The step writes the model matrix of every fish straight into the instance buffer of
+ * a ppgso::InstanceCuller, nothing is read back unless asked for.
+ */
+class GpuFlock
+{
+public:
+    // Predators beyond this are ignored, the shader gets them as a uniform array
+    static constexpr size_t MAX_PREDATORS = 16;
+
+    /*!
+     * Check whether the context can run the simulation
+     * @return True for OpenGL 4.3 and newer
+     */
+    static bool isSupported();
+
+    /*!
+     * Create buffers for a flock and upload its fish, parameters and box are taken from it
+     * @param flock Flock to copy
+     * @param scales Uniform scale of each fish in the order the fish were added in, 1 when empty
+     */
+    GpuFlock(const Flock& flock, const std::vector<float>& scales);
+
+    ~GpuFlock();
+
+    GpuFlock(const GpuFlock&) = delete;
+    GpuFlock& operator=(const GpuFlock&) = delete;
+
+    /*!
+     * Replace the state of all fish with the state of a CPU flock of the same size
+     * @param flock Flock to copy
+     */
+    void upload(const Flock& flock);
+
+    /*!
+     * Read the state back into a CPU flock, waits for the GPU
+     * @param flock Flock to overwrite
+     */
+    void download(Flock& flock) const;
+
+    /*!
+     * Set predators the fish flee from in the next steps
+     * @param positions World positions of the predators, at most MAX_PREDATORS are used
+     */
+    void setPredators(const std::vector<glm::vec3>& positions);
+
+    /*!
+     * Advance the simulation and write the model matrices
+     * @param dt Time step in seconds
+     * @param instanceBuffer Storage buffer receiving a model matrix per fish, in the order the fish were added in
+     * @param forward Axis of the mesh that should point along the velocity
+     */
+    void step(float dt, GLuint instanceBuffer, const glm::vec3& forward);
+
+    /*!
+     * Get the average number of neighbours each fish perceived in the last step, waits for the GPU
+     * @return Neighbours per fish
+     */
+    float getAverageNeighbours() const;
+
+    size_t size() const;
+
+    Flock::Parameters parameters;
+
+private:
+    struct Fish
+    {
+        glm::vec4 position;
+        glm::vec4 velocity;
+    };
+
+    std::shared_ptr<ppgso::Shader> count, scan, scatter, simulate;
+    glm::vec3 minimum, maximum;
+    std::vector<float> scales;
+    std::vector<glm::vec3> predators;
+    GLuint stateBuffer = 0, sortedBuffer = 0, cellBuffer = 0, slotBuffer = 0, statisticsBuffer = 0;
+    size_t fishCount = 0, cellCapacity = 0;
+};
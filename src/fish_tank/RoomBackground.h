@@ -9,9 +9,9 @@
 class RoomBackground final : public Object {
 private:
     // Static resources shared between all instances
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Texture> texture;
 
 public:
     /*!
@@ -6,28 +6,33 @@
 #include <shaders/diffuse_vert_glsl.h>
 #include <shaders/diffuse_frag_glsl.h>
 
+#include <glm/gtx/euler_angles.hpp>
+
 // Static resources
-std::unique_ptr<ppgso::Mesh> Shark::mesh;
-std::unique_ptr<ppgso::Shader> Shark::shader;
-std::unique_ptr<ppgso::Texture> Shark::texture;
+std::shared_ptr<ppgso::Mesh> Shark::mesh;
+std::shared_ptr<ppgso::Shader> Shark::shader;
+std::shared_ptr<ppgso::Texture> Shark::texture;
+std::shared_ptr<ppgso::AnimationClip> Shark::clip;
 
 Shark::Shark (bool keyframeAnimationActivated)
 {
     // Load shared resources if not already loaded
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("shark.gltf");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/shark.bmp"));
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+    if (!mesh) mesh = ppgso::MeshCache::get("shark.gltf", LOD_LEVELS);
+    if (!texture) texture = ppgso::TextureCache::get("textures/shark.bmp");
+    if (!clip) clip = createClip();
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
     scale = glm::vec3(10.0f, 10.0f, 10.0f);
     rotation = glm::ballRand(ppgso::PI);
     rotMomentum = glm::ballRand(ppgso::PI);
 
     speed = {glm::linearRand(-0.05f, 0.05f), glm::linearRand(-1.0f, 2.0f), glm::linearRand(-25.0f, 25.0f)};
 
-        generateKeyframes();
-
-        // Initialize shark position and rotation
-        currentPosition = keyframes.front().position;
-        currentRotation = keyframes.front().rotation;
+    // Sharks spread along the path instead of swimming on top of each other
+    elapsedTime = glm::linearRand(0.0f, clip->getDuration());
+    updateAnimation(0.0f);
 
     // Set up VAO, VBO, etc. (model loading skipped here)
 }
@@ -51,7 +56,7 @@ bool Shark::update(Scene& scene, float dt)
     // }
 
     shader->use();
-    generateModelMatrix();
+    selectLod(scene, mesh->getRadius(), mesh->getLodCount());
     return true;
 }
 
@@ -68,7 +73,7 @@ void Shark::render(Scene& scene)
     shader->setUniform("Texture", *texture);
 
     // Render the mesh
-    mesh->render();
+    mesh->render(lod);
 }
 
 void Shark::chase(const glm::vec3& preyPosition, float chaseSpeed, float dt)
@@ -84,48 +89,30 @@ void Shark::chase(const glm::vec3& preyPosition, float chaseSpeed, float dt)
     }
 }
 
-void Shark::generateKeyframes()
+std::shared_ptr<ppgso::AnimationClip> Shark::createClip()
 {
-    // Define a circular animation path
-    keyframes = {
-        {{-10.0f, 5.0f, -10.0f}, {0.0f, 0.0f, 0.0f}, 0.0f},
-        {{0.0f, 6.0f, -5.0f}, {0.0f, glm::radians(45.0f), 0.0f}, 2.0f},
-        {{10.0f, 4.0f, 0.0f}, {0.0f, glm::radians(90.0f), 0.0f}, 4.0f},
-        {{5.0f, 3.0f, 5.0f}, {0.0f, glm::radians(135.0f), 0.0f}, 6.0f},
-        {{-5.0f, 5.0f, 10.0f}, {0.0f, glm::radians(180.0f), 0.0f}, 8.0f},
-        {{-10.0f, 5.0f, -10.0f}, {0.0f, glm::radians(360.0f), 0.0f}, 10.0f} // Back to start
+    // Define a circular animation path, rotations less than half a turn apart so slerp turns the same way
+    auto yaw = [](float degrees)
+    {
+        return glm::quat_cast(glm::orientate3(glm::vec3{0.0f, glm::radians(degrees), 0.0f}));
     };
+    return std::make_shared<ppgso::AnimationClip>(std::vector<ppgso::AnimationClip::Key>{
+        {0.0f, {-10.0f, 5.0f, -10.0f}, yaw(0.0f)},
+        {2.0f, {0.0f, 6.0f, -5.0f}, yaw(45.0f)},
+        {4.0f, {10.0f, 4.0f, 0.0f}, yaw(90.0f)},
+        {6.0f, {5.0f, 3.0f, 5.0f}, yaw(135.0f)},
+        {8.0f, {-5.0f, 5.0f, 10.0f}, yaw(180.0f)},
+        {9.0f, {-7.5f, 5.0f, 0.0f}, yaw(270.0f)},
+        {10.0f, {-10.0f, 5.0f, -10.0f}, yaw(360.0f)} // Back to start
+    }, true);
 }
 
 void Shark::updateAnimation(float dt)
 {
-    elapsedTime += dt;
-
-    // Loop animation
-    float totalTime = keyframes.back().time;
-    elapsedTime = fmod(elapsedTime, totalTime);
-
-    // Find the two keyframes to interpolate between
-    Keyframe* k1 = nullptr;
-    Keyframe* k2 = nullptr;
-
-    for (size_t i = 0; i < keyframes.size() - 1; ++i)
-    {
-        if (elapsedTime >= keyframes[i].time && elapsedTime < keyframes[i + 1].time)
-        {
-            k1 = &keyframes[i];
-            k2 = &keyframes[i + 1];
-            break;
-        }
-    }
-
-    if (!k1 || !k2) return;
-
-    // Calculate interpolation factor
-    float t = (elapsedTime - k1->time) / (k2->time - k1->time);
-    currentPosition = glm::mix(k1->position, k2->position, t);
-    currentRotation = glm::mix(k1->rotation, k2->rotation, t);
+    // Keep the time within the loop so it never loses precision
+    elapsedTime = std::fmod(elapsedTime + dt, clip->getDuration());
+    auto pose = clip->sample(elapsedTime, clipSegment);
 
-    position = currentPosition;
-    rotation = currentRotation;
+    position = pose.position;
+    modelMatrix = ppgso::AnimationClip::modelMatrix(pose, scale);
 }
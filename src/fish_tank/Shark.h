@@ -15,26 +15,18 @@ class Shark final : public Object
 {
 private:
     // Static resources shared across instances
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Texture> texture;
 
-    struct Keyframe
-    {
-        glm::vec3 position;
-        glm::vec3 rotation;
-        float time; // Timestamp in seconds
-    };
+    static std::shared_ptr<ppgso::AnimationClip> clip; // Swimming path all sharks follow
 
-    std::vector<Keyframe> keyframes; // Animation keyframes
-    float elapsedTime = 0.0f; // Time elapsed since the animation started
-
-    glm::vec3 currentPosition;
-    glm::vec3 currentRotation;
+    float elapsedTime = 0.0f; // Time into the clip, starts at a random offset per shark
+    size_t clipSegment = 0;   // Segment of the last sample, see AnimationClip::sample
 
     GLuint vao, vbo, ebo;
 
-    void generateKeyframes(); // Define keyframes for animation
+    static std::shared_ptr<ppgso::AnimationClip> createClip(); // Define keyframes for animation
     void updateAnimation(float dt);
 
 public:
@@ -3,15 +3,21 @@
 #include <shaders/texture_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> WaterBackground::mesh;
-std::unique_ptr<ppgso::Shader> WaterBackground::shader;
-std::unique_ptr<ppgso::Texture> WaterBackground::texture;
+std::shared_ptr<ppgso::Mesh> WaterBackground::mesh;
+std::shared_ptr<ppgso::Shader> WaterBackground::shader;
+std::shared_ptr<ppgso::Texture> WaterBackground::texture;
 
 WaterBackground::WaterBackground() {
     // Initialize static resources
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("water_background.bmp"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("quad.obj"); // A flat square covering [-1, 1] range
+    if (!shader) shader = ppgso::ShaderCache::get(texture_vert_glsl, texture_frag_glsl);
+    if (!texture) texture = ppgso::TextureCache::get("water_background.bmp", ppgso::Texture::Format::RGB8, ppgso::Texture::Streamed);
+    if (!mesh) mesh = ppgso::MeshCache::get("quad.obj"); // A flat square covering [-1, 1] range
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
+
+    // Drawn first without depth writes so the background stays behind all objects
+    blending = Blending::Background;
 }
 
 bool WaterBackground::update(Scene &scene, float dt) {
@@ -20,9 +26,6 @@ bool WaterBackground::update(Scene &scene, float dt) {
 }
 
 void WaterBackground::render(Scene &scene) {
-    // Disable depth writing to ensure the background stays behind all objects
-    glDepthMask(GL_FALSE);
-
     shader->use();
 
     // Use orthographic projection to render the background as a flat quad
@@ -35,7 +38,4 @@ void WaterBackground::render(Scene &scene) {
 
     // Render the quad
     mesh->render();
-
-    // Re-enable depth writing
-    glDepthMask(GL_TRUE);
 }
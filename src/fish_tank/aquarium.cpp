@@ -4,22 +4,29 @@
 
 #include "aquarium.h"
 #include <shaders/diffuse_vert_glsl.h>
-#include <shaders/diffuse_transparent_frag_glsl.h>
+#include <shaders/diffuse_frag_glsl.h>
 
 #include "table.h"
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Aquarium::mesh;
-std::unique_ptr<ppgso::Shader> Aquarium::shader;
-std::unique_ptr<ppgso::Texture> Aquarium::texture;
+std::shared_ptr<ppgso::Mesh> Aquarium::mesh;
+std::shared_ptr<ppgso::Shader> Aquarium::shader;
+std::shared_ptr<ppgso::Texture> Aquarium::texture;
 
 Aquarium::Aquarium(Object* tableRef) : table(tableRef) {
     // Load shared resources if not already loaded
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_transparent_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("aquarium.gltf");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/glass.bmp"));
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl,
+                                                  ppgso::Shader::PointLight | ppgso::Shader::Transparent);
+    if (!mesh) mesh = ppgso::MeshCache::get("aquarium.gltf");
+    if (!texture) texture = ppgso::TextureCache::get("textures/glass.bmp");
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
     scale = glm::vec3(0.7f, 0.7f, 0.7f);
     table = tableRef;
+
+    // Glass is drawn in the sorted transparency pass of the scene
+    blending = Blending::Alpha;
 }
 
 bool Aquarium::update(Scene& scene, float dt)
@@ -37,10 +44,6 @@ bool Aquarium::update(Scene& scene, float dt)
 
 void Aquarium::render(Scene& scene)
 {
-    // Enable alpha blending for transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard alpha blending
-
     shader->use();
 
     // Set light uniforms
@@ -61,7 +64,4 @@ void Aquarium::render(Scene& scene)
 
     // Render the mesh
     mesh->render();
-
-    // Disable blending after rendering the transparent object
-    glDisable(GL_BLEND);
 }
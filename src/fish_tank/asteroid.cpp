@@ -7,9 +7,9 @@
 
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Asteroid::mesh;
-std::unique_ptr<ppgso::Texture> Asteroid::texture;
-std::unique_ptr<ppgso::Shader> Asteroid::shader;
+std::shared_ptr<ppgso::Mesh> Asteroid::mesh;
+std::shared_ptr<ppgso::Texture> Asteroid::texture;
+std::shared_ptr<ppgso::Shader> Asteroid::shader;
 
 Asteroid::Asteroid() {
   // Set random scale speed and rotation
@@ -19,9 +19,12 @@ Asteroid::Asteroid() {
   rotMomentum = glm::ballRand(ppgso::PI);
 
   // Initialize static resources if needed
-  if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/asteroid.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("asteroid.obj");
+  if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+  if (!texture) texture = ppgso::TextureCache::get("textures/asteroid.bmp");
+  if (!mesh) mesh = ppgso::MeshCache::get("asteroid.obj");
+  renderShader = shader.get();
+  renderTexture = texture.get();
+  renderMesh = mesh.get();
 }
 
 bool Asteroid::update(Scene &scene, float dt) {
@@ -7,16 +7,19 @@
 #include <shaders/diffuse_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Bubble::mesh;
-std::unique_ptr<ppgso::Shader> Bubble::shader;
-std::unique_ptr<ppgso::Texture> Bubble::texture;
+std::shared_ptr<ppgso::Mesh> Bubble::mesh;
+std::shared_ptr<ppgso::Shader> Bubble::shader;
+std::shared_ptr<ppgso::Texture> Bubble::texture;
 
 Bubble::Bubble()
 {
     // Load shared resources if not already loaded
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("sphere.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/ocean.bmp"));
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl, ppgso::Shader::Transparent);
+    if (!mesh) mesh = ppgso::MeshCache::get("sphere.obj");
+    if (!texture) texture = ppgso::TextureCache::get("textures/ocean.bmp");
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
     lifetime = glm::linearRand(1.0f, 6.0f);
     age = 0.0f;
 
@@ -24,12 +27,13 @@ Bubble::Bubble()
     speed = {0.0, glm::linearRand(-3.0f, 3.0f), glm::linearRand(-0.5f, 0.5f)};
 
     buoyantForce *= scale.y;
+
+    // Bubbles are see-through, drawn in the sorted transparency pass of the scene
+    blending = Blending::Alpha;
 }
 
 bool Bubble::update(Scene& scene, float dt)
 {
-    shader->use();
-
     // Apply gravity and boyount force (downward force)
     speed.y += gravity * dt;
     speed.y += buoyantForce * dt;
@@ -61,6 +65,7 @@ void Bubble::render(Scene& scene)
     shader->setUniform("ModelMatrix", modelMatrix);
 
     shader->setUniform("Texture", *texture);
+    shader->setUniform("Transparency", 0.6f);
 
     // Render the mesh
     mesh->render();
@@ -6,9 +6,9 @@
 #include <shaders/texture_frag_glsl.h>
 
 // static resources
-std::unique_ptr<ppgso::Mesh> Explosion::mesh;
-std::unique_ptr<ppgso::Texture> Explosion::texture;
-std::unique_ptr<ppgso::Shader> Explosion::shader;
+std::shared_ptr<ppgso::Mesh> Explosion::mesh;
+std::shared_ptr<ppgso::Texture> Explosion::texture;
+std::shared_ptr<ppgso::Shader> Explosion::shader;
 
 Explosion::Explosion() {
   // Random rotation and momentum
@@ -16,10 +16,16 @@ Explosion::Explosion() {
   rotMomentum = glm::ballRand(ppgso::PI)*3.0f;
   speed = {0.0f, 0.0f, 0.0f};
 
+  // Additive blending, drawn after all sorted transparent objects
+  blending = Blending::Additive;
+
   // Initialize static resources if needed
-  if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("explosion.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("table.obj");
+  if (!shader) shader = ppgso::ShaderCache::get(texture_vert_glsl, texture_frag_glsl);
+  if (!texture) texture = ppgso::TextureCache::get("explosion.bmp");
+  if (!mesh) mesh = ppgso::MeshCache::get("table.obj");
+  renderShader = shader.get();
+  renderTexture = texture.get();
+  renderMesh = mesh.get();
 }
 
 void Explosion::render(Scene &scene) {
@@ -36,20 +42,7 @@ void Explosion::render(Scene &scene) {
   shader->setUniform("ModelMatrix", modelMatrix);
   shader->setUniform("Texture", *texture);
 
-  // Disable depth testing
-  glDisable(GL_DEPTH_TEST);
-
-  // Enable blending
-  glEnable(GL_BLEND);
-  // Additive blending
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-
   mesh->render();
-
-  // Disable blending
-  glDisable(GL_BLEND);
-  // Enable depth test
-  glEnable(GL_DEPTH_TEST);
 }
 
 bool Explosion::update(Scene &scene, float dt) {
@@ -4,6 +4,12 @@
 
 #include <ppgso/ppgso.h>
 
+#include <shaders/post_vert_glsl.h>
+#include <shaders/post_bright_frag_glsl.h>
+#include <shaders/post_bloom_frag_glsl.h>
+#include <shaders/post_underwater_frag_glsl.h>
+#include <shaders/post_grayscale_frag_glsl.h>
+
 #include "RoomBackground.h"
 #include "table.h"
 #include "camera.h"
@@ -17,9 +23,13 @@
 #include "WaterBackground.h"
 #include "bubble.h"
 #include "Shark.h"
+#include "FishSchool.h"
 #define NUMBER_OF_FISH_1 20
 #define NUMBER_OF_FISH_2 15
 #define NUMBER_OF_SHARK 5
+// Fish of the background school, drawing them one by one without GPU culling limits the count
+#define NUMBER_OF_SCHOOL_FISH 20000
+#define NUMBER_OF_SCHOOL_FISH_CPU 500
 
 const unsigned int SIZE = 768;
 
@@ -36,6 +46,42 @@ private:
 
     // Camera movement state
     glm::vec3 cameraMovement = {0.0f, 0.0f, 0.0f};
+
+    // Screen space effects, run once per pixel after the scene instead of in the material shaders
+    std::unique_ptr<ppgso::Convolution> bloomBlur = ppgso::Convolution::gaussian(2.0f);
+    ppgso::PostChain postChain;
+    std::vector<size_t> bloomPasses;
+    size_t underwaterPass = 0;
+    size_t grayscalePass = 0;
+    bool bloom = true;
+    bool grayscale = false;
+
+    // Background school of the second scene, owned by the scene objects
+    FishSchool* school = nullptr;
+
+    /*!
+     * Set up the post-processing passes
+     * Bloom extracts and blurs the bright parts at half resolution and adds them back to the scene
+     */
+    void initPostChain()
+    {
+        bloomPasses.push_back(postChain.add(ppgso::ShaderCache::get(post_vert_glsl, post_bright_frag_glsl), 0.5f,
+                                            [](const ppgso::Shader& shader) { shader.setUniform("Threshold", 0.7f); }));
+        for (auto pass : bloomBlur->addTo(postChain, 0.5f))
+            bloomPasses.push_back(pass);
+        bloomPasses.push_back(postChain.add(ppgso::ShaderCache::get(post_vert_glsl, post_bloom_frag_glsl), 1.0f,
+                                            [](const ppgso::Shader& shader) { shader.setUniform("Intensity", 0.8f); }));
+
+        underwaterPass = postChain.add(ppgso::ShaderCache::get(post_vert_glsl, post_underwater_frag_glsl), 1.0f,
+                                       [](const ppgso::Shader& shader)
+                                       {
+                                           shader.setUniform("Time", (float)glfwGetTime());
+                                           shader.setUniform("Tint", glm::vec3{0.3f, 0.7f, 0.9f});
+                                       });
+
+        grayscalePass = postChain.add(ppgso::ShaderCache::get(post_vert_glsl, post_grayscale_frag_glsl), 1.0f,
+                                      [](const ppgso::Shader& shader) { shader.setUniform("Strength", 1.0f); });
+    }
     /*!
      * Reset and initialize the first scene
      * Creating unique smart pointers to objects that are stored in the scene object list
@@ -43,6 +89,7 @@ private:
     void initScene()
     {
         scene.objects.clear();
+        school = nullptr;
 
         // Light Direction
         scene.lightDirection = {-20.0f, 0.0f, 1.5f};
@@ -134,6 +181,12 @@ private:
             scene.objects.push_back(std::move(shark));
         }
 
+        auto schoolSize = ppgso::InstanceCuller::isSupported() ? NUMBER_OF_SCHOOL_FISH : NUMBER_OF_SCHOOL_FISH_CPU;
+        auto fishSchool = std::make_unique<FishSchool>(schoolSize, glm::vec3{0.0f, 0.0f, 0.0f},
+                                                       glm::vec3{40.0f, 20.0f, 60.0f});
+        school = fishSchool.get();
+        scene.objects.push_back(std::move(fishSchool));
+
         for (int i = 0; i < 5; i++)
         {
             auto bubble = std::make_unique<Bubble>();
@@ -164,18 +217,32 @@ public:
         glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
 
         // Initialize OpenGL state
-        glEnable(GL_DEPTH_TEST);
+        ppgso::RenderState::setEnabled(GL_DEPTH_TEST, true);
         glDepthFunc(GL_LEQUAL);
-        glEnable(GL_CULL_FACE);
+        ppgso::RenderState::setEnabled(GL_CULL_FACE, true);
         glFrontFace(GL_CCW);
         glCullFace(GL_BACK);
 
+        initPostChain();
+
         initScene();
 
         createFirstScene();
         // createSecondScene();
     }
 
+    /*!
+     * Print a single resource cache summary line
+     * @param name Resource type label
+     * @param stats Cache statistics to print
+     */
+    template<typename Stats>
+    static void printCacheStats(const char* name, const Stats& stats)
+    {
+        std::cout << name << ": " << stats.entries << " loaded, " << stats.bytes / 1024 << " KiB, "
+            << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evicted" << std::endl;
+    }
+
     /*!
      * Handles pressed key when the window is focused
      * @param key Key code of the key being pressed/released
@@ -205,6 +272,52 @@ public:
             scene.transitionToNextScene = true; // Start the transition
         }
 
+        // Print shared resource usage
+        if (key == GLFW_KEY_I && action == GLFW_PRESS)
+        {
+            printCacheStats("Textures", ppgso::TextureCache::instance().stats());
+            printCacheStats("Meshes", ppgso::MeshCache::instance().stats());
+            printCacheStats("Shaders", ppgso::ShaderCache::instance().stats());
+            auto& targets = ppgso::RenderTargetPool::instance();
+            std::cout << "Render targets: " << targets.size() << " pooled, " << targets.getByteSize() / 1024 << " KiB"
+                << std::endl;
+            auto frame = ppgso::RenderState::lastFrame();
+            std::cout << "State changes: " << frame.changes() << " last frame (" << frame.programs << " programs, "
+                << frame.textures << " textures, " << frame.vertexArrays << " vertex arrays, " << frame.states
+                << " states), " << frame.skipped << " redundant skipped" << std::endl;
+            std::cout << "Mesh draws: " << frame.drawCalls << " draw calls, " << frame.triangles << " triangles last frame"
+                << std::endl;
+            if (school)
+            {
+                std::cout << "Fish school (" << (school->isGpuCulled() ? "GPU" : "CPU") << " culling): ";
+                for (auto count : school->getVisible())
+                    std::cout << count << " ";
+                std::cout << "visible per level" << std::endl;
+                std::cout << "Fish school (" << (school->isGpuSimulated() ? "GPU" : "CPU") << " simulation): "
+                    << school->getAverageNeighbours() << " neighbours per fish" << std::endl;
+            }
+            auto programs = ppgso::ProgramCache::stats();
+            std::cout << "Program binaries: " << programs.loaded << " loaded, " << programs.compiled << " compiled, "
+                << programs.stored << " stored, " << programs.rejected << " rejected" << std::endl;
+        }
+
+        // Switch the fish school between the CPU and the compute shader simulation
+        if (key == GLFW_KEY_C && action == GLFW_PRESS && school)
+        {
+            if (!school->setGpuSimulated(!school->isGpuSimulated()))
+                std::cout << "GPU fish simulation needs OpenGL 4.3" << std::endl;
+        }
+
+        // Toggle post-processing effects
+        if (key == GLFW_KEY_B && action == GLFW_PRESS)
+        {
+            bloom = !bloom;
+        }
+        if (key == GLFW_KEY_G && action == GLFW_PRESS)
+        {
+            grayscale = !grayscale;
+        }
+
         // Camera movement
         if (action == GLFW_PRESS || action == GLFW_RELEASE)
         {
@@ -305,6 +418,14 @@ public:
             scene.camera->back = glm::normalize(scene.camera->position - glm::vec3{0.0f, 0.0f, 0.0f});
             scene.camera->update();
         }
+        // Continue uploading large textures in slices instead of stalling on a single upload
+        ppgso::TextureCache::stream(4 << 20);
+
+        // Render the scene offscreen, the post chain presents it
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        postChain.begin(framebufferWidth, framebufferHeight);
+
         // Set gray background
         glClearColor(.5f, .5f, .5f, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -317,6 +438,14 @@ public:
         }
 
         scene.render();
+
+        // Apply screen space effects, the underwater tint only makes sense inside the tank
+        for (auto pass : bloomPasses)
+            postChain.setEnabled(pass, bloom);
+        postChain.setEnabled(underwaterPass, scene.sceneIndex >= 1);
+        postChain.setEnabled(grayscalePass, grayscale);
+        postChain.end();
+        ppgso::RenderState::endFrame();
     }
 
     void spawnAsteroids(Scene& scene, int count, float groundMin, float groundMax, float groundHeight) {
@@ -340,6 +469,11 @@ public:
 
 int main()
 {
+    // Reuse program binaries of earlier launches, the window already compiles shaders while constructed
+    ppgso::ProgramCache::setDirectory("shader_cache");
+    // Reorder mesh indices for the vertex cache as the models are loaded
+    ppgso::MeshOptimizer::setEnabled(true);
+
     // Initialize our window
     SceneWindow window;
 
@@ -5,27 +5,30 @@
 #include <shaders/advanced_material_vert_glsl.h>
 #include <shaders/advanced_material_frag_glsl.h>
 
-
-#include <shaders/diffuse_vert_glsl.h>
-#include <shaders/diffuse_frag_glsl.h>
+// Shader features of the lamp, it shows its base color unlit
+// Lighting | NormalMap | PointLight shades it with all of its textures
+const int LAMP_FEATURES = 0;
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Lamp::mesh;
-std::unique_ptr<ppgso::Shader> Lamp::shader;
-std::unique_ptr<ppgso::Texture> Lamp::baseColor;
-std::unique_ptr<ppgso::Texture> Lamp::metallicRoughness;
-std::unique_ptr<ppgso::Texture> Lamp::normalMap;
+std::shared_ptr<ppgso::Mesh> Lamp::mesh;
+std::shared_ptr<ppgso::Shader> Lamp::shader;
+std::shared_ptr<ppgso::Texture> Lamp::baseColor;
+std::shared_ptr<ppgso::Texture> Lamp::metallicRoughness;
+std::shared_ptr<ppgso::Texture> Lamp::normalMap;
 
 Lamp::Lamp()
 {
-    if (!shader) shader = std::make_unique<ppgso::Shader>(advanced_material_vert_glsl, advanced_material_frag_glsl);
-    if (!baseColor) baseColor = std::make_unique<ppgso::Texture>(
-        ppgso::image::loadBMP("textures/desk-light_baseColor.bmp"));
-    if (!metallicRoughness) metallicRoughness = std::make_unique<ppgso::Texture>(
-        ppgso::image::loadBMP("textures/desk-light_metallicRoughness.bmp"));
-    if (!normalMap) normalMap = std::make_unique<ppgso::Texture>(
-        ppgso::image::loadBMP("textures/desk-light_normal.bmp"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("lamp.gltf");
+    if (!shader) shader = ppgso::ShaderCache::get(advanced_material_vert_glsl, advanced_material_frag_glsl, LAMP_FEATURES);
+    if (!baseColor) baseColor = ppgso::TextureCache::get("textures/desk-light_baseColor.bmp");
+    // Textures the chosen permutation never samples are not loaded at all
+    if (!metallicRoughness && (LAMP_FEATURES & ppgso::Shader::PointLight))
+        metallicRoughness = ppgso::TextureCache::get("textures/desk-light_metallicRoughness.bmp");
+    if (!normalMap && (LAMP_FEATURES & ppgso::Shader::NormalMap))
+        normalMap = ppgso::TextureCache::get("textures/desk-light_normal.bmp");
+    if (!mesh) mesh = ppgso::MeshCache::get("lamp.gltf");
+    renderShader = shader.get();
+    renderTexture = baseColor.get();
+    renderMesh = mesh.get();
 
     scale = glm::vec3(0.04f, 0.04f, 0.04f);;
     rotation.x = glm::radians(-45.0f);
@@ -58,11 +61,19 @@ void Lamp::render(Scene& scene)
     // Use the shader
     shader->use();
 
-    // Set up light direction
-    shader->setUniform("LightDirection", scene.lightDirection);
+    // Set up lights
+    if (LAMP_FEATURES & ppgso::Shader::Lighting)
+        shader->setUniform("LightDirection", scene.lightDirection);
+    if (LAMP_FEATURES & ppgso::Shader::PointLight)
+    {
+        shader->setUniform("LightPosition", scene.lightSources.back());
+        shader->setUniform("LightColor", glm::vec3(1.0f, 1.0f, 0.9f)); // Warm light color
+        shader->setUniform("CameraPosition", scene.camera->position);
+        shader->setUniform("MetallicRoughnessTexture", *metallicRoughness, 1);
+    }
+    if (LAMP_FEATURES & ppgso::Shader::NormalMap)
+        shader->setUniform("NormalMapTexture", *normalMap, 2);
 
-    shader->setUniform("LightPosition", scene.lightSources.back());
-    shader->setUniform("LightColor", glm::vec3(1.0f, 1.0f, 0.9f)); // Warm light color
     // Set up camera matrices
     shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
     shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
@@ -70,10 +81,6 @@ void Lamp::render(Scene& scene)
     // Set the model transformation matrix
     shader->setUniform("ModelMatrix", modelMatrix);
 
-    shader->setUniform("UseSimpleTexture", false);
-
-    shader->setUniform("MetallicRoughnessTexture", *metallicRoughness);
-    shader->setUniform("NormalMapTexture", *normalMap);
     shader->setUniform("BaseColorTexture", *baseColor);
 
     // Render the mesh
@@ -15,11 +15,11 @@
 class Lamp final : public Object {
 private:
  float elapsedTime = 0.0f; // Accumulator for movement
- static std::unique_ptr<ppgso::Mesh> mesh;
- static std::unique_ptr<ppgso::Shader> shader;
- static std::unique_ptr<ppgso::Texture> baseColor;
- static std::unique_ptr<ppgso::Texture> metallicRoughness;
- static std::unique_ptr<ppgso::Texture> normalMap;
+ static std::shared_ptr<ppgso::Mesh> mesh;
+ static std::shared_ptr<ppgso::Shader> shader;
+ static std::shared_ptr<ppgso::Texture> baseColor;
+ static std::shared_ptr<ppgso::Texture> metallicRoughness;
+ static std::shared_ptr<ppgso::Texture> normalMap;
 
 public:
  // Position of the light coming out of the lamp
@@ -4,7 +4,18 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+
 #include "object.h"
+#include "scene.h"
+
+namespace {
+  // Projected sizes below which the next coarser level is used
+  const float LOD_THRESHOLDS[] = {0.3f, 0.12f, 0.05f};
+  const float LOD_HYSTERESIS = 0.15f;
+}
+
+const int Object::LOD_LEVELS;
 
 void Object::generateModelMatrix() {
   modelMatrix =
@@ -12,3 +23,19 @@ void Object::generateModelMatrix() {
           * glm::orientate4(rotation)
           * glm::scale(glm::mat4(1.0f), scale);
 }
+
+void Object::selectLod(const Scene& scene, float meshRadius, size_t lodCount) {
+  lod = stepLod(scene, position, meshRadius * std::max(std::max(scale.x, scale.y), scale.z), lodCount, lod);
+}
+
+size_t Object::stepLod(const Scene& scene, const glm::vec3& center, float radius, size_t lodCount, size_t current) {
+  auto &camera = *scene.camera;
+  auto depth = std::max(-(camera.viewMatrix * glm::vec4{center, 1.0f}).z, 0.001f);
+  auto projected = radius * camera.projectionMatrix[1][1] / depth;
+
+  auto levels = std::max<size_t>(std::min(lodCount, sizeof(LOD_THRESHOLDS) / sizeof(LOD_THRESHOLDS[0]) + 1), 1);
+  auto lod = std::min(current, levels - 1);
+  while (lod + 1 < levels && projected < LOD_THRESHOLDS[lod] * (1.0f - LOD_HYSTERESIS)) lod++;
+  while (lod > 0 && projected > LOD_THRESHOLDS[lod - 1] * (1.0f + LOD_HYSTERESIS)) lod--;
+  return lod;
+}
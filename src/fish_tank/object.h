@@ -8,6 +8,11 @@
 // Forward declare a scene
 class Scene;
 
+namespace ppgso {
+    class Shader;
+    class Texture;
+}
+
 /*!
  *  Abstract scene object interface
  *  All objects in the scene should be able to update and render
@@ -27,6 +32,25 @@ public:
 
     float boundingRadius = 0.5f; // Radius for collision detection
 
+    /*!
+     * How the object is composited, Scene::render hands it to the matching pass of its render queue
+     * Objects must not change blending or depth writes themselves
+     */
+    enum class Blending
+    {
+        Background, // No depth writes, drawn first in list order
+        Opaque,     // Writes depth, grouped by shader, texture and mesh
+        Alpha,      // Standard alpha blending, sorted back to front by view depth
+        Additive    // Order independent, drawn after the sorted objects
+    };
+
+    Blending blending = Blending::Opaque;
+
+    // Resources the render queue groups draws by, set by objects next to their shared resources
+    const ppgso::Shader* renderShader = nullptr;
+    const ppgso::Texture* renderTexture = nullptr;
+    const void* renderMesh = nullptr;
+
     /*!
      * Update Object parameters, usually used to update the modelMatrix based on position, scale and rotation
      *
@@ -57,9 +81,37 @@ public:
     glm::vec3 scale{1, 1, 1};
     glm::mat4 modelMatrix{1};
 
+    // Level of detail objects with simplified meshes draw, 0 is the full mesh
+    size_t lod = 0;
+
+    // Levels fish and sharks load their meshes with, one per threshold of selectLod and the full mesh
+    static const int LOD_LEVELS = 4;
+
 protected:
     /*!
      * Generate modelMatrix from position, rotation and scale
      */
     void generateModelMatrix();
+
+    /*!
+     * Pick lod from the projected size of the object, half the screen height is 1
+     * A level changes only once the size passes its threshold by the hysteresis margin, so it does not flicker.
+     *
+     * @param scene - Scene with the camera
+     * @param meshRadius - Bounding radius of the mesh, scaled by the largest scale component
+     * @param lodCount - Levels the mesh has
+     */
+    void selectLod(const Scene& scene, float meshRadius, size_t lodCount);
+
+    /*!
+     * Level of detail for a bounding sphere, the rule selectLod applies to the object itself
+     *
+     * @param scene - Scene with the camera
+     * @param center - World position of the sphere
+     * @param radius - World radius of the sphere
+     * @param lodCount - Levels the mesh has
+     * @param current - Level used so far
+     * @return New level
+     */
+    static size_t stepLod(const Scene& scene, const glm::vec3& center, float radius, size_t lodCount, size_t current);
 };
@@ -132,9 +132,32 @@ void Scene::update(float time)
 
 void Scene::render()
 {
-    // Simply render all objects
     for (auto& obj : objects)
-        obj->render(*this);
+    {
+        ppgso::RenderQueue::Pass pass;
+        switch (obj->blending)
+        {
+        case Object::Blending::Background:
+            pass = ppgso::RenderQueue::Pass::Background;
+            break;
+        case Object::Blending::Opaque:
+            pass = ppgso::RenderQueue::Pass::Opaque;
+            break;
+        case Object::Blending::Alpha:
+            pass = ppgso::RenderQueue::Pass::Alpha;
+            break;
+        default:
+            pass = ppgso::RenderQueue::Pass::Additive;
+            break;
+        }
+
+        // Camera looks down -z, distance grows with negative view depth
+        auto depth = -(camera->viewMatrix * glm::vec4(obj->position, 1.0f)).z;
+        auto object = obj.get();
+        renderQueue.submit(pass, obj->renderShader, obj->renderTexture, obj->renderMesh, depth,
+                           [this, object] { object->render(*this); });
+    }
+    renderQueue.flush();
 }
 
 std::vector<Object*> Scene::intersect(const glm::vec3& position, const glm::vec3& direction)
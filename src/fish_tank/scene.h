@@ -7,6 +7,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include <ppgso/ppgso.h>
+
 #include "object.h"
 #include "camera.h"
 
@@ -25,6 +27,9 @@ public:
 
  /*!
   * Render all objects in the scene
+  * Objects are queued by pass and drawn background first, then opaque ones grouped by material,
+  * alpha blended ones back to front and additive ones last,
+  * blended objects test against the depth buffer but do not write to it
   */
  void render();
 
@@ -47,6 +52,9 @@ public:
  // All objects to be rendered in scene
  std::list<std::unique_ptr<Object>> objects;
 
+ // Draws of the current frame, kept to reuse its allocations
+ ppgso::RenderQueue renderQueue;
+
  // Keyboard state
  std::map<int, int> keyboard;
 
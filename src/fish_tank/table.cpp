@@ -10,9 +10,9 @@
 
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Table::mesh;
-std::unique_ptr<ppgso::Texture> Table::texture;
-std::unique_ptr<ppgso::Shader> Table::shader;
+std::shared_ptr<ppgso::Mesh> Table::mesh;
+std::shared_ptr<ppgso::Texture> Table::texture;
+std::shared_ptr<ppgso::Shader> Table::shader;
 
 Table::Table()
 {
@@ -20,9 +20,12 @@ Table::Table()
     scale = glm::vec3(5.0f, 5.0f, 5.0f); // This is the default scale, which makes the object 1x in size.
 
     // Initialize static resources if needed
-    if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("textures/wood.bmp"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("table.obj");
+    if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl, ppgso::Shader::PointLight);
+    if (!texture) texture = ppgso::TextureCache::get("textures/wood.bmp");
+    if (!mesh) mesh = ppgso::MeshCache::get("table.obj");
+    renderShader = shader.get();
+    renderTexture = texture.get();
+    renderMesh = mesh.get();
 }
 
 bool Table::update(Scene& scene, float dt)
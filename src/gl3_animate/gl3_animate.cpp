@@ -2,6 +2,7 @@
 // - Demonstrates the use of a dynamically generated texture content on the CPU
 // - Displays the generated content as texture on a quad using OpenGL
 // - Basic animation achieved by incrementing a parameter used in the image generation
+// - Frames are written straight into a ring of mapped pixel buffers and uploaded asynchronously
 
 #include <iostream>
 #include <cmath>
@@ -28,22 +29,28 @@ private:
   // Initialize texture
   ppgso::Texture texture = {SIZE, SIZE};
 
+  // Triple buffered upload ring for the texture
+  ppgso::TextureStream stream = {texture};
+
   /*!
    * Update OpenGL texture with new animation frame
-   * @param texture Texture to update
+   * @param stream Upload ring of the texture to update
    * @param time Time to generate animation frame for
    */
-  void updateTexture(ppgso::Texture &texture, double time) {
-    // Draw something to the texture
+  void updateTexture(ppgso::TextureStream &stream, double time) {
+    // Draw something directly into the mapped buffer
     double cx = sin(time);
     double cy = cos(time * 0.9);
+    auto pixels = (ppgso::Image::Pixel *) stream.map();
+    auto width = texture.getWidth();
+    auto height = texture.getHeight();
 
     #pragma omp parallel for
-    for (int y = 0; y < texture.image.height; y++) {
-      for (int x = 0; x < texture.image.width; x++) {
-        auto& pixel = texture.image.getPixel(x, y);
-        double fx = (float) x / (float) (texture.image.width) - .5;
-        double fy = (float) y / (float) (texture.image.height) - .5;
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        auto& pixel = pixels[x + y * width];
+        double fx = (float) x / (float) (width) - .5;
+        double fy = (float) y / (float) (height) - .5;
         double dist = sqrt(pow(fx - cx, 2.0) + pow(fy - cy, 2.0));
 
         pixel.r = (uint8_t) (sin(dist * 45.0) * 127 + 128);
@@ -51,8 +58,8 @@ private:
         pixel.b = (uint8_t) (sin(dist * 46.0) * 127 + 128);
       }
     }
-    // Update the OpenGL texture content
-    texture.update();
+    // Queue the upload, the quad covers the window 1:1 so mip levels are not needed
+    stream.unmap(false);
   }
 
 public:
@@ -67,6 +74,8 @@ public:
     program.setUniform("ModelMatrix", glm::mat4{1.0f});
     program.setUniform("ViewMatrix", glm::mat4{1.0f});
     program.setUniform("ProjectionMatrix", glm::mat4{1.0f});
+
+    std::cout << "Texture upload ring: " << (stream.isPersistent() ? "persistent mapping" : "unsynchronized mapping") << std::endl;
   }
 
   /*!
@@ -75,7 +84,7 @@ public:
   void onIdle() override {
     // Generate texture content
     auto time = glfwGetTime();
-    updateTexture(texture, time);
+    updateTexture(stream, time);
 
     // Set gray background
     glClearColor(.5f, .5f, .5f, 0);
@@ -1,6 +1,7 @@
 // Example gl_framebuffer
 // - Demonstrates use of Framebuffer Object (FBO)
 // - Renders a scene to a texture in graphics memory and uses this texture in the final scene displayed on screen
+// - The texture is filtered by ppgso::Convolution before it is displayed
 
 #include <iostream>
 #include <cmath>
@@ -29,11 +30,31 @@ private:
   // Objects to render the framebuffer on to
   ppgso::Shader quadShader = {convolution_vert_glsl, convolution_frag_glsl};
   ppgso::Mesh quadMesh = {"quad.obj"};
-  ppgso::Texture quadTexture = {SIZE, SIZE};
 
-  // OpenGL object ids for framebuffer and render buffer
-  GLuint fbo = 0;
-  GLuint rbo = 0;
+  // Framebuffer with color texture (the sphere will be rendered to it) and depth buffer
+  ppgso::RenderTarget target = {SIZE, SIZE};
+
+  // Filtered copy of the framebuffer texture displayed on the quad
+  ppgso::RenderTarget filtered = {SIZE, SIZE, ppgso::Texture::Format::RGBA8, false};
+
+/*
+  // Example filters, separable kernels such as this Gaussian run as two passes of 3 bilinear fetches
+  ppgso::Convolution convolution = {{
+            1.0f,  4.0f,  6.0f,  4.0f, 1.0f,
+            4.0f, 16.0f, 24.0f, 16.0f, 4.0f,
+            6.0f, 24.0f, 36.0f, 24.0f, 6.0f,
+            4.0f, 16.0f, 24.0f, 16.0f, 4.0f,
+            1.0f,  4.0f,  6.0f,  4.0f, 1.0f}, 5, 256.0f};
+*/
+
+  // Emboss filter, not separable so it runs as a single pass (or compute shader where available)
+  // Rows are along x, the original shader indexed its kernel the other way so this is its transpose
+  ppgso::Convolution convolution = {{
+            0.0f, -1.0f, -1.0f, -1.0f, -1.0f,
+            1.0f,  0.0f, -1.0f, -1.0f, -1.0f,
+            1.0f,  1.0f,  0.0f, -1.0f, -1.0f,
+            1.0f,  1.0f,  1.0f,  0.0f, -1.0f,
+            1.0f,  1.0f,  1.0f,  1.0f,  0.0f}, 5};
 public:
   /*!
    * Constructor for our custom window
@@ -44,35 +65,10 @@ public:
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
-    // Disable mipmapping on the quadTexture
-    quadTexture.bind();
+    // Show the individual texels of the filtered texture
+    filtered.getTexture().bind();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    // Initialize framebuffer, its color texture (the sphere will be rendered to it) and its render buffer for depth info storage
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-    // Set up render buffer that has a depth buffer and stencil buffer
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-    // Associate the quadTexture with it
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, quadTexture.image.width, quadTexture.image.height);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, quadTexture.getTexture(), 0);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-      throw std::runtime_error("Cannot create framebuffer!");
-    }
-  }
-
-  /*!
-   * Free any allocated OpenGL resources
-   */
-  ~FramebufferWindow() override {
-    glDeleteRenderbuffers(1, &rbo);
-    glDeleteFramebuffers(1, &fbo);
   }
 
   /*!
@@ -85,8 +81,7 @@ public:
     // Pass 1 - Render a scene with sphere to a texture in graphics memory
     // --------
     // Set rendering target to texture
-    glViewport(0, 0, SIZE, SIZE);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    target.bind();
 
     // Clear the framebuffer
     glClearColor(.5f, .7f, .5f, 0);
@@ -109,6 +104,9 @@ public:
     sphereShader.setUniform("Texture", sphereTexture);
     sphereMesh.render();
 
+    // Filter the framebuffer texture
+    convolution.apply(target.getTexture(), filtered);
+
     // --------
     // Pass 2 - Render the final scene to screen
     // --------
@@ -134,7 +132,7 @@ public:
     quadShader.setUniform("ProjectionMatrix", quadProjectionMatrix);
     quadShader.setUniform("ViewMatrix", quadViewMatrix);
     quadShader.setUniform("ModelMatrix", quadModelMatrix);
-    quadShader.setUniform("Texture", quadTexture);
+    quadShader.setUniform("Texture", filtered.getTexture());
     quadMesh.render();
   }
 };
@@ -6,9 +6,9 @@
 #include <shaders/texture_frag_glsl.h>
 
 // static resources
-std::unique_ptr<ppgso::Mesh> Explosion::mesh;
-std::unique_ptr<ppgso::Texture> Explosion::texture;
-std::unique_ptr<ppgso::Shader> Explosion::shader;
+std::shared_ptr<ppgso::Mesh> Explosion::mesh;
+std::shared_ptr<ppgso::Texture> Explosion::texture;
+std::shared_ptr<ppgso::Shader> Explosion::shader;
 
 Explosion::Explosion() {
   // Random rotation and momentum
@@ -17,9 +17,9 @@ Explosion::Explosion() {
   speed = {0.0f, 0.0f, 0.0f};
 
   // Initialize static resources if needed
-  if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("explosion.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("asteroid.obj");
+  if (!shader) shader = ppgso::ShaderCache::get(texture_vert_glsl, texture_frag_glsl);
+  if (!texture) texture = ppgso::TextureCache::get("explosion.bmp");
+  if (!mesh) mesh = ppgso::MeshCache::get("asteroid.obj");
 }
 
 void Explosion::render(Scene &scene) {
@@ -7,9 +7,9 @@
 
 
 // shared resources
-std::unique_ptr<ppgso::Mesh> Projectile::mesh;
-std::unique_ptr<ppgso::Shader> Projectile::shader;
-std::unique_ptr<ppgso::Texture> Projectile::texture;
+std::shared_ptr<ppgso::Mesh> Projectile::mesh;
+std::shared_ptr<ppgso::Shader> Projectile::shader;
+std::shared_ptr<ppgso::Texture> Projectile::texture;
 
 Projectile::Projectile() {
   // Set default speed
@@ -17,9 +17,9 @@ Projectile::Projectile() {
   rotMomentum = {0.0f, 0.0f, glm::linearRand(-ppgso::PI/4.0f, ppgso::PI/4.0f)};
 
   // Initialize static resources if needed
-  if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("missile.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("missile.obj");
+  if (!shader) shader = ppgso::ShaderCache::get(diffuse_vert_glsl, diffuse_frag_glsl);
+  if (!texture) texture = ppgso::TextureCache::get("missile.bmp");
+  if (!mesh) mesh = ppgso::MeshCache::get("missile.obj");
 }
 
 bool Projectile::update(Scene &scene, float dt) {
@@ -6,9 +6,9 @@
 
 Space::Space() {
   // Initialize static resources if needed
-  if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("stars.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("quad.obj");
+  if (!shader) shader = ppgso::ShaderCache::get(texture_vert_glsl, texture_frag_glsl);
+  if (!texture) texture = ppgso::TextureCache::get("stars.bmp");
+  if (!mesh) mesh = ppgso::MeshCache::get("quad.obj");
 }
 
 bool Space::update(Scene &scene, float dt) {
@@ -40,6 +40,6 @@ void Space::render(Scene &scene) {
 }
 
 // shared resources
-std::unique_ptr<ppgso::Mesh> Space::mesh;
-std::unique_ptr<ppgso::Shader> Space::shader;
-std::unique_ptr<ppgso::Texture> Space::texture;
+std::shared_ptr<ppgso::Mesh> Space::mesh;
+std::shared_ptr<ppgso::Shader> Space::shader;
+std::shared_ptr<ppgso::Texture> Space::texture;
@@ -0,0 +1,149 @@
+// Check gpu_flock_check
+// - Creates a headless OpenGL 4.3 context through EGL, no window or display is needed (Mesa llvmpipe works)
+// - Spawns the same school into the fish_tank Flock and GpuFlock and steps both with the same predators
+// - Compares positions, model matrices and neighbour counts of the two after every step
+// - Exits with a failure as soon as the simulations diverge
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "../fish_tank/Flock.h"
+#include "../fish_tank/GpuFlock.h"
+
+// School size and box, 2 fish per cubic unit like boids_bench
+const size_t FISH = 4000;
+const glm::vec3 EXTENT{10.0f, 5.0f, 5.0f};
+
+// Steps compared, float rounding differs between the CPU and the shader so long runs drift apart
+const int STEPS = 20;
+const float STEP = 1.0f / 60.0f;
+
+// Largest allowed difference of a position or a model matrix column, and of the average neighbour count
+const float TOLERANCE = 1e-3f;
+const float NEIGHBOUR_TOLERANCE = 0.01f;
+
+// Axis of the fish_1 mesh, as in FishSchool
+const glm::vec3 FORWARD{0.0f, 1.0f, 0.0f};
+
+/*!
+ * Make an OpenGL 4.3 core context current without any surface
+ * @return True when the context is current
+ */
+bool createContext() {
+  EGLDisplay display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (getPlatformDisplay)
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+  if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API))
+    return false;
+
+  const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint configs = 0;
+  eglChooseConfig(display, configAttributes, &config, 1, &configs);
+
+  const EGLint contextAttributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 4,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  auto context = eglCreateContext(display, configs ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+  if (context == EGL_NO_CONTEXT) return false;
+  return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+}
+
+/*!
+ * Get the largest distance between the fish positions of two flocks
+ * @param cpu - Flock in its own sorted order
+ * @param gpu - Flock read back from the GPU, in the order the fish were added in
+ * @return Largest distance
+ */
+float positionDifference(const Flock &cpu, const Flock &gpu) {
+  float difference = 0.0f;
+  for (size_t i = 0; i < cpu.size(); i++)
+    difference = std::max(difference, glm::length(cpu.getPosition(i) - gpu.getPosition(cpu.ids()[i])));
+  return difference;
+}
+
+/*!
+ * Get the largest difference between the model matrices of the CPU flock and the instance buffer
+ * @param cpu - Flock to write the matrices of
+ * @param scales - Scale of each fish
+ * @param instances - Storage buffer written by GpuFlock::step
+ * @return Largest distance between corresponding matrix columns
+ */
+float modelDifference(const Flock &cpu, const std::vector<float> &scales, GLuint instances) {
+  std::vector<glm::mat4> expected, models(cpu.size());
+  cpu.writeModels(expected, FORWARD, scales);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instances);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, models.size() * sizeof(glm::mat4), models.data());
+
+  float difference = 0.0f;
+  for (size_t i = 0; i < models.size(); i++)
+    for (int column = 0; column < 4; column++)
+      difference = std::max(difference, glm::length(expected[i][column] - models[i][column]));
+  return difference;
+}
+
+int main() {
+  if (!createContext()) {
+    std::cerr << "Failed to create an OpenGL 4.3 context through EGL" << std::endl;
+    return EXIT_FAILURE;
+  }
+  // Without an X display the GLX part of glewInit fails, the OpenGL entry points are loaded before that
+  glewExperimental = GL_TRUE;
+  glewInit();
+  if (!GpuFlock::isSupported()) {
+    std::cerr << "GpuFlock needs OpenGL 4.3, got " << glGetString(GL_VERSION) << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Running on " << glGetString(GL_RENDERER) << std::endl;
+
+  Flock cpu{-EXTENT, EXTENT};
+  cpu.spawn(FISH, 3);
+  std::vector<float> scales(FISH);
+  for (size_t i = 0; i < FISH; i++) scales[i] = 0.5f + (float) (i % 11) / 10.0f;
+  GpuFlock gpu{cpu, scales};
+
+  std::vector<glm::vec3> predators{{0.0f, 0.0f, 0.0f}, {EXTENT.x * 0.5f, 0.0f, 0.0f}};
+  cpu.setPredators(predators);
+  gpu.setPredators(predators);
+
+  GLuint instances;
+  glGenBuffers(1, &instances);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instances);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, FISH * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+
+  Flock result{-EXTENT, EXTENT};
+  for (int step = 1; step <= STEPS; step++) {
+    cpu.step(STEP);
+    gpu.step(STEP, instances, FORWARD);
+    gpu.download(result);
+
+    auto positions = positionDifference(cpu, result);
+    auto models = modelDifference(cpu, scales, instances);
+    auto neighbours = std::abs(cpu.getAverageNeighbours() - gpu.getAverageNeighbours());
+    if (positions > TOLERANCE || models > TOLERANCE || neighbours > NEIGHBOUR_TOLERANCE || glGetError() != GL_NO_ERROR) {
+      std::cerr << "Step " << step << " diverged: position difference " << positions << ", model difference "
+                << models << ", neighbours cpu " << cpu.getAverageNeighbours() << " gpu " << gpu.getAverageNeighbours()
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (step == STEPS)
+      std::cout << FISH << " fish match after " << STEPS << " steps: position difference " << positions
+                << ", model difference " << models << ", " << gpu.getAverageNeighbours() << " neighbours each"
+                << std::endl;
+  }
+
+  glDeleteBuffers(1, &instances);
+  return EXIT_SUCCESS;
+}
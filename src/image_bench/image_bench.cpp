@@ -0,0 +1,196 @@
+// Benchmark image_bench
+// - Loads every BMP image in a directory (data/ by default) with three strategies
+// - Stream: std::ifstream with per row buffers and per pixel BGR to RGB swap (previous loader)
+// - Mapped: ppgso::image::loadBMP, memory mapped file with vectorized row swizzle
+// - Batch: ppgso::image::loadBMPs, memory mapped files loaded in parallel
+// - Prints throughput of each strategy
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <ppgso/ppgso.h>
+
+// Number of times each strategy loads the whole set
+const int REPEAT = 10;
+
+#pragma pack(2)
+struct FileHeader {
+  unsigned short bfType;
+  unsigned int bfSize;
+  unsigned short bfReserved1;
+  unsigned short bfReserved2;
+  unsigned int bfOffBits;
+};
+
+struct InfoHeader {
+  unsigned int biSize;
+  int biWidth;
+  int biHeight;
+  unsigned short biPlanes;
+  unsigned short biBitCount;
+  unsigned int biCompression;
+  unsigned int biSizeImage;
+  int biXPelsPerMeter;
+  int biYPelsPerMeter;
+  unsigned int biClrUsed;
+  unsigned int biClrImportant;
+};
+#pragma pack()
+
+/*!
+ * Reference loader reading through std::ifstream, 24-bit BI_RGB files only
+ * @param bmp Path to the BMP file
+ * @return Loaded image
+ */
+ppgso::Image loadBMPStream(const std::string &bmp) {
+  FileHeader fileHeader = {};
+  InfoHeader infoHeader = {};
+  std::ifstream input(bmp, std::ios::binary);
+  input.read((char *) &fileHeader, sizeof(FileHeader));
+  input.read((char *) &infoHeader, sizeof(InfoHeader));
+
+  int width = infoHeader.biWidth;
+  int height = std::abs(infoHeader.biHeight);
+  bool flipped = infoHeader.biHeight < 0;
+  ppgso::Image image{width, height};
+  auto &framebuffer = image.getFramebuffer();
+
+  input.seekg(fileHeader.bfOffBits, input.beg);
+  unsigned int rowPadded = (width * sizeof(ppgso::Image::Pixel) + 3) & (~3);
+  for (int j = 0; j < height; j++) {
+    auto row = std::vector<ppgso::Image::Pixel>(rowPadded);
+    input.read((char *) row.data(), rowPadded);
+    for (int i = 0; i < width; i++) {
+      auto pixel = row[i];
+      std::swap(pixel.r, pixel.b);
+      framebuffer[i + (flipped ? j : height - 1 - j) * width] = pixel;
+    }
+  }
+  return image;
+}
+
+/*!
+ * Check if file is a 24-bit uncompressed BMP the reference loader understands
+ * @param bmp Path to the file
+ * @return True for 24-bit BI_RGB files
+ */
+bool isPlainBMP(const std::string &bmp) {
+  FileHeader fileHeader = {};
+  InfoHeader infoHeader = {};
+  std::ifstream input(bmp, std::ios::binary);
+  input.read((char *) &fileHeader, sizeof(FileHeader));
+  input.read((char *) &infoHeader, sizeof(InfoHeader));
+  return input && fileHeader.bfType == 19778 && infoHeader.biBitCount == 24 && infoHeader.biCompression == 0;
+}
+
+/*!
+ * List BMP files in a directory and its subdirectories
+ * @param directory Directory to search
+ * @param files Output list of paths
+ */
+void findBMPs(const std::string &directory, std::vector<std::string> &files) {
+  auto isBMP = [](std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return name.size() > 4 && name.compare(name.size() - 4, 4, ".bmp") == 0;
+  };
+#ifdef _WIN32
+  WIN32_FIND_DATAA entry;
+  auto handle = FindFirstFileA((directory + "\\*").c_str(), &entry);
+  if (handle == INVALID_HANDLE_VALUE) return;
+  do {
+    std::string name = entry.cFileName;
+    if (name == "." || name == "..") continue;
+    if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) findBMPs(directory + "/" + name, files);
+    else if (isBMP(name)) files.push_back(directory + "/" + name);
+  } while (FindNextFileA(handle, &entry));
+  FindClose(handle);
+#else
+  auto dir = opendir(directory.c_str());
+  if (!dir) return;
+  while (auto entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") continue;
+    if (entry->d_type == DT_DIR) findBMPs(directory + "/" + name, files);
+    else if (isBMP(name)) files.push_back(directory + "/" + name);
+  }
+  closedir(dir);
+#endif
+}
+
+/*!
+ * Run loader over the file set several times and print throughput
+ * @param name Label of the strategy
+ * @param bytes Size of the decoded image data of one pass
+ * @param load Function loading the whole set once
+ * @return Best time of one pass in seconds
+ */
+template<typename Load>
+double benchmark(const std::string &name, size_t bytes, Load load) {
+  double best = 1e9;
+  for (int i = 0; i < REPEAT; i++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    load();
+    auto end = std::chrono::high_resolution_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  std::cout << name << ": " << best * 1000.0 << " ms, " << bytes / best / (1024.0 * 1024.0) << " MiB/s" << std::endl;
+  return best;
+}
+
+int main(int argc, char **argv) {
+  std::string directory = argc > 1 ? argv[1] : ".";
+  std::vector<std::string> files;
+  findBMPs(directory, files);
+  std::sort(files.begin(), files.end());
+
+  // The reference loader handles plain 24-bit files only, keep the comparison fair
+  files.erase(std::remove_if(files.begin(), files.end(), [](const std::string &file) { return !isPlainBMP(file); }),
+              files.end());
+  if (files.empty()) {
+    std::cerr << "No 24-bit BMP files found in " << directory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Make sure the loaders agree before timing them
+  size_t bytes = 0;
+  for (auto &file : files) {
+    auto reference = loadBMPStream(file);
+    auto mapped = ppgso::image::loadBMP(file);
+    auto &a = reference.getFramebuffer();
+    auto &b = mapped.getFramebuffer();
+    if (a.size() != b.size() || !std::equal(a.begin(), a.end(), b.begin(), [](const ppgso::Image::Pixel &p, const ppgso::Image::Pixel &q) {
+      return p.r == q.r && p.g == q.g && p.b == q.b;
+    })) {
+      std::cerr << "Loaders disagree on " << file << std::endl;
+      return EXIT_FAILURE;
+    }
+    bytes += a.size() * sizeof(ppgso::Image::Pixel);
+  }
+  std::cout << files.size() << " files, " << bytes / (1024.0 * 1024.0) << " MiB of pixels" << std::endl;
+
+  auto stream = benchmark("Stream", bytes, [&]() {
+    for (auto &file : files) loadBMPStream(file);
+  });
+  auto mapped = benchmark("Mapped", bytes, [&]() {
+    for (auto &file : files) ppgso::image::loadBMP(file);
+  });
+  auto batch = benchmark("Batch ", bytes, [&]() {
+    ppgso::image::loadBMPs(files);
+  });
+
+  std::cout << "Speedup mapped " << stream / mapped << "x, batch " << stream / batch << "x" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Benchmark mesh_bench
+// - Loads every .obj and .gltf model in a directory (the working directory by default) with ppgso::MeshOptimizer enabled
+// - Prints the ACMR of each triangle list before and after optimization, for a FIFO cache of 16 vertices
+// - Prints the load time with and without the optimization stage
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <ppgso/ppgso.h>
+
+/*!
+ * List model files in a directory
+ * @param directory Directory to search
+ * @return Paths of .obj and .gltf files, sorted
+ */
+std::vector<std::string> findModels(const std::string &directory) {
+  std::vector<std::string> files;
+  auto isModel = [](std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0) || ppgso::Mesh_Gltf::isGltf(name);
+  };
+#ifdef _WIN32
+  WIN32_FIND_DATAA entry;
+  auto handle = FindFirstFileA((directory + "\\*").c_str(), &entry);
+  if (handle == INVALID_HANDLE_VALUE) return files;
+  do {
+    std::string name = entry.cFileName;
+    if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && isModel(name)) files.push_back(directory + "/" + name);
+  } while (FindNextFileA(handle, &entry));
+  FindClose(handle);
+#else
+  auto dir = opendir(directory.c_str());
+  if (!dir) return files;
+  while (auto entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (entry->d_type != DT_DIR && isModel(name)) files.push_back(directory + "/" + name);
+  }
+  closedir(dir);
+#endif
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+/*!
+ * Load all models once
+ * @param files Model paths
+ * @return Time in milliseconds
+ */
+double load(const std::vector<std::string> &files) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (auto &file : files) ppgso::Mesh mesh{file};
+  glFinish();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+  std::string directory = argc > 1 ? argv[1] : ".";
+  auto files = findModels(directory);
+  if (files.empty()) {
+    std::cerr << "No .obj or .gltf files found in " << directory << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Meshes need a context, the window is closed as soon as the benchmark ends
+  ppgso::Window window{"mesh_bench", 64, 64};
+
+  auto plain = load(files);
+  ppgso::MeshOptimizer::setEnabled(true);
+  auto optimized = load(files);
+
+  size_t triangles = 0;
+  double missesBefore = 0, missesAfter = 0;
+  std::cout << std::fixed << std::setprecision(3);
+  for (auto &report : ppgso::MeshOptimizer::reports()) {
+    std::cout << report.name << ": " << report.triangles << " triangles, " << report.vertices << " vertices, ACMR "
+              << report.acmrBefore << " -> " << report.acmrAfter << std::endl;
+    triangles += report.triangles;
+    missesBefore += report.acmrBefore * report.triangles;
+    missesAfter += report.acmrAfter * report.triangles;
+  }
+  if (triangles)
+    std::cout << "All models: " << triangles << " triangles, ACMR " << missesBefore / triangles << " -> "
+              << missesAfter / triangles << std::endl;
+  std::cout << std::setprecision(1) << "Load time: " << plain << " ms plain, " << optimized << " ms optimized"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+// Benchmark obj_bench
+// - Parses a large Wavefront OBJ file with both loaders of tiny_obj_loader
+// - Stream: tinyobj::LoadObj, std::istream line by line
+// - Parallel: tinyobj::LoadObjParallel, memory mapped file parsed in chunks, once on one thread and once on all
+// - Without an argument a tessellated sphere with about three million triangles is written first
+// - Prints the time of each and checks that both produce the same shapes
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <ppgso/tiny_obj_loader.h>
+
+// Quads of the generated sphere along each axis, two triangles per quad
+const int SEGMENTS = 1200;
+
+// Number of times each loader parses the file, the best time is reported
+const int REPEAT = 3;
+
+/*!
+ * Write a UV sphere with positions, texture coordinates and normals
+ * @param path - File to write
+ */
+void writeSphere(const std::string &path) {
+  std::ofstream obj{path};
+  const double pi = std::acos(-1.0);
+  for (int i = 0; i <= SEGMENTS; i++) {
+    for (int j = 0; j <= SEGMENTS; j++) {
+      double u = (double) j / SEGMENTS, v = (double) i / SEGMENTS;
+      double x = std::sin(v * pi) * std::cos(u * 2 * pi), y = std::cos(v * pi), z = std::sin(v * pi) * std::sin(u * 2 * pi);
+      obj << "v " << x << " " << y << " " << z << "\n";
+      obj << "vt " << u << " " << v << "\n";
+      obj << "vn " << x << " " << y << " " << z << "\n";
+    }
+  }
+  for (int i = 0; i < SEGMENTS; i++) {
+    for (int j = 0; j < SEGMENTS; j++) {
+      int a = i * (SEGMENTS + 1) + j + 1, b = a + SEGMENTS + 1;
+      obj << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+          << b + 1 << "/" << b + 1 << "/" << b + 1 << " " << a + 1 << "/" << a + 1 << "/" << a + 1 << "\n";
+    }
+  }
+}
+
+/*!
+ * Time a loader, keeping the shapes of the last run
+ * @param load - Loads the file into shapes and returns the error string
+ * @param shapes - Output of the loader
+ * @return Best time in milliseconds
+ */
+double measure(const std::function<std::string(std::vector<tinyobj::shape_t> &)> &load,
+               std::vector<tinyobj::shape_t> &shapes) {
+  double best = 0;
+  for (int i = 0; i < REPEAT; i++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto err = load(shapes);
+    auto end = std::chrono::high_resolution_clock::now();
+    if (!err.empty()) {
+      std::cerr << err << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    auto time = std::chrono::duration<double, std::milli>(end - start).count();
+    if (i == 0 || time < best) best = time;
+  }
+  return best;
+}
+
+bool same(const std::vector<tinyobj::shape_t> &a, const std::vector<tinyobj::shape_t> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    auto &x = a[i].mesh, &y = b[i].mesh;
+    if (a[i].name != b[i].name || x.positions != y.positions || x.normals != y.normals ||
+        x.texcoords != y.texcoords || x.indices != y.indices || x.material_ids != y.material_ids)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  std::string path = argc > 1 ? argv[1] : "obj_bench.obj";
+  if (argc <= 1) {
+    std::cout << "Writing " << path << std::endl;
+    writeSphere(path);
+  }
+
+  std::vector<tinyobj::material_t> materials;
+  std::vector<tinyobj::shape_t> stream, single, parallel;
+
+  auto streamTime = measure([&](std::vector<tinyobj::shape_t> &shapes) {
+    return tinyobj::LoadObj(shapes, materials, path.c_str());
+  }, stream);
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  auto singleTime = measure([&](std::vector<tinyobj::shape_t> &shapes) {
+    return tinyobj::LoadObjParallel(shapes, materials, path.c_str());
+  }, single);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+  auto parallelTime = measure([&](std::vector<tinyobj::shape_t> &shapes) {
+    return tinyobj::LoadObjParallel(shapes, materials, path.c_str());
+  }, parallel);
+
+  size_t triangles = 0;
+  for (auto &shape : stream) triangles += shape.mesh.indices.size() / 3;
+
+  std::cout << "Triangles: " << triangles << std::endl;
+  std::cout << "Stream: " << streamTime << " ms" << std::endl;
+  std::cout << "Parallel, 1 thread: " << singleTime << " ms, speedup " << streamTime / singleTime << "x" << std::endl;
+  std::cout << "Parallel, " << threads << " threads: " << parallelTime << " ms, speedup "
+            << streamTime / parallelTime << "x" << std::endl;
+
+  if (!same(stream, single) || !same(stream, parallel)) {
+    std::cerr << "Loaders produced different shapes!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,7 +1,10 @@
 // Example raw3_raytrace
 // - Simple demonstration of raytracing/pathtracing without any acceleration techniques
-// - Casts rays from camera space into scene and recursively traces reflections/refractions
+// - Casts rays from camera space into scene and iteratively traces reflections/refractions
 // - Materials are extended to support simple specular reflections and transparency with refraction index
+// - Emissive spheres are sampled explicitly (next-event estimation) and combined with bounce hits using MIS
+// - Paths are terminated using russian roulette instead of a fixed recursion depth
+// - Low sample count output is cleaned up by an edge-aware a-trous wavelet denoiser guided by feature buffers
 
 #include <iostream>
 #include <ppgso/ppgso.h>
@@ -10,6 +13,9 @@
 constexpr double INF = std::numeric_limits<double>::max();       // Will be used for infinity
 constexpr double EPS = std::numeric_limits<double>::epsilon();   // Numerical epsilon
 const double DELTA = sqrt(EPS);                             // Delta to use
+constexpr double PI = glm::pi<double>();                         // PI constant in double precision
+constexpr unsigned int MAX_DEPTH = 64;                           // Hard limit on path length
+constexpr double DENOISE_EPS = 1e-4;                             // Guards divisions in the denoiser
 
 /*!
  * Structure holding origin and direction that represents a ray
@@ -50,6 +56,45 @@ struct Hit {
  */
 const Hit noHit{ INF, {0,0,0}, {0,0,0}, { {0,0,0}, {0,0,0}, 0, 0, 0 } };
 
+/*!
+ * Surface features of the first diffuse collision along a path, used to guide the denoiser
+ */
+struct Features {
+  glm::dvec3 normal, albedo;
+  double distance;
+};
+
+/*!
+ * Structure holding linear radiance and feature buffers produced by the tracer
+ */
+struct FrameBuffer {
+  int width, height;
+  std::vector<glm::dvec3> color, albedo, normal;
+  std::vector<double> distance, variance;
+
+  /*!
+   * Create new empty frame buffer
+   * @param width Width in pixels
+   * @param height Height in pixels
+   */
+  FrameBuffer(int width, int height) : width{width}, height{height},
+    color(width * height), albedo(width * height), normal(width * height),
+    distance(width * height), variance(width * height) {}
+
+  /*!
+   * Store the radiance buffer in an image
+   * @param image Image of the same size to write to
+   */
+  void save(ppgso::Image &image) const {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        auto &c = color[x + y * width];
+        image.setPixel(x, y, (float)c.r, (float)c.g, (float)c.b);
+      }
+    }
+  }
+};
+
 /*!
  * Structure representing a simple camera that is composed on position, up, back and right vectors
  */
@@ -119,6 +164,38 @@ struct Sphere {
     }
     return noHit;
   }
+
+  /*!
+   * Probability density of sampling a direction towards the sphere using cone sampling
+   * @param from Point the direction is sampled from
+   * @return Density with respect to solid angle or 0 if the point is inside the sphere
+   */
+  inline double solidAnglePdf(const glm::dvec3 &from) const {
+    double d2 = dot(center - from, center - from);
+    if (d2 <= radius * radius) return 0;
+
+    double cosMax = sqrt(1 - radius * radius / d2);
+    return 1 / (2 * PI * (1 - cosMax));
+  }
+
+  /*!
+   * Generate a random direction from a point towards the sphere, uniformly distributed inside the cone it subtends
+   * @param from Point the direction is sampled from, must be outside of the sphere
+   * @return Normalized direction towards the sphere
+   */
+  inline glm::dvec3 sampleDirection(const glm::dvec3 &from) const {
+    glm::dvec3 w = normalize(center - from);
+    glm::dvec3 u = normalize(cross(std::abs(w.x) > .9 ? glm::dvec3{0, 1, 0} : glm::dvec3{1, 0, 0}, w));
+    glm::dvec3 v = cross(w, u);
+
+    double d2 = dot(center - from, center - from);
+    double cosMax = sqrt(1 - radius * radius / d2);
+    double cosTheta = 1 - glm::linearRand(0.0, 1.0) * (1 - cosMax);
+    double sinTheta = sqrt(std::max(0.0, 1 - cosTheta * cosTheta));
+    double phi = 2 * PI * glm::linearRand(0.0, 1.0);
+
+    return normalize(u * (cos(phi) * sinTheta) + v * (sin(phi) * sinTheta) + w * cosTheta);
+  }
 };
 
 /*!
@@ -138,6 +215,30 @@ inline glm::dvec3 RandomDome(const glm::dvec3 &normal) {
   return p;
 }
 
+/*!
+ * Probability density of directions generated by RandomDome
+ */
+constexpr double DOME_PDF = 1 / (2 * PI);
+
+/*!
+ * Compute relative luminance of a linear color
+ * @param color Color to convert
+ * @return Luminance of the color
+ */
+inline double Luminance(const glm::dvec3 &color) {
+  return dot(color, {0.2126, 0.7152, 0.0722});
+}
+
+/*!
+ * Power heuristic for multiple importance sampling of two strategies using one sample each
+ * @param pdf Density of the strategy that generated the sample
+ * @param otherPdf Density of the other strategy for the same sample
+ * @return Weight of the sample
+ */
+inline double PowerHeuristic(double pdf, double otherPdf) {
+  return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+}
+
 /*!
  * Structure to represent the scene/world to render
  */
@@ -162,83 +263,281 @@ struct World {
     return hit;
   }
 
+  /*!
+   * Check if the material is emitting light
+   * @param material Material to check
+   * @return True for materials of spheres that act as light sources
+   */
+  static inline bool isEmissive(const Material &material) {
+    return material.emission != glm::dvec3{0, 0, 0};
+  }
+
+  /*!
+   * Compute the density of light sampling for a ray that has hit an emissive sphere
+   * @param ray Ray that has hit the light
+   * @param hit Closest collision of the ray
+   * @return Density with respect to solid angle as used by sampleLights
+   */
+  inline double lightPdf(const Ray &ray, const Hit &hit) const {
+    for (auto &sphere : spheres) {
+      if (isEmissive(sphere.material) && sphere.hit(ray).distance == hit.distance)
+        return sphere.solidAnglePdf(ray.origin);
+    }
+    return 0;
+  }
+
+  /*!
+   * Estimate direct illumination of a diffuse surface by sampling each emissive sphere
+   * @param hit Collision with the diffuse surface
+   * @return Direct lighting weighted against bounce hits of the same lights
+   */
+  inline glm::dvec3 sampleLights(const Hit &hit) const {
+    glm::dvec3 color{0, 0, 0};
+    glm::dvec3 origin = hit.point + hit.normal * DELTA;
+
+    for (auto &light : spheres) {
+      if (!isEmissive(light.material)) continue;
+
+      double pdf = light.solidAnglePdf(origin);
+      if (pdf == 0) continue;
+
+      // Diffuse bounces only ever leave above the surface
+      Ray shadowRay{origin, light.sampleDirection(origin)};
+      if (dot(shadowRay.direction, hit.normal) <= 0) continue;
+
+      // Light is visible when nothing is closer than the light itself
+      double distance = light.hit(shadowRay).distance;
+      if (distance == INF || cast(shadowRay).distance < distance) continue;
+
+      color += hit.material.diffuse * light.material.emission * DOME_PDF / pdf * PowerHeuristic(pdf, DOME_PDF);
+    }
+    return color;
+  }
+
   /*!
    * Trace a ray as it collides with objects in the world
    * @param ray Ray to trace
-   * @param depth Maximum number of collisions to trace
+   * @param depth Number of collisions to trace before paths are terminated using russian roulette
+   * @param features Optional output for the features of the first diffuse collision
    * @return Color representing the accumulated lighting for each ray collision
    */
-  inline glm::dvec3 trace(const Ray &ray, unsigned int depth) const {
-    if (depth == 0) return {0, 0, 0};
-
-    const Hit hit = cast(ray);
-
-    // No hit
-    if ( std::isinf(hit.distance)) return {0, 0, 0};
-
-    // Emission
-    glm::dvec3 color = hit.material.emission;
-
-    // Decide to reflect or refract using linear random
-    if (glm::linearRand(0.0f, 1.0f) < hit.material.transparency) {
-      // Flip normal if the ray is "inside" a sphere
-      glm::dvec3 normal = dot(ray.direction, hit.normal) < 0 ? hit.normal : -hit.normal;
-      // Reverse the refraction index as well
-      double r_index = dot(ray.direction, hit.normal) < 0 ? 1/hit.material.refractionIndex : hit.material.refractionIndex;
-
-      // Prepare refraction ray
-      glm::dvec3 refraction = refract(ray.direction, normal, r_index);
-      Ray refractionRay{hit.point - normal * DELTA, refraction};
-      // Modulate the refraction color with diffuse color
-      glm::dvec3 refractionColor = lerp(hit.material.diffuse, {1,1,1}, hit.material.transparency);
-      // Trace the ray recursively
-      color += refractionColor * trace(refractionRay, depth - 1);
-    } else {
-      // Calculate reflection
-      // Random diffuse reflection
-      glm::dvec3 diffuse = RandomDome(hit.normal);
-      // Ideal specular reflection
-      glm::dvec3 reflection = reflect(ray.direction, hit.normal);
-      // Ray that combines reflection direction depending on the material reflectivness
-      Ray reflectedRay{hit.point + hit.normal * DELTA, lerp(diffuse, reflection, hit.material.reflectivity)};
-      // Reflection color is white for specular reflections, otherwise diffuse color is used
-      glm::dvec3 reflectionColor = lerp(hit.material.diffuse, {1, 1, 1}, hit.material.reflectivity);
-      // Trace the ray recursively
-      color += reflectionColor * trace(reflectedRay, depth - 1);
+  inline glm::dvec3 trace(Ray ray, unsigned int depth, Features *features = nullptr) const {
+    glm::dvec3 color{0, 0, 0};
+    glm::dvec3 throughput{1, 1, 1};
+    // Density of the last diffuse bounce, 0 when emission is not covered by light sampling
+    double bouncePdf = 0;
+    // Distance travelled along the path, features are recorded only once
+    double distance = 0;
+    bool recorded = features == nullptr;
+    if (features) *features = {{0, 0, 0}, {1, 1, 1}, 0};
+
+    for (unsigned int bounce = 0; bounce < MAX_DEPTH; ++bounce) {
+      const Hit hit = cast(ray);
+
+      // No hit
+      if (hit.distance == INF) break;
+      distance += hit.distance;
+
+      // Emission, diffuse bounces share it with light sampling
+      if (isEmissive(hit.material)) {
+        double weight = bouncePdf > 0 ? PowerHeuristic(bouncePdf, lightPdf(ray, hit)) : 1;
+        color += throughput * hit.material.emission * weight;
+      }
+
+      // Decide to reflect or refract using linear random
+      if (glm::linearRand(0.0f, 1.0f) < hit.material.transparency) {
+        // Flip normal if the ray is "inside" a sphere
+        glm::dvec3 normal = dot(ray.direction, hit.normal) < 0 ? hit.normal : -hit.normal;
+        // Reverse the refraction index as well
+        double r_index = dot(ray.direction, hit.normal) < 0 ? 1/hit.material.refractionIndex : hit.material.refractionIndex;
+
+        // Prepare refraction ray
+        glm::dvec3 refraction = refract(ray.direction, normal, r_index);
+        ray = {hit.point - normal * DELTA, refraction};
+        // Modulate the refraction color with diffuse color
+        throughput *= lerp(hit.material.diffuse, {1,1,1}, hit.material.transparency);
+        bouncePdf = 0;
+      } else {
+        // Purely diffuse surfaces gather direct light explicitly
+        if (hit.material.reflectivity == 0) {
+          color += throughput * sampleLights(hit);
+          bouncePdf = DOME_PDF;
+
+          // Specular chains are followed so reflections keep their own edges
+          if (!recorded) {
+            *features = {hit.normal, throughput * hit.material.diffuse, distance};
+            recorded = true;
+          }
+        } else {
+          bouncePdf = 0;
+        }
+
+        // Calculate reflection
+        // Random diffuse reflection
+        glm::dvec3 diffuse = RandomDome(hit.normal);
+        // Ideal specular reflection
+        glm::dvec3 reflection = reflect(ray.direction, hit.normal);
+        // Ray that combines reflection direction depending on the material reflectivness
+        ray = {hit.point + hit.normal * DELTA, lerp(diffuse, reflection, hit.material.reflectivity)};
+        // Reflection color is white for specular reflections, otherwise diffuse color is used
+        throughput *= lerp(hit.material.diffuse, {1, 1, 1}, hit.material.reflectivity);
+      }
+
+      // Russian roulette, surviving paths are boosted to keep the estimate unbiased
+      if (bounce + 1 >= depth) {
+        double survival = std::min(0.95, std::max(throughput.r, std::max(throughput.g, throughput.b)));
+        if (glm::linearRand(0.0, 1.0) >= survival) break;
+        throughput /= survival;
+      }
     }
 
     return color;
   }
 
   /*!
-   * Render the world to the provided image
-   * @param image Image to render to
+   * Render the world to the provided frame buffer
+   * @param frame Frame buffer to render radiance and features to
+   * @param samples Number of samples per pixel
+   * @param depth Number of collisions to trace before russian roulette
    */
-  void render(ppgso::Image& image, unsigned int samples, unsigned int depth) const {
+  void render(FrameBuffer& frame, unsigned int samples, unsigned int depth) const {
     // For each pixel generate rays
     #pragma omp parallel for
-    for (int y = 0; y < image.height; ++y) {
-      for (int x = 0; x < image.width; ++x) {
-        glm::dvec3 color{};
+    for (int y = 0; y < frame.height; ++y) {
+      for (int x = 0; x < frame.width; ++x) {
+        glm::dvec3 color{}, albedo{}, normal{};
+        double distance = 0, sum = 0, sumSquares = 0;
 
         // Generate multiple samples
         for (unsigned int i = 0; i < samples; ++i) {
-          auto ray = camera.generateRay(x, y, image.width, image.height);
-          color = color + trace(ray, depth);
+          auto ray = camera.generateRay(x, y, frame.width, frame.height);
+          Features features;
+          auto sample = trace(ray, depth, &features);
+          color += sample;
+          albedo += features.albedo;
+          normal += features.normal;
+          distance += features.distance;
+
+          // Moments of the illumination luminance to estimate noise
+          double l = Luminance(sample / max(features.albedo, glm::dvec3{DENOISE_EPS}));
+          sum += l;
+          sumSquares += l * l;
         }
         // Collect the data
-        color = color / (double) samples;
-        image.setPixel(x, y, (float)color.r, (float)color.g, (float)color.b);
+        auto i = x + y * frame.width;
+        frame.color[i] = color / (double) samples;
+        frame.albedo[i] = albedo / (double) samples;
+        frame.normal[i] = length(normal) > 0 ? normalize(normal) : normal;
+        frame.distance[i] = distance / samples;
+        frame.variance[i] = std::max(0.0, sumSquares / samples - sum * sum / (samples * samples)) / samples;
       }
     }
   }
 };
 
+/*!
+ * Edge-avoiding a-trous wavelet filter that smooths the illumination using the feature buffers, similar to SVGF
+ */
+struct Denoiser {
+  unsigned int iterations = 5;  // Number of passes, the filter footprint doubles with each pass
+  double colorPhi = 4;          // Luminance tolerance in standard deviations of the estimated noise
+  double normalPhi = 128;       // Exponent applied to the cosine between normals
+  double distancePhi = 1;       // Tolerance relative to the local distance gradient
+  double albedoPhi = .1;        // Albedo difference tolerance
+
+  /*!
+   * Denoise the radiance buffer of the frame in place
+   * @param frame Frame buffer with radiance, variance and features filled in by World::render
+   */
+  void apply(FrameBuffer &frame) const {
+    const double kernel[] = {1.0/16, 1.0/4, 3.0/8, 1.0/4, 1.0/16};
+    const int width = frame.width, height = frame.height;
+
+    // Filter the illumination only, textures are re-applied after filtering
+    std::vector<glm::dvec3> illumination(frame.color.size()), filtered(frame.color.size());
+    std::vector<double> variance = frame.variance, filteredVariance(variance.size());
+    std::vector<double> gradient(frame.color.size());
+
+    #pragma omp parallel for
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        auto i = x + y * width;
+        illumination[i] = frame.color[i] / max(frame.albedo[i], glm::dvec3{DENOISE_EPS});
+
+        // Screen space distance gradient keeps slanted surfaces from being treated as edges
+        auto &d = frame.distance;
+        double dx = d[std::min(x + 1, width - 1) + y * width] - d[std::max(x - 1, 0) + y * width];
+        double dy = d[x + std::min(y + 1, height - 1) * width] - d[x + std::max(y - 1, 0) * width];
+        gradient[i] = std::max(std::abs(dx), std::abs(dy)) / 2;
+      }
+    }
+
+    for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+      const int step = 1 << iteration;
+
+      #pragma omp parallel for
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+          auto p = x + y * width;
+
+          // Pre-blur the variance to get a stable estimate of the noise
+          double localVariance = 0, localWeight = 0;
+          for (int vy = -1; vy <= 1; ++vy) {
+            for (int vx = -1; vx <= 1; ++vx) {
+              int qx = x + vx, qy = y + vy;
+              if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+              double h = kernel[vx + 2] * kernel[vy + 2];
+              localVariance += h * variance[qx + qy * width];
+              localWeight += h;
+            }
+          }
+          double sigmaL = colorPhi * sqrt(localVariance / localWeight) + DENOISE_EPS;
+          double luminance = Luminance(illumination[p]);
+
+          glm::dvec3 sum{0, 0, 0};
+          double weights = 0, variances = 0;
+          for (int ky = -2; ky <= 2; ++ky) {
+            for (int kx = -2; kx <= 2; ++kx) {
+              int qx = x + kx * step, qy = y + ky * step;
+              if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+              auto q = qx + qy * width;
+
+              double w = kernel[kx + 2] * kernel[ky + 2];
+              if (q != p) {
+                glm::dvec3 da = frame.albedo[p] - frame.albedo[q];
+                w *= exp(-std::abs(luminance - Luminance(illumination[q])) / sigmaL
+                         - std::abs(frame.distance[p] - frame.distance[q]) / (distancePhi * gradient[p] * step * sqrt(kx * kx + ky * ky) + DENOISE_EPS)
+                         - dot(da, da) / (albedoPhi * albedoPhi))
+                     * pow(std::max(0.0, dot(frame.normal[p], frame.normal[q])), normalPhi);
+              }
+
+              sum += w * illumination[q];
+              weights += w;
+              variances += w * w * variance[q];
+            }
+          }
+
+          filtered[p] = sum / weights;
+          filteredVariance[p] = variances / (weights * weights);
+        }
+      }
+
+      std::swap(illumination, filtered);
+      std::swap(variance, filteredVariance);
+    }
+
+    // Modulate the filtered illumination with albedo again
+    for (size_t i = 0; i < frame.color.size(); ++i)
+      frame.color[i] = illumination[i] * max(frame.albedo[i], glm::dvec3{DENOISE_EPS});
+  }
+};
+
 int main() {
   std::cout << "This will take a while ..." << std::endl;
 
-  // Image to render to
+  // Image and frame buffer to render to
   ppgso::Image image{512, 512};
+  FrameBuffer frame{image.width, image.height};
 
   // World to render
   const World world{
@@ -261,10 +560,17 @@ int main() {
       },
   };
 
-  // Render the scene
-  world.render(image, 32, 5);
+  // Render a low sample count preview of the scene
+  world.render(frame, 4, 3);
+
+  // Save the noisy result for comparison
+  frame.save(image);
+  ppgso::image::saveBMP(image, "raw3_raytrace_noisy.bmp");
 
-  // Save the result
+  // Denoise and save the result
+  const Denoiser denoiser{};
+  denoiser.apply(frame);
+  frame.save(image);
   ppgso::image::saveBMP(image, "raw3_raytrace.bmp");
 
   std::cout << "Done." << std::endl;
@@ -1,12 +1,32 @@
 // Example raw4_raster
 // - This example implements a very simple software rasterizer that mimics parts of the OpenGL pipeline with vertex and fragment shaders
-// - Some of the pipeline steps such as culling, clipping were skipped for simplicity and readability
-// - Triangle rendering is realized using horizontal triangle splitting and filling is implemented using linear interpolation
+// - Triangles are clipped in homogeneous coordinates against the near/far planes and a guard band
+// - Triangle rendering is realized using edge functions evaluated in fixed point on 8x8 pixel tiles
+// - Coverage of a row of 8 pixels is computed at once using SIMD when available
+// - Faces are transformed, clipped, culled and binned into screen space bins in parallel
+// - Bins are rasterized in parallel, each bin owns its pixels so the framebuffer needs no locks
+// - Attributes are interpolated using perspective correct barycentric weights
+// - A depth pre-pass and per tile min/max depth (Hi-Z) reject hidden tiles and triangles before shading
 
 #include <iostream>
+#include <cstdint>
 #include <ppgso/ppgso.h>
 #include <glm/gtx/euler_angles.hpp>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Global constants
+constexpr int SUBPIXEL_BITS = 4;                  // Fixed point precision of vertex positions
+constexpr int SUBPIXEL = 1 << SUBPIXEL_BITS;      // Subpixel steps per pixel
+constexpr int TILE_SIZE = 8;                      // Tile width and height in pixels
+constexpr float GUARD_BAND = 4;                   // Clip space extent of the guard band in viewport sizes
+constexpr int BIN_SIZE = 64;                      // Bin width and height in pixels, multiple of TILE_SIZE
+constexpr size_t CHUNK_SIZE = 1024;               // Faces processed by one task of the geometry stage
+
 /*!
  * Vertex structure to hold per vertex data in
  */
@@ -25,16 +45,31 @@ struct Vertex {
  * @return Linear combination of v0 and v1
  */
 Vertex lerp(const Vertex &v0, const Vertex &v1, float t) {
-  auto z = glm::lerp(1.0f / v0.position.z, 1.0f / v1.position.z, t);
-  auto texCoord = glm::lerp(v0.texCoord / v0.position.z, v1.texCoord / v1.position.z, t) / z;
   return Vertex{
       glm::lerp(v0.position, v1.position, t),
       glm::lerp(v0.normal, v1.normal, t),
-      texCoord,
+      glm::lerp(v0.texCoord, v1.texCoord, t),
       glm::lerp(v0.color, v1.color, t)
   };
 }
 
+/*!
+ * Vertex interpolation function that combines three vertices using barycentric weights, position is handled by the rasterizer
+ * @param v0 First vertex
+ * @param v1 Second vertex
+ * @param v2 Third vertex
+ * @param weights Barycentric weights of the vertices, expected to sum up to 1
+ * @return Weighted combination of v0, v1 and v2
+ */
+Vertex interpolate(const Vertex &v0, const Vertex &v1, const Vertex &v2, const glm::vec3 &weights) {
+  return Vertex{
+      v0.position * weights.x + v1.position * weights.y + v2.position * weights.z,
+      v0.normal * weights.x + v1.normal * weights.y + v2.normal * weights.z,
+      v0.texCoord * weights.x + v1.texCoord * weights.y + v2.texCoord * weights.z,
+      v0.color * weights.x + v1.color * weights.y + v2.color * weights.z
+  };
+}
+
 /*!
  * Face structure to hold three vertices that form a triangle/face
  */
@@ -96,12 +131,98 @@ private:
     auto x = (int) (textCoord.x * (image.width - 1));
     auto y = (int) (textCoord.y * (image.height - 1));
     // NOTE: The coordinates are vertically inverted for compatibility with object files generated using Blender 3D.
-    auto pixel = image.getPixel(x, image.height-y);
+    auto pixel = image.getPixel(x, image.height - 1 - y);
     // Return normalized color vector
     return glm::vec4{pixel.r / 255.0f, pixel.g / 255.0f, pixel.b / 255.0f, 1.0};
   }
 };
 
+/*!
+ * Edge function of a triangle edge evaluated in fixed point subpixel coordinates
+ * E(x, y) = a * x + b * y + c, positive on the inner side of the edge
+ */
+struct Edge {
+  int64_t a, b, c;
+  // Fill rule bias, pixels exactly on an edge are only covered by top-left edges
+  int64_t bias;
+
+  Edge() = default;
+
+  /*!
+   * Set up edge function for the edge from v0 to v1
+   * @param v0 Edge start in subpixel coordinates
+   * @param v1 Edge end in subpixel coordinates
+   */
+  Edge(const glm::i64vec2 &v0, const glm::i64vec2 &v1) {
+    a = v0.y - v1.y;
+    b = v1.x - v0.x;
+    c = v0.x * v1.y - v0.y * v1.x;
+    // Top edges are horizontal with the triangle below them, left edges go up the screen
+    bool topLeft = (a == 0 && b < 0) || a > 0;
+    bias = topLeft ? 0 : -1;
+  }
+
+  /*!
+   * Evaluate the edge function
+   * @param x Horizontal subpixel coordinate
+   * @param y Vertical subpixel coordinate
+   * @return Unbiased edge function value
+   */
+  inline int64_t operator()(int64_t x, int64_t y) const {
+    return a * x + b * y + c;
+  }
+};
+
+/*!
+ * Compute coverage of a row of 8 pixels
+ * @param e Biased edge function values for the first pixel of the row
+ * @param lanes Edge function offsets of the 8 pixels relative to the first pixel, 32 byte aligned
+ * @return Bit mask with bit i set when pixel i is on the inner side of all three edges
+ */
+inline unsigned int coverRow(const int32_t e[3], const int32_t *const lanes[3]) {
+#if defined(__AVX2__)
+  __m256i outside = _mm256_setzero_si256();
+  for (int k = 0; k < 3; ++k) {
+    __m256i lane = _mm256_load_si256((const __m256i *) lanes[k]);
+    outside = _mm256_or_si256(outside, _mm256_add_epi32(_mm256_set1_epi32(e[k]), lane));
+  }
+  // Sign bits mark pixels outside of any edge
+  return ~(unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFFu;
+#elif defined(__SSE2__)
+  __m128i left = _mm_setzero_si128(), right = _mm_setzero_si128();
+  for (int k = 0; k < 3; ++k) {
+    __m128i value = _mm_set1_epi32(e[k]);
+    left = _mm_or_si128(left, _mm_add_epi32(value, _mm_load_si128((const __m128i *) lanes[k])));
+    right = _mm_or_si128(right, _mm_add_epi32(value, _mm_load_si128((const __m128i *) (lanes[k] + 4))));
+  }
+  // Sign bits mark pixels outside of any edge
+  auto outside = (unsigned int) (_mm_movemask_ps(_mm_castsi128_ps(left)) | _mm_movemask_ps(_mm_castsi128_ps(right)) << 4);
+  return ~outside & 0xFFu;
+#else
+  unsigned int mask = 0;
+  for (int i = 0; i < TILE_SIZE; ++i) {
+    if (((e[0] + lanes[0][i]) | (e[1] + lanes[1][i]) | (e[2] + lanes[2][i])) >= 0) mask |= 1u << i;
+  }
+  return mask;
+#endif
+}
+
+/*!
+ * Triangle prepared for rasterization, holds the viewport vertices and their edge functions
+ */
+struct Triangle {
+  Vertex v0, v1, v2;
+  // Edge k is opposite to vertex k, its value divided by area is the barycentric weight of the vertex
+  Edge edges[3];
+  int64_t area;
+  // Pixel bounds of the triangle, inclusive
+  int minX, minY, maxX, maxY;
+  // Depth range of the triangle
+  float minZ, maxZ;
+  // Edge function offsets of pixels in a tile row
+  alignas(32) int32_t lanes[3][TILE_SIZE];
+};
+
 /*!
  * Simple rasterizer class that can render triangles into an image
  */
@@ -110,92 +231,276 @@ private:
   Program &program;
   ppgso::Image &image;
   std::vector<float> depthBuffer;
+  // Nearest and farthest depth stored in each tile and the farthest depth in each bin
+  std::vector<float> tileMin, tileMax, binMax;
+  std::vector<uint8_t> binDirty;
+  int tilesX, tilesY, binsX, binsY;
 
   /*!
    * Transform a vertex from screen coordinates to viewport/image coordinates
    * @param vertex Vertex to transform to viewport. The visible range is <-1,1> for x and y coordinates
-   * @return Vertex that has position transformed to viewport/image coordinates
+   * @return Vertex that has position transformed to viewport/image coordinates, w holds 1/w for perspective correction
    */
   Vertex toViewport(const Vertex &vertex) {
     // Matrix that aligns the screen coordinates to viewport coordinates
-    static const glm::mat4 viewportMatrix = glm::translate(glm::scale(glm::mat4{1.0f}, glm::vec3{image.width / 2.0, -image.height / 2.0, 1.0}), glm::vec3{1, -1, 0});
+    const glm::mat4 viewportMatrix = glm::translate(glm::scale(glm::mat4{1.0f}, glm::vec3{image.width / 2.0, -image.height / 2.0, 1.0}), glm::vec3{1, -1, 0});
     // First convert homogeneous coordinates to cartesian and transform to viewport
     glm::vec4 viewportCoordinates = viewportMatrix * (vertex.position / vertex.position.w);
+    viewportCoordinates.w = 1.0f / vertex.position.w;
     // Copy rest of the data without change
     return Vertex{viewportCoordinates, vertex.normal, vertex.texCoord, vertex.color};
   }
 
+  /*!
+   * Clip a triangle in homogeneous coordinates against the near and far planes and the guard band
+   * @param face Triangle with vertices in clip space
+   * @return Convex polygon that remains after clipping, empty if the triangle is not visible
+   */
+  static std::vector<Vertex> clip(const Face &face) {
+    // Clip planes as dot products with homogeneous position that have to stay positive
+    static const glm::vec4 planes[] = {
+        { 0, 0, 1, 1}, { 0, 0, -1, 1},
+        { 1, 0, 0, GUARD_BAND}, {-1, 0, 0, GUARD_BAND},
+        { 0, 1, 0, GUARD_BAND}, { 0, -1, 0, GUARD_BAND},
+    };
+
+    std::vector<Vertex> polygon{face.v0, face.v1, face.v2}, clipped;
+    for (auto &plane : planes) {
+      clipped.clear();
+      for (size_t i = 0; i < polygon.size(); ++i) {
+        auto &a = polygon[i];
+        auto &b = polygon[(i + 1) % polygon.size()];
+        float da = dot(plane, a.position), db = dot(plane, b.position);
+        if (da >= 0) clipped.push_back(a);
+        if ((da >= 0) != (db >= 0)) clipped.push_back(lerp(a, b, da / (da - db)));
+      }
+      std::swap(polygon, clipped);
+      if (polygon.empty()) break;
+    }
+    return polygon;
+  }
+
   /*!
    * Set the pixel in the output using the varying data stored in Vertex
    * @param x Fragment horizontal position
    * @param y Fragment vertical position
    * @param varying Varying vertex data to pass to fragment shader which will generate the pixel color
    */
-  void setFragment(const Vertex &varying) {
-    int x = (int) varying.position.x;
-    int y = (int) varying.position.y;
-    // Do not render pixels outside of the image
-    if (x < 0 || y < 0 || x >= image.width || y >= image.height)
-      return;
-
-    // Check and update the depth buffer
-    if (depthBuffer[x + y * image.width] < varying.position.z)
-      return;
-
-    depthBuffer[x + y * image.height] = varying.position.z;
-
+  void setFragment(int x, int y, const Vertex &varying) {
     // Compute the fragment color and limit the output
     glm::vec4 color = clamp(program.fragmentShader(varying), 0.0f, 1.0f);
     image.setPixel(x, y, color.r, color.g, color.b);
   }
 
   /*!
-   * Fill the top portion of a triangle that has split horizontally by using interpolation between vertices
-   * @param v0 - Top vertex of the triangle
-   * @param v1 - First bottom vertex
-   * @param v2 - Second bottom vertex
+   * Recompute the Hi-Z range of a tile after its depth values have changed
+   * @param tileX Horizontal tile index
+   * @param tileY Vertical tile index
    */
-  void renderTopTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2) {
-    for (int y = 0; v0.position.y + y <= v2.position.y; ++y) {
-      float yt = v0.position.y >= v2.position.y ? 0 : y / (v2.position.y - v0.position.y);
-      Vertex a = lerp(v0, v1, yt);
-      Vertex b = lerp(v0, v2, yt);
-      if (a.position.x > b.position.x) std::swap(a, b);
-      for (int x = 0; a.position.x + x <= b.position.x; ++x) {
-        float xt = a.position.x >= b.position.x ? 0 : x / (b.position.x - a.position.x);
-        Vertex varying = lerp(a, b, xt);
-        setFragment(varying);
+  void updateTile(int tileX, int tileY) {
+    float nearest = std::numeric_limits<float>::max(), farthest = 0;
+    for (int y = tileY * TILE_SIZE; y < std::min(image.height, (tileY + 1) * TILE_SIZE); ++y) {
+      for (int x = tileX * TILE_SIZE; x < std::min(image.width, (tileX + 1) * TILE_SIZE); ++x) {
+        nearest = std::min(nearest, depthBuffer[x + y * image.width]);
+        farthest = std::max(farthest, depthBuffer[x + y * image.width]);
       }
     }
+    tileMin[tileX + tileY * tilesX] = nearest;
+    tileMax[tileX + tileY * tilesX] = farthest;
+    binDirty[tileX * TILE_SIZE / BIN_SIZE + tileY * TILE_SIZE / BIN_SIZE * binsX] = true;
   }
 
   /*!
-   * Fill the bottom portion of a triangle that has split horizontally by using interpolation between vertices
-   * @param v0 - First top vertex of the triangle
-   * @param v1 - Second top vertex
-   * @param v2 - Bottom vertex
+   * Prepare viewport triangle for rasterization
+   * @param triangle Triangle with v0, v1 and v2 set, remaining fields are filled in
+   * @return False when the triangle does not cover any pixel
    */
-  void renderBottomTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2) {
-    for (int y = 0; v0.position.y + y <= v2.position.y; ++y) {
-      float yt =  v0.position.y >= v2.position.y ? 0 : y / (v2.position.y - v0.position.y);
-      Vertex a = lerp(v0, v2, yt);
-      Vertex b = lerp(v1, v2, yt);
-      if (a.position.x > b.position.x) std::swap(a, b);
-      for (int x = 0; a.position.x + x <= b.position.x; ++x) {
-        float xt = a.position.x >= b.position.x ? 0 : x / (b.position.x - a.position.x);
-        Vertex varying = lerp(a, b, xt);
-        setFragment(varying);
+  bool setup(Triangle &triangle) {
+    auto fixed = [](const Vertex &v) {
+      return glm::i64vec2{std::llround(v.position.x * SUBPIXEL), std::llround(v.position.y * SUBPIXEL)};
+    };
+    glm::i64vec2 p0 = fixed(triangle.v0), p1 = fixed(triangle.v1), p2 = fixed(triangle.v2);
+
+    // Front faces are counter clockwise on screen which results in negative area in viewport coordinates
+    triangle.area = Edge{p1, p2}(p0.x, p0.y);
+    if (triangle.area == 0 || (cullBackFaces && triangle.area > 0)) return false;
+    if (triangle.area < 0) {
+      std::swap(triangle.v1, triangle.v2);
+      std::swap(p1, p2);
+      triangle.area = -triangle.area;
+    }
+    triangle.edges[0] = Edge{p1, p2};
+    triangle.edges[1] = Edge{p2, p0};
+    triangle.edges[2] = Edge{p0, p1};
+
+    // Bounding box of pixel centers, clamped to the image
+    auto lo = min(p0, min(p1, p2)), hi = max(p0, max(p1, p2));
+    triangle.minX = std::max(0, (int) ((lo.x + SUBPIXEL / 2 - 1) >> SUBPIXEL_BITS));
+    triangle.minY = std::max(0, (int) ((lo.y + SUBPIXEL / 2 - 1) >> SUBPIXEL_BITS));
+    triangle.maxX = std::min(image.width - 1, (int) ((hi.x - SUBPIXEL / 2) >> SUBPIXEL_BITS));
+    triangle.maxY = std::min(image.height - 1, (int) ((hi.y - SUBPIXEL / 2) >> SUBPIXEL_BITS));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return false;
+
+    // Depth is affine in screen space so the range is given by the vertices
+    triangle.minZ = std::min(triangle.v0.position.z, std::min(triangle.v1.position.z, triangle.v2.position.z));
+    triangle.maxZ = std::max(triangle.v0.position.z, std::max(triangle.v1.position.z, triangle.v2.position.z));
+
+    for (int k = 0; k < 3; ++k) {
+      for (int i = 0; i < TILE_SIZE; ++i)
+        triangle.lanes[k][i] = (int32_t) (triangle.edges[k].a * SUBPIXEL * i);
+    }
+    return true;
+  }
+
+  /*!
+   * Rasterize the part of a triangle that overlaps a tile
+   * @param triangle Triangle prepared by setup
+   * @param tileX Horizontal tile index
+   * @param tileY Vertical tile index
+   * @param writeDepth Update the depth buffer with fragments that pass the depth test
+   * @param shade Shade fragments that pass the depth test
+   */
+  void renderTile(const Triangle &triangle, int tileX, int tileY, bool writeDepth, bool shade) {
+    // Hi-Z, the whole tile is hidden behind what has been rendered already
+    const auto tile = tileX + tileY * tilesX;
+    if (triangle.minZ > tileMax[tile]) return;
+    // The whole triangle is in front of anything in the tile so no per pixel depth test is needed
+    const bool depthTest = triangle.maxZ > tileMin[tile];
+
+    const int x0 = tileX * TILE_SIZE, y0 = tileY * TILE_SIZE;
+    // Subpixel coordinates of the first and last pixel centers in the tile
+    const int64_t sx0 = x0 * SUBPIXEL + SUBPIXEL / 2, sy0 = y0 * SUBPIXEL + SUBPIXEL / 2;
+    const int64_t sx1 = sx0 + (TILE_SIZE - 1) * SUBPIXEL, sy1 = sy0 + (TILE_SIZE - 1) * SUBPIXEL;
+
+    // Classify the tile against each edge using its corners, only edges crossing the tile need per pixel tests
+    int64_t origin[3];
+    int32_t e[3] = {0, 0, 0}, stepY[3] = {0, 0, 0};
+    alignas(32) static const int32_t noLanes[TILE_SIZE] = {};
+    const int32_t *lanes[3] = {noLanes, noLanes, noLanes};
+    for (int k = 0; k < 3; ++k) {
+      auto &edge = triangle.edges[k];
+      origin[k] = edge(sx0, sy0);
+      int64_t corners[] = {origin[k], edge(sx1, sy0), edge(sx0, sy1), edge(sx1, sy1)};
+      int inside = 0;
+      for (auto corner : corners)
+        if (corner + edge.bias >= 0) ++inside;
+      if (inside == 0) return;
+      if (inside < 4) {
+        // Values within a crossed tile are bounded by the tile size and fit into 32 bits
+        e[k] = (int32_t) (origin[k] + edge.bias);
+        stepY[k] = (int32_t) (edge.b * SUBPIXEL);
+        lanes[k] = triangle.lanes[k];
       }
     }
+
+    // Limit the tile to the triangle bounds which are also within the image
+    unsigned int columns = 0xFFu;
+    if (x0 < triangle.minX) columns &= 0xFFu << (triangle.minX - x0);
+    if (x0 + TILE_SIZE - 1 > triangle.maxX) columns &= 0xFFu >> (x0 + TILE_SIZE - 1 - triangle.maxX);
+
+    const float area = (float) triangle.area;
+    const glm::vec3 depths{triangle.v0.position.z, triangle.v1.position.z, triangle.v2.position.z};
+    const glm::vec3 inverseW{triangle.v0.position.w, triangle.v1.position.w, triangle.v2.position.w};
+    bool written = false;
+    for (int y = 0; y < TILE_SIZE; ++y) {
+      int py = y0 + y;
+      if (py >= triangle.minY && py <= triangle.maxY) {
+        unsigned int mask = coverRow(e, lanes) & columns;
+        for (int x = 0; mask; ++x, mask >>= 1) {
+          if (!(mask & 1)) continue;
+          // Screen space barycentric weights from the unbiased edge functions
+          glm::vec3 weights;
+          for (int k = 0; k < 3; ++k)
+            weights[k] = (float) (origin[k] + triangle.edges[k].a * SUBPIXEL * x + triangle.edges[k].b * SUBPIXEL * y) / area;
+
+          // Check and update the depth buffer
+          float z = dot(weights, depths);
+          auto &depth = depthBuffer[x0 + x + py * image.width];
+          if (depthTest && depth < z) continue;
+
+          if (writeDepth) {
+            depth = z;
+            written = true;
+          }
+          if (!shade) continue;
+
+          // Perspective correct weights for the varying attributes
+          glm::vec3 perspective = weights * inverseW;
+          float w = perspective.x + perspective.y + perspective.z;
+          Vertex varying = interpolate(triangle.v0, triangle.v1, triangle.v2, perspective / w);
+          varying.position = {x0 + x + .5f, py + .5f, z, w};
+          setFragment(x0 + x, py, varying);
+        }
+      }
+      for (int k = 0; k < 3; ++k) e[k] += stepY[k];
+    }
+
+    if (written) updateTile(tileX, tileY);
+  }
+
+  /*!
+   * Geometry stage, transform a face, clip it and set up the resulting triangles
+   * @param face Face to process
+   * @param triangles Vector to append the visible triangles to
+   */
+  void processFace(const Face &face, std::vector<Triangle> &triangles) {
+    // transform vertices
+    Face transformed{program.vertexShader(face.v0), program.vertexShader(face.v1), program.vertexShader(face.v2)};
+    // Clip and split the remaining polygon into a triangle fan
+    auto polygon = clip(transformed);
+    for (size_t i = 2; i < polygon.size(); ++i) {
+      Triangle triangle;
+      triangle.v0 = toViewport(polygon[0]);
+      triangle.v1 = toViewport(polygon[i - 1]);
+      triangle.v2 = toViewport(polygon[i]);
+      if (setup(triangle)) triangles.push_back(triangle);
+    }
+  }
+
+  /*!
+   * Rasterize the part of a triangle that overlaps a bin
+   * @param triangle Triangle prepared by setup
+   * @param binX Horizontal bin index
+   * @param binY Vertical bin index
+   * @param writeDepth Update the depth buffer, see renderTile
+   * @param shade Shade visible fragments, see renderTile
+   */
+  void renderBin(const Triangle &triangle, int binX, int binY, bool writeDepth, bool shade) {
+    constexpr int tiles = BIN_SIZE / TILE_SIZE;
+
+    // Hi-Z on the bin level rejects hidden triangles before visiting any tiles
+    const auto bin = binX + binY * binsX;
+    if (binDirty[bin]) {
+      binMax[bin] = 0;
+      for (int tileY = binY * tiles; tileY < std::min(tilesY, (binY + 1) * tiles); ++tileY)
+        for (int tileX = binX * tiles; tileX < std::min(tilesX, (binX + 1) * tiles); ++tileX)
+          binMax[bin] = std::max(binMax[bin], tileMax[tileX + tileY * tilesX]);
+      binDirty[bin] = 0;
+    }
+    if (triangle.minZ > binMax[bin]) return;
+
+    int minX = std::max(triangle.minX / TILE_SIZE, binX * tiles), maxX = std::min(triangle.maxX / TILE_SIZE, binX * tiles + tiles - 1);
+    int minY = std::max(triangle.minY / TILE_SIZE, binY * tiles), maxY = std::min(triangle.maxY / TILE_SIZE, binY * tiles + tiles - 1);
+
+    for (int tileY = minY; tileY <= maxY; ++tileY)
+      for (int tileX = minX; tileX <= maxX; ++tileX)
+        renderTile(triangle, tileX, tileY, writeDepth, shade);
   }
 
 public:
+  // Skip faces that are clockwise on screen
+  bool cullBackFaces = true;
+  // Resolve visibility before shading so each pixel is shaded once
+  bool depthPrepass = true;
+
   /*!
    * Initialize the rasterizer
    * @param image Image to render to
    * @param program Program to use for rendering
    */
-  Rasterizer(ppgso::Image &image, Program &program) : program{program}, image{image} {
+  Rasterizer(ppgso::Image &image, Program &program) : program{program}, image{image},
+    tilesX{(image.width + TILE_SIZE - 1) / TILE_SIZE}, tilesY{(image.height + TILE_SIZE - 1) / TILE_SIZE},
+    binsX{(image.width + BIN_SIZE - 1) / BIN_SIZE}, binsY{(image.height + BIN_SIZE - 1) / BIN_SIZE} {
     clear();
   };
 
@@ -205,30 +510,51 @@ public:
   void clear() {
     // Clear the depth buffer
     depthBuffer = std::vector<float>((unsigned long) (image.width * image.height), std::numeric_limits<float>::max());
+    tileMin = tileMax = std::vector<float>((unsigned long) (tilesX * tilesY), std::numeric_limits<float>::max());
+    binMax = std::vector<float>((unsigned long) (binsX * binsY), std::numeric_limits<float>::max());
+    binDirty = std::vector<uint8_t>((unsigned long) (binsX * binsY), 0);
     // Clear the image
     image.clear({128,128,128});
   }
 
   /*!
-   * Render a face into the image
-   * @param face Face to render
+   * Render faces into the image
+   * @param faces Faces to render, overlapping faces with equal depth resolve in submission order
    */
-  void render(const Face &face) {
-    // transform vertices
-    Vertex t0 = toViewport(program.vertexShader(face.v0));
-    Vertex t1 = toViewport(program.vertexShader(face.v1));
-    Vertex t2 = toViewport(program.vertexShader(face.v2));
-    // Sort the vertices
-    if (t0.position.y > t1.position.y) std::swap(t0, t1);
-    if (t0.position.y > t2.position.y) std::swap(t0, t2);
-    if (t1.position.y > t2.position.y) std::swap(t1, t2);
-    // Split the triangle into top/bottom sections
-    float t = t0.position.y >= t2.position.y ? 0 : (t1.position.y - t0.position.y) / (t2.position.y - t0.position.y);
-    Vertex tm = lerp(t0, t2, t);
-
-    // Render
-    renderTopTriangle(t0, tm, t1);
-    renderBottomTriangle(t1, tm, t2);
+  void render(const std::vector<Face> &faces) {
+    // Triangles and their bins per chunk of faces, chunks are kept in submission order
+    const auto chunkCount = (int) ((faces.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    std::vector<std::vector<Triangle>> triangles(chunkCount);
+    std::vector<std::vector<std::vector<const Triangle *>>> bins(chunkCount);
+
+    // Geometry and binning stage
+    #pragma omp parallel for schedule(dynamic)
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+      auto end = std::min(faces.size(), (chunk + 1) * CHUNK_SIZE);
+      for (auto i = chunk * CHUNK_SIZE; i < end; ++i)
+        processFace(faces[i], triangles[chunk]);
+
+      // Pointers are stable once the chunk is complete
+      bins[chunk].resize(binsX * binsY);
+      for (auto &triangle : triangles[chunk]) {
+        for (int binY = triangle.minY / BIN_SIZE; binY <= triangle.maxY / BIN_SIZE; ++binY)
+          for (int binX = triangle.minX / BIN_SIZE; binX <= triangle.maxX / BIN_SIZE; ++binX)
+            bins[chunk][binX + binY * binsX].push_back(&triangle);
+      }
+    }
+
+    // Rasterization stage
+    #pragma omp parallel for schedule(dynamic)
+    for (int bin = 0; bin < binsX * binsY; ++bin) {
+      if (depthPrepass) {
+        for (auto &chunk : bins)
+          for (auto triangle : chunk[bin])
+            renderBin(*triangle, bin % binsX, bin / binsX, true, false);
+      }
+      for (auto &chunk : bins)
+        for (auto triangle : chunk[bin])
+          renderBin(*triangle, bin % binsX, bin / binsX, !depthPrepass, true);
+    }
   }
 };
 
@@ -301,8 +627,7 @@ int main() {
   Rasterizer rasterizer{image, program};
 
   // Render all faces
-  for (auto &face : faces)
-    rasterizer.render(face);
+  rasterizer.render(faces);
 
   // Save the image
   ppgso::image::saveBMP(image, "raw4_raster.bmp");
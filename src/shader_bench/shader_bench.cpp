@@ -0,0 +1,128 @@
+// Benchmark shader_bench
+// - Builds the programs the fish tank needs at startup in three ways
+// - Uncached: one ppgso::Shader per object class, as every class compiled its own copy
+// - Deduplicated: ppgso::ShaderCache, each distinct program is compiled once
+// - Binary: ppgso::ShaderCache with ppgso::ProgramCache, first and repeat launch
+// - Prints the time of each and the program cache counters
+// NOTE: Most drivers keep their own shader cache, run it twice to see warm driver numbers
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+
+#include <shaders/diffuse_vert_glsl.h>
+#include <shaders/diffuse_frag_glsl.h>
+#include <shaders/texture_vert_glsl.h>
+#include <shaders/texture_frag_glsl.h>
+#include <shaders/advanced_material_vert_glsl.h>
+#include <shaders/advanced_material_frag_glsl.h>
+#include <shaders/post_vert_glsl.h>
+#include <shaders/post_bright_frag_glsl.h>
+#include <shaders/post_bloom_frag_glsl.h>
+#include <shaders/post_underwater_frag_glsl.h>
+#include <shaders/post_grayscale_frag_glsl.h>
+#include <shaders/post_copy_frag_glsl.h>
+
+// Directory the binaries are stored in, emptied of the benchmark programs first
+const std::string CACHE_DIRECTORY = "shader_bench_cache";
+
+struct Program {
+  const std::string *vertex;  // Generated shader resources are strings, the table points at them
+  const std::string *fragment;
+  int features;  // ppgso::Shader::Feature flags of the permutation
+  int users;  // Object classes and passes of the fish tank using the program
+};
+
+// FishType1, FishType2, Shark and Asteroid share the plain diffuse program
+const std::vector<Program> PROGRAMS = {
+  {&diffuse_vert_glsl, &diffuse_frag_glsl, 0, 4},
+  {&diffuse_vert_glsl, &diffuse_frag_glsl, ppgso::Shader::PointLight, 1},
+  {&diffuse_vert_glsl, &diffuse_frag_glsl, ppgso::Shader::Transparent, 1},
+  {&diffuse_vert_glsl, &diffuse_frag_glsl, ppgso::Shader::PointLight | ppgso::Shader::Transparent, 1},
+  {&texture_vert_glsl, &texture_frag_glsl, 0, 3},
+  {&advanced_material_vert_glsl, &advanced_material_frag_glsl, 0, 1},
+  {&post_vert_glsl, &post_bright_frag_glsl, 0, 1},
+  {&post_vert_glsl, &post_bloom_frag_glsl, 0, 1},
+  {&post_vert_glsl, &post_underwater_frag_glsl, 0, 1},
+  {&post_vert_glsl, &post_grayscale_frag_glsl, 0, 1},
+  {&post_vert_glsl, &post_copy_frag_glsl, 0, 1},
+};
+
+/*!
+ * Time a startup scenario, the programs it creates are released afterwards
+ * @param build Creates the programs and returns them
+ * @return Time in milliseconds
+ */
+double measure(const std::function<std::vector<std::shared_ptr<ppgso::Shader>>()> &build) {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto programs = build();
+  // Linking may finish asynchronously, wait for the driver before stopping the clock
+  glFinish();
+  auto end = std::chrono::high_resolution_clock::now();
+  programs.clear();
+  ppgso::ShaderCache::instance().clear();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/*!
+ * Build every program through the shader cache, once per user as the fish tank does
+ * @return Programs handed out by the cache
+ */
+std::vector<std::shared_ptr<ppgso::Shader>> cached() {
+  std::vector<std::shared_ptr<ppgso::Shader>> programs;
+  for (auto &program : PROGRAMS)
+    for (int i = 0; i < program.users; i++)
+      programs.push_back(ppgso::ShaderCache::get(*program.vertex, *program.fragment, program.features));
+  return programs;
+}
+
+int main() {
+  // Programs need a context, the window is closed as soon as the benchmark ends
+  ppgso::Window window{"shader_bench", 64, 64};
+
+  int users = 0;
+  for (auto &program : PROGRAMS) users += program.users;
+
+  ppgso::ProgramCache::setDirectory("");
+  auto uncached = measure([]() {
+    std::vector<std::shared_ptr<ppgso::Shader>> programs;
+    for (auto &program : PROGRAMS)
+      for (int i = 0; i < program.users; i++)
+        programs.push_back(std::make_shared<ppgso::Shader>(*program.vertex, *program.fragment, program.features));
+    return programs;
+  });
+  auto deduplicated = measure(cached);
+
+  // First launch compiles and stores, the repeat launch loads the stored binaries
+  ppgso::ProgramCache::setDirectory(CACHE_DIRECTORY);
+  for (auto &program : PROGRAMS) {
+    auto defines = ppgso::Shader::defines(program.features);
+    auto key = ppgso::ProgramCache::key(ppgso::Shader::withDefines(*program.vertex, defines),
+                                        ppgso::Shader::withDefines(*program.fragment, defines));
+    std::remove((CACHE_DIRECTORY + "/" + key + ".bin").c_str());
+  }
+  auto first = measure(cached);
+  auto repeat = measure(cached);
+
+  std::cout << "Uncached: " << users << " programs in " << uncached << " ms" << std::endl;
+  std::cout << "Deduplicated: " << PROGRAMS.size() << " programs in " << deduplicated << " ms, speedup "
+            << uncached / deduplicated << "x" << std::endl;
+  std::cout << "Binary first launch: " << first << " ms" << std::endl;
+  std::cout << "Binary repeat launch: " << repeat << " ms, speedup " << deduplicated / repeat << "x over deduplicated, "
+            << uncached / repeat << "x over uncached" << std::endl;
+
+  auto stats = ppgso::ProgramCache::stats();
+  std::cout << "Program cache: " << stats.loaded << " loaded, " << stats.compiled << " compiled, " << stats.stored
+            << " stored, " << stats.rejected << " rejected" << std::endl;
+  if (stats.stored == 0)
+    std::cout << "The driver offers no program binary formats, every launch compiles from source" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -1,61 +1,42 @@
 // Task 1 - Load a 512x512 image lena.raw
 //        - Apply specified per-pixel transformation to each pixel
 //        - Save as result.raw
-#include <fstream>
 #include <iostream>
 
+#include <ppgso/ppgso.h>
+
 // Size of the framebuffer
 const unsigned int SIZE = 512;
 
-// A simple RGB struct will represent a pixel in the framebuffer
-struct Pixel
-{
-    unsigned char r, g, b; // Each color is a byte
-};
-
 int main()
 {
-    // Initialize a framebuffer
-    auto framebuffer = new Pixel[SIZE][SIZE];
-
-    std::ifstream inputFile("lena.raw", std::ios::binary);
-    if (!inputFile)
+    // Load the framebuffer
+    ppgso::Image framebuffer{0, 0};
+    try
+    {
+        framebuffer = ppgso::image::loadRAW("lena.raw", SIZE, SIZE);
+    }
+    catch (std::exception& e)
     {
-        std::cerr << "Error: Unable to open lena.raw" << std::endl;
-        delete[] framebuffer;
+        std::cerr << "Error: " << e.what() << std::endl;
         return EXIT_FAILURE;
     }
 
-    inputFile.read(reinterpret_cast<char*>(framebuffer), SIZE * SIZE * sizeof(Pixel));
-    inputFile.close();
+    // Inverting colors, 1 - color expressed as a color matrix transform
+    auto result = ppgso::image::colorMatrix(framebuffer, glm::mat3{-1.0f}, glm::vec3{1.0f});
 
-    // Traverse the framebuffer
-    for (unsigned int y = 0; y < SIZE; y++)
+    std::cout << "Generating result.raw file ..." << std::endl;
+
+    try
     {
-        for (unsigned int x = 0; x < SIZE; x++)
-        {
-            // Inverting colors
-            framebuffer[y][x].r = 255 - framebuffer[y][x].r;
-            framebuffer[y][x].g = 255 - framebuffer[y][x].g;
-            framebuffer[y][x].b = 255 - framebuffer[y][x].b;
-        }
+        ppgso::image::saveRAW(result, "result.raw");
     }
-
-    std::ofstream outputFile("result.raw", std::ios::binary);
-    if (!outputFile)
+    catch (std::exception& e)
     {
-        std::cerr << "Error: Unable to open result.raw" << std::endl;
-        delete[] framebuffer;
+        std::cerr << "Error: " << e.what() << std::endl;
         return EXIT_FAILURE;
     }
 
-    std::cout << "Generating result.raw file ..." << std::endl;
-
-    // TODO: Write the framebuffer to the file and close it
-    outputFile.write(reinterpret_cast<const char*>(framebuffer), SIZE * SIZE * sizeof(Pixel));
-    outputFile.close();
-
     std::cout << "Done." << std::endl;
-    delete[] framebuffer;
     return EXIT_SUCCESS;
 }